@@ -0,0 +1,406 @@
+//
+// Created by agent on 2026/10/17.
+//
+// glrender主机基准测试，使用Mesa的surfaceless EGL，不需要设备与窗口系统
+// 按分辨率 x 模糊 x 变换模式 x 帧数扫描，每帧为UpdateFrame + Draw + GetData，
+// 每个组合输出一行结果，默认JSON Lines，--csv输出CSV，便于脚本对比回归
+// 指定--blur-radii时每个半径追加一个高斯模糊，按--blur-paths分别使用计算着色器与片元着色器
+// 指定--workers时每个分辨率再按工作线程数测试RenderPool的吞吐（rotate90，帧数即图像数），
+// fps为每秒图像数，没有分阶段耗时，workers为0的行是单上下文结果
+//
+// 用法：glrender_benchmark [--resolutions 720p,1080p,1440p,4k,8k|WxH,...]
+//                          [--modes rotate0,rotate90,rotate180,rotate270,mirror_h,mirror_v]
+//                          [--frames 30,...] [--warmup 2] [--csv]
+//                          [--blur-radii 8,32,...] [--blur-paths compute,fragment]
+//                          [--workers 1,2,4,...]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "render/BgRender.h"
+#include "render/EngineBenchmark.h"
+#include "render/GlesEnv.h"
+#include "myutils.h"
+
+#define TAG "RenderBenchmark"
+
+struct Resolution {
+    std::string name;
+    int width;
+    int height;
+};
+
+struct Mode {
+    const char *name;
+    int rotate;
+    int mirror;
+};
+
+static const Resolution PRESET_RESOLUTIONS[] = {
+        {"720p",  1280, 720},
+        {"1080p", 1920, 1080},
+        {"1440p", 2560, 1440},
+        {"4k",    3840, 2160},
+        {"8k",    7680, 4320},
+};
+
+static const Mode MODES[] = {
+        {"rotate0",   ROTATE_0,   MIRROR_NONE},
+        {"rotate90",  ROTATE_90,  MIRROR_NONE},
+        {"rotate180", ROTATE_180, MIRROR_NONE},
+        {"rotate270", ROTATE_270, MIRROR_NONE},
+        {"mirror_h",  ROTATE_0,   MIRROR_HORIZONTAL},
+        {"mirror_v",  ROTATE_0,   MIRROR_VERTICAL},
+};
+
+// 模糊设置，半径为0时不加滤镜
+struct Blur {
+    int radius;
+    const char *path;
+};
+
+#define BLUR_PATH_NONE "none"
+#define BLUR_PATH_COMPUTE "compute"
+#define BLUR_PATH_FRAGMENT "fragment"
+
+// 渲染池固定的变换，见benchmarkPool
+static const Mode POOL_MODE = {"rotate90", ROTATE_90, MIRROR_NONE};
+
+#define PRESET_COUNT (sizeof(PRESET_RESOLUTIONS) / sizeof(PRESET_RESOLUTIONS[0]))
+#define MODE_COUNT (sizeof(MODES) / sizeof(MODES[0]))
+
+static const char *STAGE_NAMES[STATS_STAGE_COUNT] = {
+        "upload", "draw", "gpu", "readback", "copy"
+};
+
+// 按逗号拆分
+static std::vector<std::string> split(const char *value) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char *c = value; ; c++) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+            item.clear();
+            if (*c == '\0') {
+                break;
+            }
+        } else {
+            item += *c;
+        }
+    }
+    return items;
+}
+
+static bool parseResolution(const std::string &name, Resolution *resolution) {
+    for (const Resolution &preset : PRESET_RESOLUTIONS) {
+        if (preset.name == name) {
+            *resolution = preset;
+            return true;
+        }
+    }
+    int width, height;
+    if (sscanf(name.c_str(), "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+        resolution->name = name;
+        resolution->width = width;
+        resolution->height = height;
+        return true;
+    }
+    return false;
+}
+
+static const Mode *findMode(const std::string &name) {
+    for (const Mode &mode : MODES) {
+        if (name == mode.name) {
+            return &mode;
+        }
+    }
+    return nullptr;
+}
+
+// 渐变图，避免全同像素
+static char *createImage(int width, int height) {
+    size_t pixelCount = (size_t) width * height;
+    char *image = new char[pixelCount * 4];
+    for (size_t i = 0; i < pixelCount; i++) {
+        image[i * 4] = (char) (i % width);
+        image[i * 4 + 1] = (char) (i / width);
+        image[i * 4 + 2] = (char) (i * 7);
+        image[i * 4 + 3] = (char) 255;
+    }
+    return image;
+}
+
+static void printUsage() {
+    fprintf(stderr,
+            "usage: glrender_benchmark [--resolutions 720p,1080p,1440p,4k,8k|WxH,...]\n"
+            "                          [--modes rotate0,rotate90,rotate180,rotate270,mirror_h,mirror_v]\n"
+            "                          [--frames 30,...] [--warmup 2] [--csv]\n"
+            "                          [--blur-radii 8,32,...] [--blur-paths compute,fragment]\n"
+            "                          [--workers 1,2,4,...]\n");
+}
+
+static void printCsvHeader() {
+    printf("resolution,width,height,mode,blur_radius,blur_path,workers,frames,fps,mb_per_s,"
+           "gpu_timer");
+    for (const char *stage : STAGE_NAMES) {
+        printf(",%s_p50_us,%s_p95_us,%s_p99_us", stage, stage, stage);
+    }
+    printf("\n");
+}
+
+static void printResult(bool csv, const Resolution &resolution, const Mode &mode,
+                        const Blur &blur, int workers, int frames, double fps, double mbPerSecond,
+                        const long long *stats) {
+    if (csv) {
+        printf("%s,%d,%d,%s,%d,%s,%d,%d,%.2f,%.2f,%lld", resolution.name.c_str(),
+               resolution.width, resolution.height, mode.name, blur.radius, blur.path, workers,
+               frames, fps, mbPerSecond, stats[STATS_RESULT_GPU_TIMER]);
+        for (int stage = 0; stage < STATS_STAGE_COUNT; stage++) {
+            const long long *fields = stats + STATS_RESULT_STAGES + stage * STATS_FIELD_SIZE;
+            printf(",%lld,%lld,%lld", fields[STATS_FIELD_P50], fields[STATS_FIELD_P95],
+                   fields[STATS_FIELD_P99]);
+        }
+        printf("\n");
+    } else {
+        printf("{\"resolution\":\"%s\",\"width\":%d,\"height\":%d,\"mode\":\"%s\","
+               "\"blur_radius\":%d,\"blur_path\":\"%s\",\"workers\":%d,\"frames\":%d,"
+               "\"fps\":%.2f,\"mb_per_s\":%.2f,\"gpu_timer\":%lld,\"stages_us\":{",
+               resolution.name.c_str(), resolution.width, resolution.height, mode.name,
+               blur.radius, blur.path, workers, frames, fps, mbPerSecond,
+               stats[STATS_RESULT_GPU_TIMER]);
+        for (int stage = 0; stage < STATS_STAGE_COUNT; stage++) {
+            const long long *fields = stats + STATS_RESULT_STAGES + stage * STATS_FIELD_SIZE;
+            printf("%s\"%s\":{\"count\":%lld,\"p50\":%lld,\"p95\":%lld,\"p99\":%lld,\"max\":%lld}",
+                   stage == 0 ? "" : ",", STAGE_NAMES[stage], fields[STATS_FIELD_COUNT],
+                   fields[STATS_FIELD_P50], fields[STATS_FIELD_P95], fields[STATS_FIELD_P99],
+                   fields[STATS_FIELD_MAX]);
+        }
+        printf("}}\n");
+    }
+    fflush(stdout);
+}
+
+/**
+ * 跑一个组合，耗时统计见RenderStats
+ * MB/s按每帧上传的RGBA原图 + 读取的RGBA结果计算
+ *
+ * @return 绘制失败时返回false
+ * */
+static bool runCase(BgRender *render, const Resolution &resolution, const Mode &mode,
+                    const Blur &blur, int frames, int warmup, const char *image,
+                    signed char *output, bool csv) {
+    if (mode.mirror != MIRROR_NONE) {
+        render->SetMirrorType(mode.mirror);
+    } else {
+        render->SetRotate(mode.rotate);
+    }
+    // 预热，变换变化后的第一帧包含FBO重新分配
+    render->SetStatsEnabled(false);
+    for (int i = 0; i < warmup; i++) {
+        render->UpdateFrame(resolution.width, resolution.height, image);
+        render->Draw();
+        render->GetData(output);
+    }
+    render->SetStatsEnabled(true);
+    long long start = currentTimeUs();
+    for (int i = 0; i < frames; i++) {
+        render->UpdateFrame(resolution.width, resolution.height, image);
+        render->Draw();
+        if (!render->GetData(output)) {
+            LOGE(TAG, "GetData fail resolution=%s mode=%s", resolution.name.c_str(), mode.name);
+            return false;
+        }
+    }
+    long long cost = currentTimeUs() - start;
+    long long stats[STATS_RESULT_SIZE];
+    render->GetStats(stats);
+
+    double seconds = cost > 0 ? cost / 1000000.0 : 1e-6;
+    double bytesPerFrame = (double) resolution.width * resolution.height * 4
+                           + (double) render->GetDataSize();
+    printResult(csv, resolution, mode, blur, 0, frames, frames / seconds,
+                bytesPerFrame * frames / seconds / 1000000.0, stats);
+    return true;
+}
+
+/**
+ * 跑一个渲染池组合，RenderPool按工作线程各自的上下文并行处理整张图
+ * 池内不采集分阶段耗时，统计字段为0；MB/s按上传的RGBA原图 + 读取的RGBA结果计算
+ *
+ * @return 工作线程创建失败时返回false
+ * */
+static bool runPoolCase(const Resolution &resolution, int workers, int images, bool csv) {
+    double imagesPerSecond = benchmarkPool(resolution.width, resolution.height, workers, images);
+    if (imagesPerSecond < 0) {
+        LOGE(TAG, "benchmarkPool fail resolution=%s workers=%d", resolution.name.c_str(),
+             workers);
+        return false;
+    }
+    long long stats[STATS_RESULT_SIZE] = {0};
+    Blur blur = {0, BLUR_PATH_NONE};
+    double bytesPerImage = (double) resolution.width * resolution.height * 4 * 2;
+    printResult(csv, resolution, POOL_MODE, blur, workers, images, imagesPerSecond,
+                bytesPerImage * imagesPerSecond / 1000000.0, stats);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::vector<Resolution> resolutions(PRESET_RESOLUTIONS, PRESET_RESOLUTIONS + PRESET_COUNT);
+    std::vector<const Mode *> modes;
+    for (const Mode &mode : MODES) {
+        modes.push_back(&mode);
+    }
+    std::vector<int> frameCounts = {30};
+    int warmup = 2;
+    bool csv = false;
+    std::vector<int> blurRadii;
+    std::vector<const char *> blurPaths = {BLUR_PATH_COMPUTE, BLUR_PATH_FRAGMENT};
+    std::vector<int> workerCounts;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(arg, "--resolutions") == 0 && value != nullptr) {
+            resolutions.clear();
+            for (const std::string &name : split(value)) {
+                Resolution resolution;
+                if (!parseResolution(name, &resolution)) {
+                    fprintf(stderr, "unknown resolution %s\n", name.c_str());
+                    return 2;
+                }
+                resolutions.push_back(resolution);
+            }
+            i++;
+        } else if (strcmp(arg, "--modes") == 0 && value != nullptr) {
+            modes.clear();
+            for (const std::string &name : split(value)) {
+                const Mode *mode = findMode(name);
+                if (mode == nullptr) {
+                    fprintf(stderr, "unknown mode %s\n", name.c_str());
+                    return 2;
+                }
+                modes.push_back(mode);
+            }
+            i++;
+        } else if (strcmp(arg, "--frames") == 0 && value != nullptr) {
+            frameCounts.clear();
+            for (const std::string &count : split(value)) {
+                int frames = atoi(count.c_str());
+                if (frames <= 0) {
+                    fprintf(stderr, "invalid frames %s\n", count.c_str());
+                    return 2;
+                }
+                frameCounts.push_back(frames);
+            }
+            i++;
+        } else if (strcmp(arg, "--blur-radii") == 0 && value != nullptr) {
+            blurRadii.clear();
+            for (const std::string &item : split(value)) {
+                int radius = atoi(item.c_str());
+                if (radius <= 0 || radius > FILTER_MAX_RADIUS) {
+                    fprintf(stderr, "invalid blur radius %s\n", item.c_str());
+                    return 2;
+                }
+                blurRadii.push_back(radius);
+            }
+            i++;
+        } else if (strcmp(arg, "--blur-paths") == 0 && value != nullptr) {
+            blurPaths.clear();
+            for (const std::string &path : split(value)) {
+                if (path == BLUR_PATH_COMPUTE) {
+                    blurPaths.push_back(BLUR_PATH_COMPUTE);
+                } else if (path == BLUR_PATH_FRAGMENT) {
+                    blurPaths.push_back(BLUR_PATH_FRAGMENT);
+                } else {
+                    fprintf(stderr, "unknown blur path %s\n", path.c_str());
+                    return 2;
+                }
+            }
+            i++;
+        } else if (strcmp(arg, "--workers") == 0 && value != nullptr) {
+            workerCounts.clear();
+            for (const std::string &count : split(value)) {
+                int workers = atoi(count.c_str());
+                if (workers <= 0) {
+                    fprintf(stderr, "invalid workers %s\n", count.c_str());
+                    return 2;
+                }
+                workerCounts.push_back(workers);
+            }
+            i++;
+        } else if (strcmp(arg, "--warmup") == 0 && value != nullptr) {
+            warmup = atoi(value);
+            warmup = warmup < 0 ? 0 : warmup;
+            i++;
+        } else {
+            printUsage();
+            return strcmp(arg, "--help") == 0 ? 0 : 2;
+        }
+    }
+    if (resolutions.empty() || modes.empty() || frameCounts.empty() || blurPaths.empty()) {
+        printUsage();
+        return 2;
+    }
+    std::vector<Blur> blurs;
+    if (blurRadii.empty()) {
+        blurs.push_back({0, BLUR_PATH_NONE});
+    }
+    for (int radius : blurRadii) {
+        for (const char *path : blurPaths) {
+            blurs.push_back({radius, path});
+        }
+    }
+
+    if (csv) {
+        printCsvHeader();
+    }
+    int failCount = 0;
+    for (const Resolution &resolution : resolutions) {
+        char *image = createImage(resolution.width, resolution.height);
+        signed char *output = new signed char[(size_t) resolution.width * resolution.height * 4];
+        // 每个分辨率一个渲染器，组合之间只切换变换
+        BgRender *render = new BgRender(resolution.width, resolution.height, image);
+        if (render->CreateGlesEnv()) {
+            render->SetEngine(ENGINE_GPU);
+            for (const Blur &blur : blurs) {
+                render->ClearFilters();
+                if (blur.radius > 0) {
+                    float params[] = {(float) blur.radius, 0.0f};
+                    render->AddFilter(FILTER_GAUSSIAN_BLUR, params, 2);
+                    render->SetFilterComputeEnabled(strcmp(blur.path, BLUR_PATH_COMPUTE) == 0);
+                }
+                for (const Mode *mode : modes) {
+                    for (int frames : frameCounts) {
+                        if (!runCase(render, resolution, *mode, blur, frames, warmup, image,
+                                     output, csv)) {
+                            failCount++;
+                        }
+                    }
+                }
+            }
+        } else {
+            LOGE(TAG, "CreateGlesEnv fail resolution=%s", resolution.name.c_str());
+            failCount++;
+        }
+        render->DestroyGlesEnv();
+        delete render;
+        delete[] output;
+        delete[] image;
+        for (int workers : workerCounts) {
+            for (int frames : frameCounts) {
+                if (!runPoolCase(resolution, workers, frames, csv)) {
+                    failCount++;
+                }
+            }
+        }
+    }
+    GlesEnv::Terminate();
+    return failCount == 0 ? 0 : 1;
+}
@@ -2,8 +2,13 @@
 // Created by 龚健飞 on 2021/5/20.
 //
 
+#ifdef __ANDROID__
 #include <android/log.h>
 #include <jni.h>
+#else
+#include <stdio.h>
+#endif
+#include <time.h>
 
 #ifndef GLLEARNING_MYUTILS_H
 #define GLLEARNING_MYUTILS_H
@@ -14,13 +19,23 @@
 
 #endif
 
-#if LOG_ENABLE
+#if LOG_ENABLE && defined(__ANDROID__)
 
 #define LOGD(TAG, args...) __android_log_print(ANDROID_LOG_DEBUG, TAG, ##args)
 #define LOGI(TAG, args...) __android_log_print(ANDROID_LOG_INFO, TAG, ##args)
 #define LOGW(TAG, args...) __android_log_print(ANDROID_LOG_WARN, TAG, ##args)
 #define LOGE(TAG, args...) __android_log_print(ANDROID_LOG_ERROR, TAG, ##args)
 
+#elif LOG_ENABLE
+
+// 主机构建（如基准测试）输出到stderr，LOGD每帧都有，会影响计时，不输出
+#define HOST_LOG(LEVEL, TAG, args...) \
+    (fprintf(stderr, "%s/%s: ", LEVEL, TAG), fprintf(stderr, args), fputc('\n', stderr))
+#define LOGD(TAG, args...)
+#define LOGI(TAG, args...) HOST_LOG("I", TAG, ##args)
+#define LOGW(TAG, args...) HOST_LOG("W", TAG, ##args)
+#define LOGE(TAG, args...) HOST_LOG("E", TAG, ##args)
+
 #else
 
 #define LOGD(TAG, args...)
@@ -32,6 +47,15 @@
 
 #define MY_UTILS_TAG  "myUtils"
 
+// 单调时钟，单位微秒，用于统计耗时
+static inline long long currentTimeUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+#ifdef __ANDROID__
+
 // 动态注册jni函数
 static int registerNativeMethods(JNIEnv *env, const char *className, JNINativeMethod *methods,
                                  int numMethods) {
@@ -49,5 +73,7 @@ static int registerNativeMethods(JNIEnv *env, const char *className, JNINativeMe
     return JNI_TRUE;
 }
 
+#endif
+
 
 #endif //GLLEARNING_MYUTILS_H
@@ -10,124 +10,214 @@
 #include <GLES3/gl3ext.h>
 #include <GLES3/gl3platform.h>
 #include "myutils.h"
+#include <cmath>
 #include <cstring>
 #include <cstdio>
+#include <string>
 
 #define TAG "BgRender"
 
-BgRender::BgRender(unsigned int width, unsigned int height, const char *imageData) {
-    LOGD(TAG, "BgRender constructor width=%d height=%d", width, height);
+// GLSL语言基础 https://my.oschina.net/sweetdark/blog/208024
+// 顶点着色器 shader
+static const char *FBO_VERTEX_SHADER =
+        "#version 300 es                            \n"  // 声明使用OpenGLES 3.0
+        "layout(location = 0) in vec4 a_position;   \n"  // 声明输入四维向量
+        "layout(location = 1) in vec2 a_texCoord;   \n"  // 声明输入二维向量
+        "uniform mat3 u_texMatrix;                  \n"  // 采样坐标变换，旋转、镜像、裁剪、缩放
+        "out vec2 v_texCoord;                       \n"  // 声明输出二维向量，纹理坐标
+        "void main()                                \n"
+        "{                                          \n"
+        "   gl_Position = a_position;               \n"  // 内建变量赋值，不需要变换，gl_Position描述三维空间里变换后的位置
+        "   v_texCoord = (u_texMatrix * vec3(a_texCoord, 1.0)).xy; \n"  // 输出向量赋值，变换后的纹理坐标
+        "}                                          \n";
+
+// 用于FBO渲染的片段着色器shader，取每个像素的灰度值
+// 中间插入InputTexture::GetSampleFunction，声明输入纹理并提供sampleSource，YUV输入在其中转换为RGB
+static const char *FBO_FRAGMENT_SHADER_HEAD =
+        "#version 300 es                            \n"
+        "precision mediump float;                   \n"  // 设置默认的精度限定符
+        "in vec2 v_texCoord;                        \n"  // 导入纹理坐标，描述片段
+        "layout(location = 0) out vec4 outColor;    \n";  // 提供片段着色器输出变量的声明，这将是传递到下一阶段的颜色
+
+static const char *FBO_FRAGMENT_SHADER_MAIN =
+        "void main()                                \n"
+        "{                                          \n"
+        "    vec4 tempColor = sampleSource(v_texCoord);   \n" // 通过纹理和纹理坐标采样颜色值
+        "    float luminance = tempColor.r * 0.299 + tempColor.g * 0.587 + tempColor.b * 0.114;  \n"
+        "    outColor = vec4(vec3(luminance), 1.0);         \n"
+        "}";
+
+// 多输出的片段着色器，两个输出分别对应颜色附着0、1，中间同样插入sampleSource
+static const char *MULTI_FRAGMENT_SHADER_HEAD =
+        "#version 300 es\n"
+        "precision mediump float;\n"
+        "in vec2 v_texCoord;\n"
+        "layout(location = 0) out vec4 outColor;\n"
+        // R8附着只保留r分量
+        "layout(location = 1) out vec4 outGray;\n";
+
+static const char *MULTI_FRAGMENT_SHADER_MAIN =
+        "void main()\n"
+        "{\n"
+        "    vec4 color = sampleSource(v_texCoord);\n"
+        "    outColor = color;\n"
+        "    outGray = vec4(vec3(dot(color.rgb, vec3(0.299, 0.587, 0.114))), 1.0);\n"
+        "}\n";
+
+BgRender::BgRender(unsigned int width, unsigned int height, const char *imageData, int format) {
+    LOGD(TAG, "BgRender constructor width=%d height=%d format=%d", width, height, format);
     mWidth = width;
     mHeight = height;
-    mEglDisplay = nullptr;
-    mEglConfig = nullptr;
-    mEglSurface = nullptr;
-    mEglContext = nullptr;
+    mEnv = nullptr;
     mFboTextureId = 0;
-    mTextureId = 0;
+    mInput = new InputTexture();
+    mTileInput = nullptr;
+    mImageFormat = format;
+    mProgramFormat = IMAGE_FORMAT_RGBA;
     mFboId = 0;
     mFboProgramId = 0;
-    mVertexShader = 0;
-    mFragmentShader = 0;
     mVboIds = new GLuint[3];
     mVaoId = 0;
-    mImageRawData = new GLbyte[width * height * 4];
-    memcpy((void *) mImageRawData, imageData, width * height * 4);
+    // 不再拷贝原图，CreateGlesEnv时直接从调用方的内存上传纹理
+    mImageRawData = (const GLbyte *) imageData;
 //    FILE* file = fopen("/sdcard/test.raw", "w");
 //    fwrite(mImageRawData, sizeof(char), mWidth * mHeight * 4, file);
 //    fflush(file);
 //    fclose(file);
-    mDrawData = new GLbyte[width * height * 4];
+    // 只有Draw+GetData的读取方式才需要，第一次Draw时再分配
+    mDrawData = nullptr;
+    mDrawDataSize = 0;
+    mPboReader = nullptr;
+    mAcquiredEnv = false;
+    mOutputFormat = IMAGE_FORMAT_RGBA;
+    mYuvPacker = nullptr;
+    mBlankDetector = nullptr;
+    mMotionDetector = nullptr;
+    mOverlay = nullptr;
+    mDownscaler = nullptr;
+    mScaleQuality = SCALE_QUALITY_BILINEAR;
+    mInputHash = 0;
+    mInputHashed = false;
+    mStats = nullptr;
+    mFilterChain = nullptr;
+    mCpuRender = new CpuRender();
+    mEngine = ENGINE_AUTO;
+    mCpuThreshold = DEFAULT_CPU_THRESHOLD;
+    mLastEngine = ENGINE_GPU;
+    mRotate = ROTATE_0;
+    mMirror = MIRROR_NONE;
+    mCropX = 0;
+    mCropY = 0;
+    mCropWidth = 0;
+    mCropHeight = 0;
+    texTransformIdentity(mAffine);
+    mUseAffine = false;
+    mRequestWidth = -1;
+    mRequestHeight = -1;
+    mFboWidth = 0;
+    mFboHeight = 0;
+    mFboGrowOnly = false;
+    mBatchPboId = 0;
+    mBatchPboSize = 0;
+    mGrayTextureId = 0;
+    mGrayWidth = 0;
+    mGrayHeight = 0;
+    mPreviewTextureId = 0;
+    mPreviewFboId = 0;
+    mPreviewWidth = 0;
+    mPreviewHeight = 0;
+    mMultiProgramId = 0;
+    mMultiProgramFormat = -1;
+    mMultiTexMatrixLoc = -1;
+    mTexMatrixLoc = -1;
 }
 
 BgRender::~BgRender() {
     LOGD(TAG, "BgRender un constructor");
+    delete mStats;
+    delete mCpuRender;
+    delete mInput;
+    delete mTileInput;
+    // 未调用DestroyGlesEnv时也归还CPU内存
+    delete[] mVboIds;
+    BufferPool::Get()->Free(mDrawData);
 }
 
-// 创建 GLES 环境，一般步骤如下：
-// 1. 获取 EGLDisplay 对象，建立与本地窗口系统的连接
-//        调用 eglGetDisplay 方法得到 EGLDisplay。
-// 2. 初始化 EGL 方法
-//        打开连接之后，调用 eglInitialize 方法初始化。
-// 3. 获取 EGLConfig 对象，确定渲染表面的配置信息
-//        调用 eglChooseConfig 方法得到 EGLConfig。
-// 4. 创建渲染表面 EGLSurface
-//        通过 EGLDisplay 和 EGLConfig ，调用 eglCreateWindowSurface 或 eglCreatePbufferSurface 方法创建渲染表面，得到 EGLSurface，其中 eglCreateWindowSurface 用于创建屏幕上渲染区域，eglCreatePbufferSurface 用于创建屏幕外渲染区域。
-// 5. **创建渲染上下文 EGLContext **
-//        通过 EGLDisplay 和 EGLConfig ，调用 eglCreateContext 方法创建渲染上下文，得到 EGLContext。
-// 6. 绑定上下文
-//        通过 eglMakeCurrent 方法将 EGLSurface、EGLContext、EGLDisplay 三者绑定，绑定成功之后 OpenGLES 环境就创建好了，接下来便可以进行渲染。
-// 7. 交换缓冲
-//        OpenGLES 绘制结束后，使用 eglSwapBuffers 方法交换前后缓冲，将绘制内容显示到屏幕上，而屏幕外的渲染不需要调用此方法。
-// 8. 释放 EGL 环境
-//        绘制结束后，不再需要使用 EGL 时，需要取消 eglMakeCurrent 的绑定，销毁 EGLDisplay、EGLSurface、EGLContext 三个对象。
-void BgRender::CreateGlesEnv() {
-    LOGD(TAG, "CreateGlesEnv");
-    // EGL config 属性
-    const EGLint confAttr[] = {
-            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
-            // EGL_WINDOW_BIT EGL_PBUFFER_BIT we will create a pixelbuffer surface
-            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
-            EGL_RED_SIZE, 8,
-            EGL_GREEN_SIZE, 8,
-            EGL_BLUE_SIZE, 8,
-            EGL_ALPHA_SIZE, 8,// if you need the alpha channel
-            EGL_DEPTH_SIZE, 8,// if you need the depth buffer
-            EGL_STENCIL_SIZE, 8,
-            EGL_NONE
-    };
-
-    // EGL context 属性
-    const EGLint ctxAttr[] = {
-            EGL_CONTEXT_CLIENT_VERSION, 2, // 使用EGL 2.0
-            EGL_NONE
-    };
-
-    // surface 属性
-    // the surface size is set to the input frame size
-    const EGLint surfaceAttr[] = {
-            EGL_WIDTH, 1,
-            EGL_HEIGHT, 1,
-            EGL_NONE
-    };
-
-    EGLint eglMajVers, eglMinVers; // 版本信息
-    EGLint numConfigs;
-
-    // 1.获取EGLDisplay对象，建立与本地窗口系统的连接
-    mEglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    LOGD(TAG, "mEglDisplay == EGL_NO_DISPLAY ? %d", (mEglDisplay == EGL_NO_DISPLAY));
-
-    // 2. 初始化 EGL 方法
-    EGLBoolean ret = eglInitialize(mEglDisplay, &eglMajVers, &eglMinVers);
-    LOGD(TAG, "eglInitialize ret=%d, eglMajVers=%d, eglMinVers=%d", ret, eglMajVers, eglMinVers);
-
-    // 3. 获取EGLConfig对象，确定渲染表面的配置信息
-    ret = eglChooseConfig(mEglDisplay, confAttr, &mEglConfig, 1, &numConfigs);
-    LOGD(TAG, "eglChooseConfig ret=%d, numConfigs=%d", ret, numConfigs);
-
-    // 4. 创建渲染表面EGLSurface，使用eglCreatePbufferSurface创建屏幕外渲染区域
-    mEglSurface = eglCreatePbufferSurface(mEglDisplay, mEglConfig, surfaceAttr);
-    LOGD(TAG, "mEglSurface == EGL_NO_SURFACE ? %d eglError=%d", (mEglSurface == EGL_NO_SURFACE),
-         eglGetError());
-
-    // 5. 创建渲染上下文 EGLContext
-    mEglContext = eglCreateContext(mEglDisplay, mEglConfig, EGL_NO_CONTEXT, ctxAttr);
-    LOGD(TAG, "mEglContext == EGL_NO_CONTEXT ? %d eglError=%d", (mEglContext == EGL_NO_CONTEXT),
-         eglGetError());
-
-    // 6. 绑定上下文
-    ret = eglMakeCurrent(mEglDisplay, mEglSurface, mEglSurface, mEglContext);
-    LOGD(TAG, "eglMakeCurrent ret=%d, eglError=%d", ret, eglGetError());
-
+// 创建 GLES 环境，EGL的创建流程见GlesEnv::create
+// 同一进程内只有第一个BgRender会真正初始化EGL，之后的实例直接复用上下文与已链接的程序
+bool BgRender::CreateGlesEnv(GlesEnv *env) {
+    LOGD(TAG, "CreateGlesEnv env=%p", env);
+    // 未指定时使用进程内共享的环境，否则使用调用方的工作上下文，不计入引用
+    mAcquiredEnv = env == nullptr;
+    mEnv = mAcquiredEnv ? GlesEnv::Acquire() : env;
+    hashInput((const char *) mImageRawData, mImageFormat, mWidth, mHeight);
+    // 小图或没有GL环境时保留原图给CPU引擎
+    keepCpuFrame((const char *) mImageRawData);
+    if (mEnv == nullptr) {
+        LOGE(TAG, "CreateGlesEnv acquire env fail, fallback to cpu");
+        mImageRawData = nullptr;
+        return false;
+    }
+    // 上传原图，YUV格式按平面分别上传
+    // 只用DrawTiled时可以不传原图，超过GL_MAX_TEXTURE_SIZE的长图也不会分配整图纹理
+    if (mImageRawData != nullptr
+        && !mInput->Upload(mImageFormat, mWidth, mHeight, mImageRawData)) {
+        mImageRawData = nullptr;
+        return false;
+    }
     createFBO();
     initShader();
+    mFilterChain = new FilterChain(mEnv);
+    mYuvPacker = new YuvPacker(mEnv);
+    mYuvPacker->SetColorSpace(mInput->GetStandard(), mInput->IsFullRange());
+    mBlankDetector = new BlankDetector(mEnv);
+    mMotionDetector = new MotionDetector(mEnv);
+    mOverlay = new OverlayCompositor(mEnv);
+    mDownscaler = new Downscaler(mEnv);
+    // 纹理已上传，调用方的内存之后可能失效，不再持有
+    mImageRawData = nullptr;
+    return mFboProgramId != 0;
 }
 
-// 渲染
-void BgRender::Draw() {
-    LOGD(TAG, "Draw");
-    glViewport(0, 0, mWidth, mHeight);
+// 渲染到FBO，结束时FBO保持绑定，供后续读取
+void BgRender::render() {
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    int width, height;
+    computeTransform(transform, &width, &height);
+    renderScaled(mInput, transform, width, height, mScaleQuality);
+    if (mOverlay != nullptr && !mOverlay->IsEmpty()) {
+        int outWidth, outHeight;
+        mFilterChain->GetOutputSize(width, height, &outWidth, &outHeight);
+        mOverlay->Draw(mFboId, 0, 0, outWidth, outHeight);
+    }
+}
+
+void BgRender::renderScaled(InputTexture *input, const GLfloat *transform, int width, int height,
+                            int quality) {
+    if (quality != SCALE_QUALITY_BILINEAR) {
+        // 重采样结果已经过变换，之后的滤镜或灰度按1:1采样
+        InputTexture *scaled = mDownscaler->Resample(input, transform, width, height, quality);
+        if (scaled != nullptr) {
+            GLfloat identity[TEX_TRANSFORM_SIZE];
+            texTransformIdentity(identity);
+            renderInput(scaled, identity, width, height);
+            return;
+        }
+    }
+    renderInput(input, transform, width, height);
+}
+
+void BgRender::renderInput(InputTexture *input, const GLfloat *transform, int width, int height) {
+    ensureFboSize(width, height);
+    if (mFilterChain != nullptr && !mFilterChain->IsEmpty()) {
+        // 滤镜链自行管理中间FBO，第一趟带上变换，最后一趟写入mFboId
+        mFilterChain->Render(input, transform, width, height, mFboId);
+        glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+        return;
+    }
+    // 先绑定FBO再清空，当前绑定的可能是上一步（如重采样）的结果
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+    glViewport(0, 0, width, height);
 
     // 以rgba来清空缓冲区当前的所有颜色
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -135,19 +225,22 @@ void BgRender::Draw() {
     // 清除颜色缓冲区
     glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
 
+    if (mProgramFormat != input->GetFormat()) {
+        loadProgram(input->GetFormat());
+    }
     // 使用程序
     glUseProgram(mFboProgramId);
-    // 绑定FBO
-    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
-    // 激活纹理单元
-    glActiveTexture(GL_TEXTURE0);
+    // 旋转、镜像、裁剪、缩放都在采样坐标上完成
+    GLfloat matrix[9];
+    texTransformToMat3(transform, matrix);
+    glUniformMatrix3fv(mTexMatrixLoc, 1, GL_FALSE, matrix);
+    // 激活纹理单元并绑定输入纹理，YUV格式会用到多个纹理单元
+    input->Bind(mFboProgramId);
 //    // 绑定纹理ID
 //    glBindTexture(GL_TEXTURE_2D, mFboTextureId);
 //    // 上传纹理
 //    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
 //                 mImageRawData);
-
-    glBindTexture(GL_TEXTURE_2D, mTextureId);
     LOGD(TAG, "glBindTexture GL_TEXTURE_2D error=%d", glGetError());
     // 绑定VAO
     glBindVertexArray(mVaoId);
@@ -155,77 +248,1206 @@ void BgRender::Draw() {
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const void *) 0);
     LOGD(TAG, "glDrawElements error=%d", glGetError());
 
+    // 解绑
+    glBindVertexArray(GL_NONE);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+}
+
+// 渲染
+void BgRender::Draw() {
+    LOGD(TAG, "Draw");
+    bool cpu = useCpu();
+    if (!cpu && mEnv == nullptr) {
+        LOGE(TAG, "Draw output format=%d needs gpu", mOutputFormat);
+        return;
+    }
     // 读取渲染好的数据
-    glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, mDrawData);
+    void *addr = nullptr;
+    if (cpu || mPboReader == nullptr) {
+        if (mDrawData == nullptr || mDrawDataSize != GetDataSize()) {
+            // 同一档位的缓冲区在实例间复用，尺寸变化时不直接还给系统
+            BufferPool::Get()->Free(mDrawData);
+            mDrawDataSize = GetDataSize();
+            mDrawData = (GLbyte *) BufferPool::Get()->Alloc(mDrawDataSize);
+        }
+        if (mDrawData == nullptr) {
+            LOGE(TAG, "Draw alloc %d bytes over memory budget", mDrawDataSize);
+            mDrawDataSize = 0;
+            return;
+        }
+        addr = mDrawData;
+    }
+    // 异步读取到PBO时addr为nullptr，不阻塞，GetData时再取
+    drawCached(cpu, addr);
 
 //    char *print = new char [mWidth * mHeight * 4];
 //    memcpy(print, mDrawData, mWidth * mHeight * 4);
 //    print[mWidth * mHeight * 4 -1] = '\0';
 //    LOGD(TAG, "glReadPixels str=%s", print);
+}
 
-    // 解绑
+// 渲染并直接读取到调用方内存，没有中间缓冲区
+void BgRender::DrawTo(const signed char *addr) {
+    LOGD(TAG, "DrawTo");
+    bool cpu = useCpu();
+    if (!cpu && mEnv == nullptr) {
+        LOGE(TAG, "DrawTo output format=%d needs gpu", mOutputFormat);
+        return;
+    }
+    drawCached(cpu, (void *) addr);
+}
+
+void BgRender::drawCached(bool cpu, void *addr) {
+    unsigned long long key = 0;
+    int size = GetDataSize();
+    bool cached = addr != nullptr && resultKey(cpu, &key);
+    if (cached && ResultCache::Get()->Lookup(key, addr, size)) {
+        LOGD(TAG, "drawCached hit key=%llx", key);
+        return;
+    }
+    if (cpu) {
+        renderCpu((uint8_t *) addr);
+    } else {
+        renderAndRead(addr);
+    }
+    if (cached) {
+        ResultCache::Get()->Insert(key, addr, size);
+    }
+}
+
+void BgRender::hashInput(const char *imageData, int format, unsigned int width,
+                         unsigned int height) {
+    // 未开启缓存时不读一遍原图，之后开启的缓存只对新输入生效
+    mInputHashed = imageData != nullptr && ResultCache::Get()->IsEnabled();
+    if (mInputHashed) {
+        mInputHash = ResultCache::Hash(imageData, InputTexture::GetDataSize(format, width, height));
+    }
+}
+
+bool BgRender::resultKey(bool cpu, unsigned long long *key) {
+    if (!mInputHashed || mPboReader != nullptr || (mOverlay != nullptr && !mOverlay->IsEmpty())
+        || !ResultCache::Get()->IsEnabled()) {
+        // 异步读取的结果不经过调用方内存；叠加图像在图集中，内容无法参与key
+        return false;
+    }
+    // 全部为4字节成员，没有填充字节
+    struct {
+        GLfloat transform[TEX_TRANSFORM_SIZE];
+        int width;
+        int height;
+        int imageFormat;
+        int imageWidth;
+        int imageHeight;
+        int outputFormat;
+        int scaleQuality;
+        int standard;
+        int fullRange;
+        // CPU与GPU引擎的舍入不完全相同
+        int engine;
+    } params;
+    computeTransform(params.transform, &params.width, &params.height);
+    params.imageFormat = mImageFormat;
+    params.imageWidth = mWidth;
+    params.imageHeight = mHeight;
+    params.outputFormat = mOutputFormat;
+    params.scaleQuality = mScaleQuality;
+    params.standard = mInput->GetStandard();
+    params.fullRange = mInput->IsFullRange() ? 1 : 0;
+    params.engine = cpu ? ENGINE_CPU : ENGINE_GPU;
+    unsigned long long seed = mFilterChain != nullptr ? mFilterChain->Hash(mInputHash) : mInputHash;
+    *key = ResultCache::Hash(&params, sizeof(params), seed);
+    return true;
+}
+
+void BgRender::renderAndRead(void *addr) {
+    if (mStats != nullptr) {
+        mStats->BeginGpu();
+    }
+    long long begin = statsBegin();
+    render();
+    statsEnd(STATS_STAGE_DRAW, begin);
+    if (mStats != nullptr) {
+        mStats->EndGpu();
+    }
+    begin = statsBegin();
+    readOutput(addr);
+    statsEnd(STATS_STAGE_READBACK, begin);
+}
+
+long long BgRender::statsBegin() {
+    return mStats != nullptr ? currentTimeUs() : 0;
+}
+
+void BgRender::statsEnd(int stage, long long begin) {
+    if (mStats != nullptr) {
+        mStats->Add(stage, currentTimeUs() - begin);
+    }
+}
+
+// 分块最小边长，避免缩小后块数过多
+#define MIN_TILE_SIZE 64
+// 原图区域向外多取的像素，双线性插值与第一趟锐化各需1个
+#define TILE_SOURCE_PADDING 2
+
+bool BgRender::DrawTiled(unsigned int width, unsigned int height, const char *imageData,
+                         const signed char *addr, long long capacity, int tileSize) {
+    LOGD(TAG, "DrawTiled width=%d height=%d tileSize=%d", width, height, tileSize);
+    if (mEnv == nullptr || mFboId == 0) {
+        LOGE(TAG, "DrawTiled needs gpu");
+        return false;
+    }
+    if (mOutputFormat != IMAGE_FORMAT_RGBA) {
+        LOGE(TAG, "DrawTiled output format=%d not supported", mOutputFormat);
+        return false;
+    }
+    // 变换按本图尺寸计算，结束后恢复当前帧的尺寸
+    unsigned int frameWidth = mWidth;
+    unsigned int frameHeight = mHeight;
+    mWidth = width;
+    mHeight = height;
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    int outWidth, outHeight;
+    computeTransform(transform, &outWidth, &outHeight);
+    mWidth = frameWidth;
+    mHeight = frameHeight;
+
+    int filterWidth, filterHeight;
+    mFilterChain->GetOutputSize(outWidth, outHeight, &filterWidth, &filterHeight);
+    if (filterWidth != outWidth || filterHeight != outHeight) {
+        LOGE(TAG, "DrawTiled crop filter not supported");
+        return false;
+    }
+    if ((long long) outWidth * outHeight * 4 > capacity) {
+        LOGE(TAG, "DrawTiled capacity=%lld < %dx%d", capacity, outWidth, outHeight);
+        return false;
+    }
+
+    // 每个输出像素对应的原图像素数，缩小时原图区域比输出块大
+    double spanX = (fabs(transform[0]) / outWidth + fabs(transform[1]) / outHeight) * width;
+    double spanY = (fabs(transform[3]) / outWidth + fabs(transform[4]) / outHeight) * height;
+    double span = spanX > spanY ? spanX : spanY;
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    int halo = mFilterChain->GetHaloSize();
+    int tile = tileSize > 0 ? tileSize : DEFAULT_TILE_SIZE;
+    if (tile > maxTextureSize - 2 * halo) {
+        tile = maxTextureSize - 2 * halo;
+    }
+    while (tile > MIN_TILE_SIZE
+           && (tile + 2 * halo) * span + 2 * TILE_SOURCE_PADDING + 1 > maxTextureSize) {
+        tile /= 2;
+    }
+    if (mTileInput == nullptr) {
+        mTileInput = new InputTexture();
+    }
+
+    const char *bytes = imageData;
+    for (int tileY = 0; tileY < outHeight; tileY += tile) {
+        for (int tileX = 0; tileX < outWidth; tileX += tile) {
+            int tileWidth = tile < outWidth - tileX ? tile : outWidth - tileX;
+            int tileHeight = tile < outHeight - tileY ? tile : outHeight - tileY;
+            // 渲染区域向外扩展滤镜邻域，限制在图像内，图像边缘的行为与整图渲染一致
+            int renderX = tileX - halo > 0 ? tileX - halo : 0;
+            int renderY = tileY - halo > 0 ? tileY - halo : 0;
+            int renderRight = tileX + tileWidth + halo < outWidth ? tileX + tileWidth + halo : outWidth;
+            int renderBottom = tileY + tileHeight + halo < outHeight
+                               ? tileY + tileHeight + halo : outHeight;
+            int renderWidth = renderRight - renderX;
+            int renderHeight = renderBottom - renderY;
+
+            // 渲染区域四个角映射到原图像素，取包围盒，双精度避免长图坐标的精度损失
+            double minX = width, minY = height, maxX = 0, maxY = 0;
+            for (int corner = 0; corner < 4; corner++) {
+                double u = (double) (corner % 2 == 0 ? renderX : renderRight) / outWidth;
+                double v = (double) (corner / 2 == 0 ? renderY : renderBottom) / outHeight;
+                double x = (transform[0] * u + transform[1] * v + transform[2]) * width;
+                double y = (transform[3] * u + transform[4] * v + transform[5]) * height;
+                minX = x < minX ? x : minX;
+                maxX = x > maxX ? x : maxX;
+                minY = y < minY ? y : minY;
+                maxY = y > maxY ? y : maxY;
+            }
+            int sourceX = (int) floor(minX) - TILE_SOURCE_PADDING;
+            int sourceY = (int) floor(minY) - TILE_SOURCE_PADDING;
+            int sourceRight = (int) ceil(maxX) + TILE_SOURCE_PADDING;
+            int sourceBottom = (int) ceil(maxY) + TILE_SOURCE_PADDING;
+            // 限制在原图内，且至少1个像素（仿射变换可能映射到原图之外）
+            sourceX = sourceX < 0 ? 0 : (sourceX >= (int) width ? width - 1 : sourceX);
+            sourceY = sourceY < 0 ? 0 : (sourceY >= (int) height ? height - 1 : sourceY);
+            sourceRight = sourceRight > (int) width ? width : sourceRight;
+            sourceBottom = sourceBottom > (int) height ? height : sourceBottom;
+            sourceRight = sourceRight <= sourceX ? sourceX + 1 : sourceRight;
+            sourceBottom = sourceBottom <= sourceY ? sourceY + 1 : sourceBottom;
+            int sourceWidth = sourceRight - sourceX;
+            int sourceHeight = sourceBottom - sourceY;
+
+            // 按原图行宽跨行读取，直接从调用方内存上传该区域
+            long long begin = statsBegin();
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+            mTileInput->Upload(IMAGE_FORMAT_RGBA, sourceWidth, sourceHeight,
+                               bytes + ((size_t) sourceY * width + sourceX) * 4);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            statsEnd(STATS_STAGE_UPLOAD, begin);
+
+            // 块内坐标 -> 整图输出坐标 -> 原图坐标 -> 区域纹理坐标
+            double scaleU = (double) renderWidth / outWidth;
+            double scaleV = (double) renderHeight / outHeight;
+            double offsetU = (double) renderX / outWidth;
+            double offsetV = (double) renderY / outHeight;
+            GLfloat tileTransform[TEX_TRANSFORM_SIZE];
+            for (int row = 0; row < 2; row++) {
+                const GLfloat *m = transform + row * 3;
+                double size = row == 0 ? width : height;
+                double origin = row == 0 ? sourceX : sourceY;
+                double extent = row == 0 ? sourceWidth : sourceHeight;
+                tileTransform[row * 3] = (GLfloat) (m[0] * scaleU * size / extent);
+                tileTransform[row * 3 + 1] = (GLfloat) (m[1] * scaleV * size / extent);
+                tileTransform[row * 3 + 2] = (GLfloat) (
+                        ((m[0] * offsetU + m[1] * offsetV + m[2]) * size - origin) / extent);
+            }
+
+            if (mStats != nullptr) {
+                mStats->BeginGpu();
+            }
+            begin = statsBegin();
+            renderInput(mTileInput, tileTransform, renderWidth, renderHeight);
+            // 叠加图层按输出坐标画到本块
+            if (!mOverlay->IsEmpty()) {
+                mOverlay->Draw(mFboId, renderX, renderY, renderWidth, renderHeight);
+            }
+            statsEnd(STATS_STAGE_DRAW, begin);
+            if (mStats != nullptr) {
+                mStats->EndGpu();
+            }
+
+            // 只读回块内部，按输出行宽写入对应位置
+            begin = statsBegin();
+            glPixelStorei(GL_PACK_ROW_LENGTH, outWidth);
+            glReadPixels(tileX - renderX, tileY - renderY, tileWidth, tileHeight, GL_RGBA,
+                         GL_UNSIGNED_BYTE, (void *) (addr + ((size_t) tileY * outWidth + tileX) * 4));
+            glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+            statsEnd(STATS_STAGE_READBACK, begin);
+        }
+    }
+    LOGD(TAG, "DrawTiled tile=%d halo=%d error=%d", tile, halo, glGetError());
+    return true;
+}
+
+bool BgRender::DrawThumbnails(const int *sizes, int count, int quality, const signed char *addr,
+                              long long capacity) {
+    LOGD(TAG, "DrawThumbnails count=%d quality=%d", count, quality);
+    if (mEnv == nullptr || mFboId == 0) {
+        LOGE(TAG, "DrawThumbnails needs gpu");
+        return false;
+    }
+    if (mOutputFormat != IMAGE_FORMAT_RGBA) {
+        LOGE(TAG, "DrawThumbnails output format=%d not supported", mOutputFormat);
+        return false;
+    }
+    long long total = 0;
+    for (int i = 0; i < count; i++) {
+        int width = sizes[i * 2];
+        int height = sizes[i * 2 + 1];
+        int filterWidth, filterHeight;
+        if (width <= 0 || height <= 0) {
+            LOGE(TAG, "DrawThumbnails invalid size %dx%d", width, height);
+            return false;
+        }
+        mFilterChain->GetOutputSize(width, height, &filterWidth, &filterHeight);
+        if (filterWidth != width || filterHeight != height) {
+            LOGE(TAG, "DrawThumbnails crop filter not supported");
+            return false;
+        }
+        total += (long long) width * height * 4;
+    }
+    if (total > capacity) {
+        LOGE(TAG, "DrawThumbnails capacity=%lld < %lld", capacity, total);
+        return false;
+    }
+
+    // 按各缩略图的尺寸计算变换，结束后恢复指定的输出尺寸
+    int requestWidth = mRequestWidth;
+    int requestHeight = mRequestHeight;
+    const signed char *output = addr;
+    for (int i = 0; i < count; i++) {
+        mRequestWidth = sizes[i * 2];
+        mRequestHeight = sizes[i * 2 + 1];
+        GLfloat transform[TEX_TRANSFORM_SIZE];
+        int width, height;
+        computeTransform(transform, &width, &height);
+
+        if (mStats != nullptr) {
+            mStats->BeginGpu();
+        }
+        long long begin = statsBegin();
+        renderScaled(mInput, transform, width, height, quality);
+        statsEnd(STATS_STAGE_DRAW, begin);
+        if (mStats != nullptr) {
+            mStats->EndGpu();
+        }
+        begin = statsBegin();
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void *) output);
+        statsEnd(STATS_STAGE_READBACK, begin);
+        output += (size_t) width * height * 4;
+    }
+    mRequestWidth = requestWidth;
+    mRequestHeight = requestHeight;
+    LOGD(TAG, "DrawThumbnails error=%d", glGetError());
+    return true;
+}
+
+bool BgRender::DrawRegions(const int *rects, int count, const signed char *addr,
+                           long long capacity) {
+    LOGD(TAG, "DrawRegions count=%d", count);
+    if (mEnv == nullptr || mFboId == 0) {
+        LOGE(TAG, "DrawRegions needs gpu");
+        return false;
+    }
+    if (mOutputFormat != IMAGE_FORMAT_RGBA) {
+        LOGE(TAG, "DrawRegions output format=%d not supported", mOutputFormat);
+        return false;
+    }
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    int outWidth, outHeight;
+    computeTransform(transform, &outWidth, &outHeight);
+    int filterWidth, filterHeight;
+    mFilterChain->GetOutputSize(outWidth, outHeight, &filterWidth, &filterHeight);
+    if (filterWidth != outWidth || filterHeight != outHeight) {
+        LOGE(TAG, "DrawRegions crop filter not supported");
+        return false;
+    }
+    int halo = mFilterChain->GetHaloSize();
+    long long total = 0;
+    int maxWidth = 0, maxHeight = 0;
+    for (int i = 0; i < count; i++) {
+        const int *rect = rects + i * 4;
+        if (rect[0] < 0 || rect[1] < 0 || rect[2] <= 0 || rect[3] <= 0
+            || rect[0] + rect[2] > outWidth || rect[1] + rect[3] > outHeight) {
+            LOGE(TAG, "DrawRegions invalid region (%d, %d, %d, %d) in %dx%d", rect[0], rect[1],
+                 rect[2], rect[3], outWidth, outHeight);
+            return false;
+        }
+        total += (long long) rect[2] * rect[3] * 4;
+        // 含邻域的绘制尺寸，FBO一次分配到最大
+        int renderWidth = rect[2] + 2 * halo < outWidth ? rect[2] + 2 * halo : outWidth;
+        int renderHeight = rect[3] + 2 * halo < outHeight ? rect[3] + 2 * halo : outHeight;
+        maxWidth = renderWidth > maxWidth ? renderWidth : maxWidth;
+        maxHeight = renderHeight > maxHeight ? renderHeight : maxHeight;
+    }
+    if (total > capacity) {
+        LOGE(TAG, "DrawRegions capacity=%lld < %lld", capacity, total);
+        return false;
+    }
+    if (count <= 0) {
+        return true;
+    }
+    bindBatchPbo(total);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+    if (maxWidth > mFboWidth || maxHeight > mFboHeight) {
+        ensureFboSize(maxWidth > mFboWidth ? maxWidth : mFboWidth,
+                      maxHeight > mFboHeight ? maxHeight : mFboHeight);
+    }
+    mFboGrowOnly = true;
+
+    GLsizeiptr offset = 0;
+    for (int i = 0; i < count; i++) {
+        const int *rect = rects + i * 4;
+        // 绘制区域向外扩展滤镜邻域，限制在输出内，与DrawTiled相同
+        int renderX = rect[0] - halo > 0 ? rect[0] - halo : 0;
+        int renderY = rect[1] - halo > 0 ? rect[1] - halo : 0;
+        int renderRight = rect[0] + rect[2] + halo < outWidth ? rect[0] + rect[2] + halo : outWidth;
+        int renderBottom = rect[1] + rect[3] + halo < outHeight ? rect[1] + rect[3] + halo
+                                                                 : outHeight;
+        int renderWidth = renderRight - renderX;
+        int renderHeight = renderBottom - renderY;
+        // 区域内坐标 -> 整图输出坐标 -> 原图坐标
+        GLfloat region[TEX_TRANSFORM_SIZE] = {
+                (GLfloat) renderWidth / outWidth, 0.0f, (GLfloat) renderX / outWidth,
+                0.0f, (GLfloat) renderHeight / outHeight, (GLfloat) renderY / outHeight,
+        };
+        GLfloat regionTransform[TEX_TRANSFORM_SIZE];
+        texTransformConcat(transform, region, regionTransform);
+
+        if (mStats != nullptr) {
+            mStats->BeginGpu();
+        }
+        long long begin = statsBegin();
+        renderScaled(mInput, regionTransform, renderWidth, renderHeight, mScaleQuality);
+        if (!mOverlay->IsEmpty()) {
+            mOverlay->Draw(mFboId, renderX, renderY, renderWidth, renderHeight);
+        }
+        statsEnd(STATS_STAGE_DRAW, begin);
+        if (mStats != nullptr) {
+            mStats->EndGpu();
+        }
+        // 读取命令只进入队列，下一个区域覆盖FBO前由驱动保证先完成拷贝
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mBatchPboId);
+        glReadPixels(rect[0] - renderX, rect[1] - renderY, rect[2], rect[3], GL_RGBA,
+                     GL_UNSIGNED_BYTE, (void *) offset);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+        offset += (GLsizeiptr) rect[2] * rect[3] * 4;
+    }
+    mFboGrowOnly = false;
+
+    // 只在这里等待一次GPU
+    long long begin = statsBegin();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mBatchPboId);
+    void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, total, GL_MAP_READ_BIT);
+    bool success = mapped != nullptr;
+    if (success) {
+        memcpy((void *) addr, mapped, total);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        LOGE(TAG, "DrawRegions glMapBufferRange fail error=%d", glGetError());
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+    statsEnd(STATS_STAGE_READBACK, begin);
+    return success;
+}
+
+void BgRender::bindBatchPbo(GLsizeiptr size) {
+    if (mBatchPboId == 0) {
+        glGenBuffers(1, &mBatchPboId);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mBatchPboId);
+    if (mBatchPboSize < size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        mBatchPboSize = size;
+    }
+}
+
+long long BgRender::GetMultipleDataSize(const int *outputs, int count) {
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    int width, height;
+    computeTransform(transform, &width, &height);
+    long long total = 0;
+    for (int i = 0; i < count; i++) {
+        switch (outputs[i]) {
+            case MULTI_OUTPUT_COLOR:
+                total += (long long) width * height * 4;
+                break;
+            case MULTI_OUTPUT_GRAY:
+                total += (long long) width * height;
+                break;
+            case MULTI_OUTPUT_PREVIEW:
+                total += (long long) ((width + 1) / 2) * ((height + 1) / 2) * 4;
+                break;
+            default:
+                return -1;
+        }
+    }
+    return total;
+}
+
+bool BgRender::DrawMultiple(const int *outputs, int count, const signed char *addr,
+                            long long capacity) {
+    LOGD(TAG, "DrawMultiple count=%d", count);
+    if (mEnv == nullptr || mFboId == 0) {
+        LOGE(TAG, "DrawMultiple needs gpu");
+        return false;
+    }
+    long long total = GetMultipleDataSize(outputs, count);
+    if (total < 0) {
+        LOGE(TAG, "DrawMultiple invalid output");
+        return false;
+    }
+    if (total > capacity) {
+        LOGE(TAG, "DrawMultiple capacity=%lld < %lld", capacity, total);
+        return false;
+    }
+    if (count <= 0) {
+        return true;
+    }
+    bool needColor = false, needGray = false, needPreview = false;
+    for (int i = 0; i < count; i++) {
+        needColor |= outputs[i] == MULTI_OUTPUT_COLOR;
+        needGray |= outputs[i] == MULTI_OUTPUT_GRAY;
+        needPreview |= outputs[i] == MULTI_OUTPUT_PREVIEW;
+    }
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    int width, height;
+    computeTransform(transform, &width, &height);
+    int previewWidth = (width + 1) / 2;
+    int previewHeight = (height + 1) / 2;
+
+    if (mStats != nullptr) {
+        mStats->BeginGpu();
+    }
+    long long begin = statsBegin();
+    // 预览由彩色附着缩小，只要预览时彩色附着同样需要写入
+    bool success = renderMultiple(transform, width, height, needColor || needPreview, needGray);
+    if (success && needPreview) {
+        blitPreview(width, height);
+    }
+    statsEnd(STATS_STAGE_DRAW, begin);
+    if (mStats != nullptr) {
+        mStats->EndGpu();
+    }
+    if (!success) {
+        return false;
+    }
+
+    // R8附着能否以GL_RED直接读取取决于驱动，不能时按RGBA读取，映射后再取r分量
+    bool grayDirect = false;
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+    if (needGray) {
+        glReadBuffer(GL_COLOR_ATTACHMENT1);
+        GLint readFormat = 0, readType = 0;
+        glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &readFormat);
+        glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &readType);
+        grayDirect = readFormat == GL_RED && readType == GL_UNSIGNED_BYTE;
+    }
+    GLsizeiptr graySize = (GLsizeiptr) width * height * (grayDirect ? 1 : 4);
+    GLsizeiptr pboSize = 0;
+    for (int i = 0; i < count; i++) {
+        if (outputs[i] == MULTI_OUTPUT_COLOR) {
+            pboSize += (GLsizeiptr) width * height * 4;
+        } else if (outputs[i] == MULTI_OUTPUT_GRAY) {
+            pboSize += graySize;
+        } else {
+            pboSize += (GLsizeiptr) previewWidth * previewHeight * 4;
+        }
+    }
+
+    begin = statsBegin();
+    bindBatchPbo(pboSize);
+    GLsizeiptr offset = 0;
+    for (int i = 0; i < count; i++) {
+        if (outputs[i] == MULTI_OUTPUT_PREVIEW) {
+            glBindFramebuffer(GL_FRAMEBUFFER, mPreviewFboId);
+            glReadPixels(0, 0, previewWidth, previewHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                         (void *) offset);
+            offset += (GLsizeiptr) previewWidth * previewHeight * 4;
+            continue;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+        if (outputs[i] == MULTI_OUTPUT_COLOR) {
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void *) offset);
+            offset += (GLsizeiptr) width * height * 4;
+        } else {
+            glReadBuffer(GL_COLOR_ATTACHMENT1);
+            if (grayDirect) {
+                // 每行width字节，不按4字节补齐
+                glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                glReadPixels(0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, (void *) offset);
+                glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            } else {
+                glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void *) offset);
+            }
+            offset += graySize;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    // 只在这里等待一次GPU
+    void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pboSize, GL_MAP_READ_BIT);
+    success = mapped != nullptr;
+    if (success) {
+        const uint8_t *src = (const uint8_t *) mapped;
+        uint8_t *dst = (uint8_t *) addr;
+        for (int i = 0; i < count; i++) {
+            if (outputs[i] == MULTI_OUTPUT_GRAY && !grayDirect) {
+                long long pixelCount = (long long) width * height;
+                for (long long p = 0; p < pixelCount; p++) {
+                    dst[p] = src[p * 4];
+                }
+                src += graySize;
+                dst += pixelCount;
+                continue;
+            }
+            size_t size = outputs[i] == MULTI_OUTPUT_COLOR
+                          ? (size_t) width * height * 4
+                          : outputs[i] == MULTI_OUTPUT_GRAY
+                            ? (size_t) width * height
+                            : (size_t) previewWidth * previewHeight * 4;
+            memcpy(dst, src, size);
+            src += size;
+            dst += size;
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        LOGE(TAG, "DrawMultiple glMapBufferRange fail error=%d", glGetError());
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+    statsEnd(STATS_STAGE_READBACK, begin);
+    return success;
+}
+
+bool BgRender::renderMultiple(const GLfloat *transform, int width, int height, bool writeColor,
+                              bool writeGray) {
+    InputTexture *input = mInput;
+    GLfloat identity[TEX_TRANSFORM_SIZE];
+    if (mScaleQuality != SCALE_QUALITY_BILINEAR) {
+        // 与renderScaled相同，重采样结果已经过变换
+        InputTexture *scaled = mDownscaler->Resample(mInput, transform, width, height,
+                                                     mScaleQuality);
+        if (scaled != nullptr) {
+            texTransformIdentity(identity);
+            input = scaled;
+            transform = identity;
+        }
+    }
+    if (mMultiProgramFormat != input->GetFormat()) {
+        std::string fragmentShader = std::string(MULTI_FRAGMENT_SHADER_HEAD)
+                                     + InputTexture::GetSampleFunction(input->GetFormat())
+                                     + MULTI_FRAGMENT_SHADER_MAIN;
+        mMultiProgramId = mEnv->GetProgram(FBO_VERTEX_SHADER, fragmentShader.c_str());
+        mMultiProgramFormat = input->GetFormat();
+        mMultiTexMatrixLoc = glGetUniformLocation(mMultiProgramId, "u_texMatrix");
+    }
+    if (mMultiProgramId == 0) {
+        LOGE(TAG, "renderMultiple program fail");
+        mMultiProgramFormat = -1;
+        return false;
+    }
+    ensureFboSize(width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+    if (writeGray) {
+        if (mGrayTextureId == 0) {
+            glGenTextures(1, &mGrayTextureId);
+            glBindTexture(GL_TEXTURE_2D, mGrayTextureId);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+        if (mGrayWidth != width || mGrayHeight != height) {
+            glBindTexture(GL_TEXTURE_2D, mGrayTextureId);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE,
+                         nullptr);
+            mGrayWidth = width;
+            mGrayHeight = height;
+        }
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+        // 附件尺寸可以不同，OpenGL ES 3.0按所有附件的交集绘制
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D,
+                               mGrayTextureId, 0);
+    }
+    GLenum buffers[] = {
+            writeColor ? GL_COLOR_ATTACHMENT0 : (GLenum) GL_NONE,
+            writeGray ? GL_COLOR_ATTACHMENT1 : (GLenum) GL_NONE,
+    };
+    glDrawBuffers(2, buffers);
+    glViewport(0, 0, width, height);
+
+    glUseProgram(mMultiProgramId);
+    GLfloat matrix[9];
+    texTransformToMat3(transform, matrix);
+    glUniformMatrix3fv(mMultiTexMatrixLoc, 1, GL_FALSE, matrix);
+    input->Bind(mMultiProgramId);
+    glBindVertexArray(mVaoId);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const void *) 0);
     glBindVertexArray(GL_NONE);
     glBindTexture(GL_TEXTURE_2D, GL_NONE);
+
+    // 其他绘制路径只输出到附件0
+    GLenum single = GL_COLOR_ATTACHMENT0;
+    glDrawBuffers(1, &single);
+    LOGD(TAG, "renderMultiple error=%d", glGetError());
+    return true;
+}
+
+void BgRender::blitPreview(int width, int height) {
+    int previewWidth = (width + 1) / 2;
+    int previewHeight = (height + 1) / 2;
+    if (mPreviewFboId == 0) {
+        glGenTextures(1, &mPreviewTextureId);
+        glBindTexture(GL_TEXTURE_2D, mPreviewTextureId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glGenFramebuffers(1, &mPreviewFboId);
+        glBindFramebuffer(GL_FRAMEBUFFER, mPreviewFboId);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               mPreviewTextureId, 0);
+    }
+    if (mPreviewWidth != previewWidth || mPreviewHeight != previewHeight) {
+        glBindTexture(GL_TEXTURE_2D, mPreviewTextureId);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, previewWidth, previewHeight, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, nullptr);
+        mPreviewWidth = previewWidth;
+        mPreviewHeight = previewHeight;
+    }
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    // 宽高正好减半时线性过滤的采样点落在2x2块的中心，即4个像素的平均
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mFboId);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mPreviewFboId);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, previewWidth, previewHeight,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+}
+
+void BgRender::readOutput(void *addr) {
+    int outWidth, outHeight;
+    GetOutputSize(&outWidth, &outHeight);
+    if (mOutputFormat == IMAGE_FORMAT_RGBA) {
+        if (addr == nullptr) {
+            mPboReader->Read(0, 0, outWidth, outHeight, GL_RGBA, GL_UNSIGNED_BYTE, GetDataSize());
+        } else {
+            glReadPixels(0, 0, outWidth, outHeight, GL_RGBA, GL_UNSIGNED_BYTE, addr);
+        }
+        return;
+    }
+    // 再画一趟，把FBO中的RGBA结果按字节打包为YUV、灰度等目标格式，只读取目标格式的字节数
+    if (!mYuvPacker->Pack(mFboTextureId, outWidth, outHeight, mOutputFormat)) {
+        return;
+    }
+    if (addr == nullptr) {
+        mYuvPacker->ReadAsync(mPboReader);
+    } else {
+        mYuvPacker->Read(addr);
+    }
+}
+
+// 流式更新一帧，格式与尺寸不变时只做glTexSubImage2D，不重建EGL环境与纹理
+bool BgRender::UpdateFrame(unsigned int width, unsigned int height, const char *imageData,
+                           int format) {
+    LOGD(TAG, "UpdateFrame width=%d height=%d format=%d", width, height, format);
+    if (mEnv == nullptr) {
+        // 没有GL环境，只有CPU引擎可用，CPU引擎只支持RGBA
+        if (format != IMAGE_FORMAT_RGBA) {
+            LOGE(TAG, "UpdateFrame format=%d needs gpu", format);
+            return false;
+        }
+        mWidth = width;
+        mHeight = height;
+        hashInput(imageData, format, width, height);
+        keepCpuFrame(imageData);
+        return true;
+    }
+    if (mFboTextureId == 0) {
+        LOGE(TAG, "UpdateFrame before CreateGlesEnv");
+        return false;
+    }
+    long long begin = statsBegin();
+    if (!mInput->Upload(format, width, height, imageData)) {
+        return false;
+    }
+    statsEnd(STATS_STAGE_UPLOAD, begin);
+    mDownscaler->Invalidate();
+    // 尺寸变化时FBO纹理在下次绘制时按输出尺寸分配，读取缓冲区在下次Draw时重新分配
+    mWidth = width;
+    mHeight = height;
+    mImageFormat = format;
+    hashInput(imageData, format, width, height);
+    keepCpuFrame(imageData);
+    LOGD(TAG, "UpdateFrame error=%d", glGetError());
+    return true;
+}
+
+void BgRender::SetYuvColorSpace(int standard, bool fullRange) {
+    LOGD(TAG, "SetYuvColorSpace standard=%d fullRange=%d", standard, fullRange);
+    mInput->SetColorSpace(standard, fullRange);
+    if (mDownscaler != nullptr) {
+        // YUV输入的金字塔是转换后的RGB
+        mDownscaler->Invalidate();
+    }
+    if (mYuvPacker != nullptr) {
+        mYuvPacker->SetColorSpace(standard, fullRange);
+    }
+}
+
+bool BgRender::SetOutputFormat(int format) {
+    LOGD(TAG, "SetOutputFormat format=%d", format);
+    if (InputTexture::GetDataSize(format, 1, 1) == 0) {
+        LOGE(TAG, "SetOutputFormat unknown format=%d", format);
+        return false;
+    }
+    // 读取缓冲区在下次Draw时按新的大小重新分配
+    mOutputFormat = format;
+    return true;
+}
+
+int BgRender::AddOverlayImage(int width, int height, const char *imageData, bool premultiplied) {
+    if (mOverlay == nullptr) {
+        LOGE(TAG, "AddOverlayImage needs gpu");
+        return -1;
+    }
+    return mOverlay->AddImage(width, height, imageData, premultiplied);
+}
+
+bool BgRender::AddOverlay(int image, float x, float y, float scale, float opacity, int blend) {
+    LOGD(TAG, "AddOverlay image=%d position=(%f, %f) scale=%f opacity=%f blend=%d", image, x, y,
+         scale, opacity, blend);
+    if (mOverlay == nullptr) {
+        LOGE(TAG, "AddOverlay needs gpu");
+        return false;
+    }
+    return mOverlay->AddLayer(image, x, y, scale, opacity, blend);
+}
+
+void BgRender::ClearOverlays(bool clearImages) {
+    if (mOverlay != nullptr) {
+        mOverlay->Clear(clearImages);
+    }
+}
+
+bool BgRender::DetectBlank(int startHeight, int endHeight, int *result) {
+    LOGD(TAG, "DetectBlank startHeight=%d endHeight=%d", startHeight, endHeight);
+    if (mBlankDetector == nullptr) {
+        LOGE(TAG, "DetectBlank needs gpu");
+        return false;
+    }
+    return mBlankDetector->Detect(mInput, startHeight, endHeight, result);
+}
+
+bool BgRender::DetectMotion(int *result, const signed char *mask, long long capacity) {
+    LOGD(TAG, "DetectMotion mask=%p", mask);
+    if (mMotionDetector == nullptr) {
+        LOGE(TAG, "DetectMotion needs gpu");
+        return false;
+    }
+    long long maskSize = (long long) mInput->GetWidth() * mInput->GetHeight();
+    if (mask != nullptr && capacity < maskSize) {
+        LOGE(TAG, "DetectMotion capacity=%lld < %lld", capacity, maskSize);
+        return false;
+    }
+    if (!mMotionDetector->Detect(mInput, result)) {
+        return false;
+    }
+    if (mask == nullptr) {
+        return true;
+    }
+    // 掩码为黑白RGBA，按灰度打包后每像素只读取1字节
+    if (!mYuvPacker->Pack(mMotionDetector->GetMaskTexture(), mInput->GetWidth(),
+                          mInput->GetHeight(), IMAGE_FORMAT_GRAY)) {
+        return false;
+    }
+    mYuvPacker->Read((void *) mask);
+    return true;
+}
+
+void BgRender::SetMotionThreshold(int threshold, int tilePixels) {
+    if (mMotionDetector != nullptr) {
+        mMotionDetector->SetThreshold(threshold, tilePixels);
+    }
+}
+
+void BgRender::ResetMotion() {
+    if (mMotionDetector != nullptr) {
+        mMotionDetector->Reset();
+    }
+}
+
+void BgRender::SetStatsEnabled(bool enabled) {
+    LOGD(TAG, "SetStatsEnabled enabled=%d", enabled);
+    if (enabled == (mStats != nullptr)) {
+        return;
+    }
+    if (enabled) {
+        mStats = new RenderStats(mEnv != nullptr);
+        return;
+    }
+    mStats->Release();
+    delete mStats;
+    mStats = nullptr;
+}
+
+bool BgRender::GetStats(long long *result) {
+    if (mStats == nullptr) {
+        return false;
+    }
+    mStats->Get(result);
+    return true;
+}
+
+void BgRender::keepCpuFrame(const char *imageData) {
+    if (imageData == nullptr) {
+        return;
+    }
+    if (mImageFormat != IMAGE_FORMAT_RGBA) {
+        // CPU引擎只支持RGBA，YUV输入总是走GPU
+        mCpuRender->ClearFrame();
+        return;
+    }
+    bool keep = mEnv == nullptr || mEngine == ENGINE_CPU ||
+                (mEngine == ENGINE_AUTO && (int) (mWidth * mHeight) <= mCpuThreshold);
+    if (keep) {
+        mCpuRender->SetFrame(mWidth, mHeight, imageData);
+    } else {
+        // 之前保留的是旧帧，不能再用
+        mCpuRender->ClearFrame();
+    }
+}
+
+bool BgRender::useCpu() {
+    bool cpu;
+    if (!mCpuRender->HasFrame()) {
+        cpu = false;
+    } else if (mOutputFormat != IMAGE_FORMAT_RGBA) {
+        // CPU引擎只输出RGBA
+        cpu = false;
+    } else if (mEnv == nullptr) {
+        cpu = true;
+    } else if (mPboReader != nullptr || (mFilterChain != nullptr && !mFilterChain->IsEmpty())
+               || (mOverlay != nullptr && !mOverlay->IsEmpty())
+               || mScaleQuality != SCALE_QUALITY_BILINEAR) {
+        // CPU引擎不支持滤镜链、叠加图层、高质量缩放与异步读取
+        cpu = false;
+    } else if (mEngine == ENGINE_AUTO) {
+        cpu = (int) (mWidth * mHeight) <= mCpuThreshold;
+    } else {
+        cpu = mEngine == ENGINE_CPU;
+    }
+    mLastEngine = cpu ? ENGINE_CPU : ENGINE_GPU;
+    return cpu;
+}
+
+void BgRender::SetEngine(int engine) {
+    LOGD(TAG, "SetEngine engine=%d", engine);
+    mEngine = engine;
+    if (engine == ENGINE_CPU && !mCpuRender->HasFrame()) {
+        LOGW(TAG, "SetEngine cpu without frame, call UpdateFrame first");
+    }
+}
+
+void BgRender::SetCpuThreshold(int pixelCount) {
+    mCpuThreshold = pixelCount;
+}
+
+int BgRender::GetLastEngine() {
+    return mLastEngine;
+}
+
+void BgRender::computeTransform(GLfloat *matrix, int *width, int *height) {
+    if (mUseAffine) {
+        memcpy(matrix, mAffine, sizeof(mAffine));
+        *width = mRequestWidth > 0 ? mRequestWidth : (int) mWidth;
+        *height = mRequestHeight > 0 ? mRequestHeight : (int) mHeight;
+        return;
+    }
+    // 裁剪区域限制在原图范围内，原图尺寸可能已通过UpdateFrame改变
+    int cropX = 0, cropY = 0, cropWidth = mWidth, cropHeight = mHeight;
+    if (mCropWidth > 0 && mCropHeight > 0) {
+        cropX = mCropX < 0 ? 0 : (mCropX >= (int) mWidth ? mWidth - 1 : mCropX);
+        cropY = mCropY < 0 ? 0 : (mCropY >= (int) mHeight ? mHeight - 1 : mCropY);
+        cropWidth = mCropWidth < (int) mWidth - cropX ? mCropWidth : mWidth - cropX;
+        cropHeight = mCropHeight < (int) mHeight - cropY ? mCropHeight : mHeight - cropY;
+    }
+    // 采样方向与绘制相反：输出坐标先去掉镜像，再去掉旋转，最后映射到裁剪区域
+    GLfloat mirror[TEX_TRANSFORM_SIZE];
+    texTransformIdentity(mirror);
+    if (mMirror == MIRROR_HORIZONTAL) {
+        mirror[0] = -1.0f;
+        mirror[2] = 1.0f;
+    } else if (mMirror == MIRROR_VERTICAL) {
+        mirror[4] = -1.0f;
+        mirror[5] = 1.0f;
+    }
+    // ROTATE_90: s = v, t = 1 - u    ROTATE_180: s = 1 - u, t = 1 - v    ROTATE_270: s = 1 - v, t = u
+    static const GLfloat rotates[4][TEX_TRANSFORM_SIZE] = {
+            {1.0f,  0.0f,  0.0f, 0.0f,  1.0f,  0.0f},
+            {0.0f,  1.0f,  0.0f, -1.0f, 0.0f,  1.0f},
+            {-1.0f, 0.0f,  1.0f, 0.0f,  -1.0f, 1.0f},
+            {0.0f,  -1.0f, 1.0f, 1.0f,  0.0f,  0.0f},
+    };
+    GLfloat crop[TEX_TRANSFORM_SIZE] = {
+            (GLfloat) cropWidth / mWidth, 0.0f, (GLfloat) cropX / mWidth,
+            0.0f, (GLfloat) cropHeight / mHeight, (GLfloat) cropY / mHeight,
+    };
+    texTransformConcat(rotates[mRotate], mirror, matrix);
+    texTransformConcat(crop, matrix, matrix);
+
+    bool swap = mRotate == ROTATE_90 || mRotate == ROTATE_270;
+    if (mRequestWidth > 0 && mRequestHeight > 0) {
+        *width = mRequestWidth;
+        *height = mRequestHeight;
+    } else if (mRequestWidth == 0 || mRequestHeight == 0) {
+        *width = swap ? cropHeight : cropWidth;
+        *height = swap ? cropWidth : cropHeight;
+    } else {
+        // 旧接口：输出与原图同尺寸，非正方形图像旋转90/270度时会被拉伸
+        *width = mWidth;
+        *height = mHeight;
+    }
+}
+
+void BgRender::ensureFboSize(int width, int height) {
+    if (width == mFboWidth && height == mFboHeight) {
+        return;
+    }
+    if (mFboGrowOnly && width <= mFboWidth && height <= mFboHeight) {
+        // 只使用左下角width x height的区域
+        return;
+    }
+    LOGD(TAG, "ensureFboSize width=%d height=%d", width, height);
+    mFboWidth = width;
+    mFboHeight = height;
+    // 纹理仍连接在FBO上，只重新分配内存
+    glBindTexture(GL_TEXTURE_2D, mFboTextureId);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+}
+
+void BgRender::renderCpu(uint8_t *dst) {
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    int width, height;
+    computeTransform(transform, &width, &height);
+    long long begin = statsBegin();
+    mCpuRender->Render(dst, transform, width, height);
+    statsEnd(STATS_STAGE_DRAW, begin);
+}
+
+void BgRender::GetOutputSize(int *width, int *height) {
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    int transformWidth, transformHeight;
+    computeTransform(transform, &transformWidth, &transformHeight);
+    if (mFilterChain != nullptr) {
+        mFilterChain->GetOutputSize(transformWidth, transformHeight, width, height);
+    } else {
+        *width = transformWidth;
+        *height = transformHeight;
+    }
+}
+
+int BgRender::GetDataSize() {
+    int outWidth, outHeight;
+    GetOutputSize(&outWidth, &outHeight);
+    return InputTexture::GetDataSize(mOutputFormat, outWidth, outHeight);
+}
+
+bool BgRender::AddFilter(int type, const float *params, int paramCount) {
+    if (mFilterChain == nullptr) {
+        LOGE(TAG, "AddFilter before CreateGlesEnv");
+        return false;
+    }
+    return mFilterChain->AddFilter(type, params, paramCount);
+}
+
+void BgRender::ClearFilters() {
+    if (mFilterChain != nullptr) {
+        mFilterChain->Clear();
+    }
+}
+
+void BgRender::SetFilterComputeEnabled(bool enabled) {
+    if (mFilterChain == nullptr) {
+        LOGE(TAG, "SetFilterComputeEnabled before CreateGlesEnv");
+        return;
+    }
+    mFilterChain->SetComputeEnabled(enabled);
+}
+
+int BgRender::GetFilterPassCount() {
+    if (mFilterChain == nullptr) {
+        return 0;
+    }
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    int width, height;
+    computeTransform(transform, &width, &height);
+    return mFilterChain->GetPassCount(width, height);
 }
 
 // 释放GLES环境
 void BgRender::DestroyGlesEnv() {
     LOGD(TAG, "DestroyGlesEnv");
-    // 8. 释放EGL环境
-    if (mEglDisplay != EGL_NO_DISPLAY) {
-        // 解绑上下文
-        eglMakeCurrent(mEglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-        eglDestroyContext(mEglDisplay, mEglContext);
-        eglDestroySurface(mEglDisplay, mEglSurface);
-        eglReleaseThread();
-        eglTerminate(mEglDisplay);
-    }
-
-    mEglDisplay = nullptr;
-    mEglConfig = nullptr;
-    mEglSurface = nullptr;
-    mEglContext = nullptr;
-
-    LOGD(TAG, "mFboTextureId=%d mFboId=%d mFboProgramId=%d mVertexShader=%d mFragmentShader=%d mTextureId=%d mVaoId=%d",
-         mFboTextureId, mFboId, mFboProgramId, mVertexShader, mFragmentShader, mTextureId, mVaoId);
-    if (mFboTextureId != 0) {
-        glDeleteTextures(1, &mFboTextureId);
+    // 上下文是共享的，本实例的GL对象必须在归还环境之前删除，否则会一直残留在上下文中
+    if (mEnv != nullptr && mEnv->MakeCurrent()) {
+        LOGD(TAG, "mFboTextureId=%d mFboId=%d mFboProgramId=%d mVaoId=%d",
+             mFboTextureId, mFboId, mFboProgramId, mVaoId);
+        if (mFboTextureId != 0) {
+            glDeleteTextures(1, &mFboTextureId);
+        }
+        if (mFboId != 0) {
+            glDeleteFramebuffers(1, &mFboId);
+        }
+        mInput->Release();
+        if (mBatchPboId != 0) {
+            glDeleteBuffers(1, &mBatchPboId);
+        }
+        if (mGrayTextureId != 0) {
+            glDeleteTextures(1, &mGrayTextureId);
+        }
+        if (mPreviewFboId != 0) {
+            glDeleteFramebuffers(1, &mPreviewFboId);
+            glDeleteTextures(1, &mPreviewTextureId);
+        }
+        if (mTileInput != nullptr) {
+            mTileInput->Release();
+        }
+        if (mVboIds != nullptr) {
+            glDeleteBuffers(3, mVboIds);
+        }
+        if (mVaoId != 0) {
+            glDeleteVertexArrays(1, &mVaoId);
+        }
+        if (mPboReader != nullptr) {
+            mPboReader->Release();
+        }
+        if (mFilterChain != nullptr) {
+            mFilterChain->Release();
+        }
+        if (mYuvPacker != nullptr) {
+            mYuvPacker->Release();
+        }
+        if (mBlankDetector != nullptr) {
+            mBlankDetector->Release();
+        }
+        if (mMotionDetector != nullptr) {
+            mMotionDetector->Release();
+        }
+        if (mOverlay != nullptr) {
+            mOverlay->Release();
+        }
+        if (mDownscaler != nullptr) {
+            mDownscaler->Release();
+        }
+        if (mStats != nullptr) {
+            mStats->Release();
+        }
+        LOGD(TAG, "glDelete error=%d", glGetError());
     }
-    mFboTextureId = 0;
-    if (mFboId != 0) {
-        glDeleteFramebuffers(1, & mFboId);
+    delete mFilterChain;
+    mFilterChain = nullptr;
+    delete mYuvPacker;
+    mYuvPacker = nullptr;
+    delete mBlankDetector;
+    mBlankDetector = nullptr;
+    delete mMotionDetector;
+    mMotionDetector = nullptr;
+    delete mOverlay;
+    mOverlay = nullptr;
+    delete mDownscaler;
+    mDownscaler = nullptr;
+    delete mStats;
+    mStats = nullptr;
+    if (mCpuRender != nullptr) {
+        mCpuRender->Release();
     }
+    delete mPboReader;
+    mPboReader = nullptr;
+    mFboTextureId = 0;
     mFboId = 0;
-    if (mFboProgramId != 0) {
-        glDeleteProgram(mFboProgramId);
-    }
+    mBatchPboId = 0;
+    mBatchPboSize = 0;
+    mGrayTextureId = 0;
+    mGrayWidth = 0;
+    mGrayHeight = 0;
+    mPreviewTextureId = 0;
+    mPreviewFboId = 0;
+    mPreviewWidth = 0;
+    mPreviewHeight = 0;
+    mMultiProgramId = 0;
+    mMultiProgramFormat = -1;
+    // 程序由GlesEnv缓存，供下一个实例复用
     mFboProgramId = 0;
-    if (mTextureId != 0) {
-        glDeleteTextures(1, &mTextureId);
-    }
-    mTextureId = 0;
-    if (mVboIds != nullptr) {
-        glDeleteBuffers(3, mVboIds);
-    }
-    delete mVboIds;
+    delete[] mVboIds;
     mVboIds = nullptr;
-    if (mVaoId != 0) {
-        glDeleteVertexArrays(1, &mVaoId);
-    }
     mVaoId = 0;
-    if (mVertexShader != 0) {
-        glDeleteShader(mVertexShader);
-    }
-    mVertexShader = 0;
-    if (mFragmentShader != 0) {
-        glDeleteShader(mFragmentShader);
+
+    if (mEnv != nullptr && mAcquiredEnv) {
+        GlesEnv::Release();
     }
-    mFragmentShader = 0;
-    LOGD(TAG, "glDelete error=%d", glGetError());
-    delete mImageRawData;
+    mEnv = nullptr;
+
     mImageRawData = nullptr;
-    delete mDrawData;
+    BufferPool::Get()->Free(mDrawData);
     mDrawData = nullptr;
+    mDrawDataSize = 0;
 
 }
 
@@ -247,35 +1469,30 @@ void BgRender::createFBO() {
     glGenFramebuffers(1, &mFboId);
     // 绑定FBO
     glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
-    // 绑定FBO纹理
-    glBindTexture(GL_TEXTURE_2D, mFboTextureId);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                 nullptr);
+    // 纹理内存在第一次绘制时按输出尺寸分配，见ensureFboSize
+    mFboWidth = 0;
+    mFboHeight = 0;
     // 将纹理连接到FBO附着，颜色附着
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mFboTextureId, 0);
     LOGD(TAG, "Gen FBO error=%d", glGetError());
-    // 检查FBO完整性状态
+    // 检查FBO完整性状态，纹理内存分配前为不完整
     LOGD(TAG, "glCheckFramebufferStatus=%d", glCheckFramebufferStatus(GL_FRAMEBUFFER));
     // 解绑纹理
     glBindTexture(GL_TEXTURE_2D, GL_NONE);
     // 解绑FBO
     glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+}
 
-    // 创建一个2D纹理用于渲染
-    glGenTextures(1, &mTextureId);
-    // 设置该纹理ID为2D纹理
-    glBindTexture(GL_TEXTURE_2D, mTextureId);
-    // 设置该纹理的填充属性
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    LOGD(TAG, "GenTexture mTextureId error=%d", glGetError());
-    // 分配内存大小，上传纹理数据
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                 mImageRawData);
-    glBindTexture(GL_TEXTURE_2D, GL_NONE);
-    LOGD(TAG, "glTexImage2D error=%d", glGetError());
+// 按输入格式获取程序，格式变化时重新获取
+void BgRender::loadProgram(int format) {
+    std::string fragmentShader = std::string(FBO_FRAGMENT_SHADER_HEAD)
+                                 + InputTexture::GetSampleFunction(format)
+                                 + FBO_FRAGMENT_SHADER_MAIN;
+    // 从共享环境获取程序，首次使用时才会编译、链接
+    mFboProgramId = mEnv->GetProgram(FBO_VERTEX_SHADER, fragmentShader.c_str());
+    mProgramFormat = format;
+    LOGD(TAG, "GetProgram mFboProgramId=%d format=%d", mFboProgramId, mProgramFormat);
+    mTexMatrixLoc = glGetUniformLocation(mFboProgramId, "u_texMatrix");
 }
 
 void BgRender::initShader() {
@@ -299,59 +1516,7 @@ void BgRender::initShader() {
     // 绘制顺序
     GLushort indices[] = {0, 1, 2, 1, 2, 3};
 
-    // GLSL语言基础 https://my.oschina.net/sweetdark/blog/208024
-    // 顶点着色器 shader
-    const char *vShaderStr[1] = {
-            "#version 300 es                            \n"  // 声明使用OpenGLES 3.0
-            "layout(location = 0) in vec4 a_position;   \n"  // 声明输入四维向量
-            "layout(location = 1) in vec2 a_texCoord;   \n"  // 声明输入二维向量
-            "out vec2 v_texCoord;                       \n"  // 声明输出二维向量，纹理坐标
-            "void main()                                \n"
-            "{                                          \n"
-            "   gl_Position = a_position;               \n"  // 内建变量赋值，不需要变换，gl_Position描述三维空间里变换后的位置
-            "   v_texCoord = a_texCoord;                \n"  // 输出向量赋值，纹理的坐标
-            "}                                          \n"
-    };
-
-    // 用于FBO渲染的片段着色器shader，取每个像素的灰度值
-    const char *fFboShaderStr[1] = {
-            "#version 300 es                            \n"
-            "precision mediump float;                   \n"  // 设置默认的精度限定符
-            "in vec2 v_texCoord;                        \n"  // 导入纹理坐标，描述片段
-            "layout(location = 0) out vec4 outColor;    \n"  // 提供片段着色器输出变量的声明，这将是传递到下一阶段的颜色
-            "uniform sampler2D s_TextureMap;            \n"  // 声明GL_TEXTURE_2D绑定的空间变量，取出纹理数据
-            "void main()                                \n"
-            "{                                          \n"
-            "    vec4 tempColor = texture(s_TextureMap, v_texCoord);   \n" // 通过纹理和纹理坐标采样颜色值
-            "    float luminance = tempColor.r * 0.299 + tempColor.g * 0.587 + tempColor.b * 0.114;  \n"
-            "    outColor = vec4(vec3(luminance), 1.0);         \n"
-            "}"
-    };
-
-    // 创建一个顶点shader
-    mVertexShader = glCreateShader(GL_VERTEX_SHADER);
-    // 替换着色器对象的源代码
-    GLint sourceLen = strlen(vShaderStr[0]);
-    glShaderSource(mVertexShader, 1, vShaderStr, &sourceLen);
-    // 编译shader
-    glCompileShader(mVertexShader);
-
-    // 创建一个片元shader
-    mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    // 替换着色器对象的源代码
-    sourceLen = strlen(fFboShaderStr[0]);
-    glShaderSource(mFragmentShader, 1, fFboShaderStr, &sourceLen);
-    // 编译shader
-    glCompileShader(mFragmentShader);
-
-    // 创建程序
-    mFboProgramId = glCreateProgram();
-    // 绑定shader
-    glAttachShader(mFboProgramId, mVertexShader);
-    glAttachShader(mFboProgramId, mFragmentShader);
-    // 链接程序
-    glLinkProgram(mFboProgramId);
-    LOGD(TAG, "glLinkProgram error=%d", glGetError());
+    loadProgram(mInput->GetFormat());
 
     // 生成 VBO ，加载顶点数据和索引数据
     glGenBuffers(3, mVboIds);
@@ -389,89 +1554,95 @@ void BgRender::initShader() {
     LOGD(TAG, "Gen VAO error=%d", glGetError());
 }
 
-void BgRender::GetData(const signed char *addr) {
+bool BgRender::GetData(const signed char *addr) {
     LOGD(TAG, "GetData");
-    memcpy((void *) addr, mDrawData, mWidth * mHeight * 4);
+    long long begin = statsBegin();
+    if (mPboReader != nullptr) {
+        bool success = mPboReader->Fetch((void *) addr, GetDataSize());
+        if (success) {
+            statsEnd(STATS_STAGE_COPY, begin);
+        }
+        return success;
+    }
+    if (mDrawData == nullptr) {
+        LOGW(TAG, "GetData before Draw");
+        return false;
+    }
+    // 调用方按GetDataSize分配，Draw之后输出尺寸或格式变化时需要重新Draw
+    if (mDrawDataSize != GetDataSize()) {
+        LOGE(TAG, "GetData size changed since Draw, draw=%d now=%d", mDrawDataSize,
+             GetDataSize());
+        return false;
+    }
+    memcpy((void *) addr, mDrawData, mDrawDataSize);
+    statsEnd(STATS_STAGE_COPY, begin);
+    return true;
+}
+
+void BgRender::SetAsyncReadback(int bufferCount) {
+    LOGD(TAG, "SetAsyncReadback bufferCount=%d", bufferCount);
+    if (mPboReader != nullptr) {
+        // 切换模式时未取走的帧直接丢弃
+        mPboReader->Release();
+        delete mPboReader;
+        mPboReader = nullptr;
+    }
+    if (bufferCount > 0) {
+        mPboReader = new PboReader(bufferCount);
+    }
+}
+
+bool BgRender::IsDataReady() {
+    if (mPboReader != nullptr) {
+        return mPboReader->IsReady();
+    }
+    return true;
 }
 
 void BgRender::SetRotate(int type) {
     LOGD(TAG, "SetRotate type=%d", type);
-    GLfloat *replaceFboVertex;
-    switch (type) {
-        case ROTATE_0:
-            replaceFboVertex = new GLfloat[8]{
-                    0.0f, 0.0f,  // 左下
-                    1.0f, 0.0f, // 右下
-                    0.0f, 1.0f,  // 左上
-                    1.0f, 1.0f, // 右上
-            };
-            break;
-        case ROTATE_90:
-            replaceFboVertex = new GLfloat[8]{
-                    0.0f, 1.0f,
-                    0.0f, 0.0f,
-                    1.0f, 1.0f,
-                    1.0f, 0.0f,
-            };
-            break;
-        case ROTATE_180:
-            replaceFboVertex = new GLfloat[8]{
-                    1.0f, 1.0f,
-                    0.0f, 1.0f,
-                    1.0f, 0.0f,
-                    0.0f, 0.0f,
-            };
-            break;
-        case ROTATE_270:
-            replaceFboVertex = new GLfloat[8]{
-                    1.0f, 0.0f,
-                    1.0f, 1.0f,
-                    0.0f, 0.0f,
-                    0.0f, 1.0f,
-            };
-            break;
-        default:
-            return;
+    if (type < ROTATE_0 || type > ROTATE_270) {
+        return;
     }
-    // 重新载入
-    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(replaceFboVertex[0]) * 8, replaceFboVertex, GL_STATIC_DRAW);
-
-    delete replaceFboVertex;
+    // 只修改变换参数，下次绘制时以uniform传入，不再重写纹理坐标VBO
+    mRotate = type;
+    mMirror = MIRROR_NONE;
+    mUseAffine = false;
 }
 
 void BgRender::SetMirrorType(int type) {
     LOGD(TAG, "SetMirrorType type=%d", type);
-    GLfloat *replaceFboVertex;
-    switch (type) {
-        case MIRROR_HORIZONTAL:
-            replaceFboVertex = new GLfloat[8]{
-                    1.0f, 0.0f, // 右下
-                    0.0f, 0.0f,  // 左下
-                    1.0f, 1.0f, // 右上
-                    0.0f, 1.0f,  // 左上
-            };
-            break;
-        case MIRROR_VERTICAL:
-            replaceFboVertex = new GLfloat[8]{
-                    0.0f, 1.0f,
-                    1.0f, 1.0f,
-                    0.0f, 0.0f,
-                    1.0f, 0.0f,
-            };
-            break;
-        case MIRROR_NONE:
-        default:
-            replaceFboVertex = new GLfloat[8]{
-                    0.0f, 0.0f,  // 左下
-                    1.0f, 0.0f, // 右下
-                    0.0f, 1.0f,  // 左上
-                    1.0f, 1.0f, // 右上
-            };
-    }
-    // 重新载入
-    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(replaceFboVertex[0]) * 8, replaceFboVertex, GL_STATIC_DRAW);
+    mMirror = type == MIRROR_HORIZONTAL || type == MIRROR_VERTICAL ? type : MIRROR_NONE;
+    mRotate = ROTATE_0;
+    mUseAffine = false;
+}
 
-    delete replaceFboVertex;
-}
\ No newline at end of file
+void BgRender::SetTransform(int cropX, int cropY, int cropWidth, int cropHeight, int rotate,
+                            int mirror, int outWidth, int outHeight) {
+    LOGD(TAG, "SetTransform crop=(%d, %d, %d, %d) rotate=%d mirror=%d out=%dx%d", cropX, cropY,
+         cropWidth, cropHeight, rotate, mirror, outWidth, outHeight);
+    mCropX = cropX;
+    mCropY = cropY;
+    mCropWidth = cropWidth;
+    mCropHeight = cropHeight;
+    mRotate = rotate >= ROTATE_0 && rotate <= ROTATE_270 ? rotate : ROTATE_0;
+    mMirror = mirror == MIRROR_HORIZONTAL || mirror == MIRROR_VERTICAL ? mirror : MIRROR_NONE;
+    mUseAffine = false;
+    mRequestWidth = outWidth > 0 && outHeight > 0 ? outWidth : 0;
+    mRequestHeight = outWidth > 0 && outHeight > 0 ? outHeight : 0;
+}
+
+void BgRender::SetScaleQuality(int quality) {
+    LOGD(TAG, "SetScaleQuality quality=%d", quality);
+    mScaleQuality = quality == SCALE_QUALITY_BICUBIC || quality == SCALE_QUALITY_LANCZOS
+                    ? quality : SCALE_QUALITY_BILINEAR;
+}
+
+void BgRender::SetAffineTransform(const float *matrix, int outWidth, int outHeight) {
+    LOGD(TAG, "SetAffineTransform [%f %f %f, %f %f %f] out=%dx%d", matrix[0], matrix[1],
+         matrix[2], matrix[3], matrix[4], matrix[5], outWidth, outHeight);
+    memcpy(mAffine, matrix, sizeof(mAffine));
+    mUseAffine = true;
+    mRequestWidth = outWidth > 0 && outHeight > 0 ? outWidth : -1;
+    mRequestHeight = outWidth > 0 && outHeight > 0 ? outHeight : -1;
+}
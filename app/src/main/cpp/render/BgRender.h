@@ -7,6 +7,20 @@
 
 #include <EGL/egl.h>
 #include <GLES3/gl3.h>
+#include "GlesEnv.h"
+#include "PboReader.h"
+#include "FilterChain.h"
+#include "CpuRender.h"
+#include "TexTransform.h"
+#include "InputTexture.h"
+#include "YuvPacker.h"
+#include "BlankDetector.h"
+#include "RenderStats.h"
+#include "OverlayCompositor.h"
+#include "Downscaler.h"
+#include "ResultCache.h"
+#include "BufferPool.h"
+#include "MotionDetector.h"
 
 #define ROTATE_0 0
 #define ROTATE_90 1
@@ -17,23 +31,48 @@
 #define MIRROR_HORIZONTAL 1
 #define MIRROR_VERTICAL 2
 
+// 按图像大小自动选择，小图且没有滤镜时走CPU
+#define ENGINE_AUTO 0
+#define ENGINE_GPU 1
+#define ENGINE_CPU 2
+
+// DrawTiled默认的分块边长，单位为输出像素
+#define DEFAULT_TILE_SIZE 1024
+
+// DrawMultiple的输出种类
+// 变换后的彩色RGBA，每像素4字节
+#define MULTI_OUTPUT_COLOR 0
+// 变换后的灰度，每像素1字节
+#define MULTI_OUTPUT_GRAY 1
+// 彩色RGBA半尺寸预览，宽高为(输出宽高 + 1) / 2
+#define MULTI_OUTPUT_PREVIEW 2
+
+// 默认的CPU引擎像素数阈值，256x256以下的图像EGL/GL开销大于计算本身
+#define DEFAULT_CPU_THRESHOLD (256 * 256)
+
 /**
  * 图片离屏渲染器示例，OpenGLES版本3.0
- * 1. 创建EGL环境
- * 2. 载入RGBA图片作为纹理
- * 3. 提供灰度图、90度旋转、镜像等实现示例
+ * 1. 获取共享的EGL环境，见GlesEnv
+ * 2. 载入RGBA或NV21/NV12/I420图片作为纹理，YUV在shader中转换为RGB
+ * 3. 提供灰度图、90度旋转、镜像等实现示例，旋转、镜像、裁剪、缩放合成一个变换矩阵在同一次绘制中完成
+ * 4. 输出RGBA，或在GPU上打包为NV21/NV12/I420直接送入编码器，或单通道灰度/RGB565/RGB减少读取量
+ * 5. 分析模式：白屏检测，只读回颜色统计结果，见BlankDetector
+ * 6. 可选的分阶段耗时统计，见RenderStats
+ * 7. 超过GL_MAX_TEXTURE_SIZE的长图分块渲染，见DrawTiled
+ * 8. 水印、贴纸等多图层叠加，图集 + 实例化绘制，见OverlayCompositor
+ * 9. 高质量缩小（金字塔 + 双三次/Lanczos）与一次上传生成多个缩略图，见Downscaler
+ * 10. 可选的结果缓存，相同输入与设置的重复绘制只拷贝缓存的结果，见ResultCache
+ * 11. 只渲染、读取输出中的若干矩形区域，多个区域一次提交，见DrawRegions
+ * 12. 多渲染目标：一次绘制同时得到彩色、灰度与半尺寸预览，见DrawMultiple
+ * 13. 连续帧运动检测，上一帧常驻GPU，只读回变化区域与变化像素数，见MotionDetector
  * */
 class BgRender {
 
 private:
-    // Display 对象
-    EGLDisplay mEglDisplay;
-    // config信息
-    EGLConfig mEglConfig;
-    // 渲染绘制表面
-    EGLSurface mEglSurface;
-    // 渲染上下文
-    EGLContext mEglContext;
+    // 共享的EGL环境，多个BgRender复用同一个上下文与已链接的程序
+    GlesEnv *mEnv;
+    // mEnv是否由GlesEnv::Acquire获取，需在DestroyGlesEnv时归还
+    bool mAcquiredEnv;
 
     // 背景的宽高
     unsigned int mWidth;
@@ -47,15 +86,26 @@ private:
     void createFBO();
     // 初始化OpenGL shader
     void initShader();
-    // 纹理贴图
-    GLuint mTextureId;
+    // 按输入格式获取FBO渲染程序
+    void loadProgram(int format);
+    // 渲染到FBO
+    void render();
+    // 按指定的输入纹理与采样坐标变换渲染到FBO，FBO按width x height分配
+    void renderInput(InputTexture *input, const GLfloat *transform, int width, int height);
+    // 同renderInput，quality不是SCALE_QUALITY_BILINEAR时先经过Downscaler重采样
+    void renderScaled(InputTexture *input, const GLfloat *transform, int width, int height,
+                      int quality);
+    // 原图纹理，RGBA或YUV的各个平面
+    InputTexture *mInput;
+    // 分块渲染时当前块对应的原图区域，只在DrawTiled中使用
+    InputTexture *mTileInput;
+    // 原图格式，IMAGE_FORMAT_RGBA 等
+    int mImageFormat;
+    // mFboProgramId对应的输入格式
+    int mProgramFormat;
 
-    // FBO渲染程序id
+    // FBO渲染程序id，由GlesEnv缓存，不在此释放
     GLuint mFboProgramId;
-    // 顶点shader
-    GLuint mVertexShader;
-    // 片元shader
-    GLuint mFragmentShader;
     // VBO IDs Vertex Buffer Object 顶点缓冲区对象
     GLuint* mVboIds;
     // VAO ID Vertex Array Object 顶点数组对象
@@ -63,35 +113,400 @@ private:
     // 高效地实现在顶点数组配置之间切换。
     GLuint mVaoId;
 
-    // 原图数据
+    // 原图数据，指向调用方内存，只在CreateGlesEnv上传纹理期间有效
     const GLbyte *mImageRawData;
 
-    // 绘制后的数据
+    // 绘制后的数据，仅Draw+GetData方式使用，按需从BufferPool分配
     GLbyte *mDrawData;
+    // mDrawData已分配的字节数
+    int mDrawDataSize;
+
+    // 滤镜链，为空时使用默认的灰度shader
+    FilterChain *mFilterChain;
+
+    // 当前的旋转、镜像、裁剪区域，合成为一个采样坐标变换，见computeTransform
+    int mRotate;
+    int mMirror;
+    int mCropX;
+    int mCropY;
+    int mCropWidth;
+    int mCropHeight;
+    // 调用方直接指定的仿射变换，设置后忽略上面的旋转、镜像、裁剪
+    GLfloat mAffine[TEX_TRANSFORM_SIZE];
+    bool mUseAffine;
+    // 指定的输出尺寸，>0为指定值，0为变换后的自然尺寸，<0与原图一致（旧接口的行为）
+    int mRequestWidth;
+    int mRequestHeight;
+    // FBO纹理当前分配的尺寸
+    int mFboWidth;
+    int mFboHeight;
+    // 批量渲染多个区域时FBO只增大，不随每个区域重新分配
+    bool mFboGrowOnly;
+    // 区域、多输出批量读取共用的PBO，所有读取提交后只映射一次
+    GLuint mBatchPboId;
+    GLsizeiptr mBatchPboSize;
+    // 绑定mBatchPboId，容量不足size字节时重新分配
+    void bindBatchPbo(GLsizeiptr size);
+    // 多输出模式的灰度结果，R8，绘制时作为mFboId的第二个颜色附着
+    GLuint mGrayTextureId;
+    int mGrayWidth;
+    int mGrayHeight;
+    // 半尺寸预览，由mFboId的彩色结果缩小得到
+    GLuint mPreviewTextureId;
+    GLuint mPreviewFboId;
+    int mPreviewWidth;
+    int mPreviewHeight;
+    // 多输出渲染程序，由GlesEnv缓存
+    GLuint mMultiProgramId;
+    int mMultiProgramFormat;
+    GLint mMultiTexMatrixLoc;
+    // 按变换一次绘制同时写入彩色与灰度附着，writeColor、writeGray为false的附着不写入
+    bool renderMultiple(const GLfloat *transform, int width, int height, bool writeColor,
+                        bool writeGray);
+    // 将mFboId左下角width x height的彩色结果缩小到预览FBO
+    void blitPreview(int width, int height);
+    GLint mTexMatrixLoc;
+
+    // 计算输出 -> 原图的采样坐标变换以及变换后的尺寸
+    void computeTransform(GLfloat *matrix, int *width, int *height);
+    // FBO纹理与变换后的尺寸不一致时重新分配
+    void ensureFboSize(int width, int height);
+    // CPU引擎按当前变换输出
+    void renderCpu(uint8_t *dst);
+
+    // 异步读取，为nullptr时Draw内同步glReadPixels
+    PboReader *mPboReader;
+
+    // 输出格式，IMAGE_FORMAT_RGBA 等
+    int mOutputFormat;
+    // 非RGBA输出时的打包pass
+    YuvPacker *mYuvPacker;
+    // 白屏检测，需要OpenGL ES 3.1
+    BlankDetector *mBlankDetector;
+    // 运动检测，持有上一帧的亮度
+    MotionDetector *mMotionDetector;
+    // 叠加图层，在变换与滤镜之后混合到输出上
+    OverlayCompositor *mOverlay;
+    // 高质量缩放，金字塔在输入变化时失效
+    Downscaler *mDownscaler;
+    // SCALE_QUALITY_BILINEAR 等
+    int mScaleQuality;
+    // 渲染结果读取到addr，非RGBA输出时先打包，异步读取模式下addr为nullptr
+    void readOutput(void *addr);
+    // GPU渲染并读取，addr同readOutput
+    void renderAndRead(void *addr);
+    // 先查结果缓存，未命中时按引擎渲染并读取，再放入缓存，addr同readOutput
+    void drawCached(bool cpu, void *addr);
+
+    // 当前输入像素的哈希，只在开启结果缓存时计算
+    unsigned long long mInputHash;
+    bool mInputHashed;
+    void hashInput(const char *imageData, int format, unsigned int width, unsigned int height);
+    // 输入哈希与所有影响输出的参数合成缓存key，异步读取、有叠加图层或未开启缓存时返回false
+    bool resultKey(bool cpu, unsigned long long *key);
+
+    // 耗时统计，未开启时为nullptr
+    RenderStats *mStats;
+    // 阶段开始时间，未开启统计时不读时钟
+    long long statsBegin();
+    void statsEnd(int stage, long long begin);
+
+    // CPU引擎，持有原图拷贝
+    CpuRender *mCpuRender;
+    // ENGINE_AUTO 等
+    int mEngine;
+    // 自动模式下，像素数不超过该值时走CPU
+    int mCpuThreshold;
+    // 最近一次绘制使用的引擎
+    int mLastEngine;
+
+    // CPU引擎需要原图拷贝时保留一份
+    void keepCpuFrame(const char *imageData);
+
+    // 本次绘制是否走CPU
+    bool useCpu();
 
 public:
 
-    // 构造函数
-    BgRender(unsigned int width, unsigned int height, const char *imageData);
+    /**
+     * 构造函数，imageData不会被拷贝，需保证在CreateGlesEnv返回前有效
+     *
+     * @param format IMAGE_FORMAT_RGBA 等，YUV格式需要GL环境，不支持CPU引擎
+     * */
+    BgRender(unsigned int width, unsigned int height, const char *imageData,
+             int format = IMAGE_FORMAT_RGBA);
 
     // 析构函数
     ~BgRender();
 
-    // 创建OpenGL ES运行环境
-    void CreateGlesEnv();
+    /**
+     * 获取OpenGL ES运行环境并创建本实例的纹理、FBO等资源，失败返回false
+     *
+     * @param env 为nullptr时使用进程内共享的环境；否则使用指定的工作上下文（见GlesEnv::CreateShared），
+     *            之后本实例只能在该上下文绑定的线程使用
+     * */
+    bool CreateGlesEnv(GlesEnv *env = nullptr);
 
-    // 获取绘制后的数据
-    void GetData(const signed char *addr);
+    // 获取绘制后的数据，addr需容纳GetDataSize字节，异步读取模式下取出最早一帧；
+    // 没有可取的帧、Draw之后输出尺寸或格式变化（异步模式下为该帧大于GetDataSize）时返回false
+    bool GetData(const signed char *addr);
 
     // 开始渲染
     void Draw();
 
-    // 设置旋转角度
+    /**
+     * 渲染并直接读取到调用方内存，不经过mDrawData中转
+     *
+     * @param addr 输出地址，大小至少为GetDataSize()
+     * */
+    void DrawTo(const signed char *addr);
+
+    /**
+     * 分块渲染一张RGBA图像，用于超过GL_MAX_TEXTURE_SIZE或整图占用内存过大的长图（如整页截图）
+     * 按输出分块，每块只上传其依赖的原图区域（含滤镜邻域），渲染后直接写入addr对应的位置，
+     * 纹理、FBO、滤镜中间结果都只按分块大小分配，峰值显存与图像大小无关。
+     * 使用当前的变换与滤镜，不支持裁剪滤镜与非RGBA输出；同步读取，不经过异步读取与中间缓冲区。
+     * 不改变当前帧，之后的Draw仍使用UpdateFrame输入的图像。
+     *
+     * @param imageData RGBA原图，大小为width * height * 4，不会被拷贝
+     * @param addr 输出地址，大小为按width、height计算的输出尺寸 * 4
+     * @param capacity addr的字节数，不足时返回false
+     * @param tileSize 分块边长，单位为输出像素，<=0时使用DEFAULT_TILE_SIZE，会按纹理尺寸上限缩小
+     * @return 没有GL环境、输出格式或滤镜不支持、capacity不足时返回false
+     * */
+    bool DrawTiled(unsigned int width, unsigned int height, const char *imageData,
+                   const signed char *addr, long long capacity, int tileSize = 0);
+
+    /**
+     * 一次生成多个缩略图，使用当前的裁剪、旋转、镜像与滤镜，输出尺寸依次为sizes中的宽高，
+     * 金字塔只建一次。不叠加图层，不支持裁剪滤镜与非RGBA输出
+     *
+     * @param sizes 依次为每个缩略图的宽、高，长度为count * 2
+     * @param quality SCALE_QUALITY_BILINEAR 等
+     * @param addr 输出地址，各缩略图的RGBA数据依次排列
+     * @param capacity addr的字节数，不足时返回false
+     * @return 没有GL环境、输出格式或滤镜不支持、尺寸无效或capacity不足时返回false
+     * */
+    bool DrawThumbnails(const int *sizes, int count, int quality, const signed char *addr,
+                        long long capacity);
+
+    /**
+     * 只渲染并读取输出中的若干矩形区域，使用当前的变换、滤镜、缩放质量与叠加图层，
+     * 每个区域只按自身大小（含滤镜邻域）绘制，结果与整图渲染后截取一致（高质量缩放时有采样坐标的舍入误差）。
+     * 所有区域的读取进入同一个PBO，全部提交后只等待一次GPU，适合每帧很多个小区域。
+     * 不支持裁剪滤镜与非RGBA输出
+     *
+     * @param rects 依次为每个区域的x、y、宽、高，单位为输出像素，原点为输出数据的第一行第一列，长度为count * 4
+     * @param addr 输出地址，各区域的RGBA数据紧密排列（每行宽 * 4字节），依次存放
+     * @param capacity addr的字节数，不足时返回false
+     * @return 没有GL环境、输出格式或滤镜不支持、区域超出输出范围或capacity不足时返回false
+     * */
+    bool DrawRegions(const int *rects, int count, const signed char *addr, long long capacity);
+
+    /**
+     * 一次绘制得到同一输入的多个派生结果：彩色与灰度作为mFboId的两个颜色附着，
+     * 由同一个片段着色器通过glDrawBuffers同时写入，半尺寸预览再由彩色附着glBlitFramebuffer缩小，
+     * 所有结果进入同一个PBO，只等待一次GPU。
+     * 使用当前的变换与缩放质量，不经过滤镜与叠加图层，与输出格式无关
+     *
+     * @param outputs MULTI_OUTPUT_COLOR 等，按顺序输出，可以重复
+     * @param addr 输出地址，各结果紧密排列（每行宽 * 每像素字节数），依次存放，大小见GetMultipleDataSize
+     * @param capacity addr的字节数，不足时返回false
+     * @return 没有GL环境、种类无效或capacity不足时返回false
+     * */
+    bool DrawMultiple(const int *outputs, int count, const signed char *addr, long long capacity);
+
+    // DrawMultiple按当前变换输出的总字节数，种类无效时返回-1
+    long long GetMultipleDataSize(const int *outputs, int count);
+
+    // 输出数据的字节数
+    int GetDataSize();
+
+    /**
+     * 流式输入新的一帧，复用当前的纹理与FBO
+     * 格式与尺寸不变时只上传像素，变化时才重新分配纹理内存
+     *
+     * @param imageData 图像数据，不会被拷贝，大小见InputTexture::GetDataSize
+     * @param format IMAGE_FORMAT_RGBA 等
+     * @return 尚未CreateGlesEnv、格式未知或没有GL环境时输入YUV返回false
+     * */
+    bool UpdateFrame(unsigned int width, unsigned int height, const char *imageData,
+                     int format = IMAGE_FORMAT_RGBA);
+
+    /**
+     * YUV输入转RGB使用的标准，默认BT.601全范围（Android相机）
+     *
+     * @param standard YUV_STANDARD_BT601 等
+     * @param fullRange false为16~235的视频范围
+     * */
+    void SetYuvColorSpace(int standard, bool fullRange);
+
+    /**
+     * 设置输出格式，YUV输出在GPU上完成转换与平面排列，读取到的数据可直接送入编码器
+     * 灰度、RGB565、RGB输出同样在GPU上按字节打包，只读取目标格式的字节数
+     * 非RGBA输出总是走GPU引擎，YUV的颜色标准与SetYuvColorSpace一致
+     *
+     * @param format IMAGE_FORMAT_RGBA 等
+     * @return 格式未知时返回false
+     * */
+    bool SetOutputFormat(int format);
+
+    /**
+     * 白屏检测，统计原图[startHeight, endHeight)行的颜色直方图与纯白像素数，不经过变换与滤镜
+     *
+     * @param result 长度为BLANK_RESULT_SIZE，见BLANK_RESULT_PIXELS 等
+     * @return 没有GL环境、不支持计算着色器或行范围为空时返回false
+     * */
+    bool DetectBlank(int startHeight, int endHeight, int *result);
+
+    /**
+     * 运动检测，比较当前帧与上一次检测时的帧，不经过变换与滤镜，之后当前帧成为上一帧
+     * 流式输入时每次UpdateFrame后调用一次，输入尺寸或格式变化后重新开始
+     *
+     * @param result 长度为MOTION_RESULT_SIZE，见MOTION_RESULT_VALID 等
+     * @param mask 不为nullptr时读取变化掩码，每像素1字节，变化为255，大小为原图宽 * 高
+     * @param capacity mask的字节数，不足时返回false
+     * @return 没有GL环境或mask的capacity不足时返回false
+     * */
+    bool DetectMotion(int *result, const signed char *mask = nullptr, long long capacity = 0);
+
+    /**
+     * 设置运动检测的阈值
+     *
+     * @param threshold 亮度差超过该值视为变化，0~255，默认MOTION_DEFAULT_THRESHOLD
+     * @param tilePixels MOTION_TILE_SIZE分块中变化像素少于该值时不计入区域，默认MOTION_DEFAULT_TILE_PIXELS
+     * */
+    void SetMotionThreshold(int threshold, int tilePixels);
+
+    // 丢弃运动检测保存的上一帧
+    void ResetMotion();
+
+    /**
+     * 上传一张叠加图像（水印、贴纸）到图集，同一图像可被多个图层引用
+     *
+     * @param imageData RGBA，大小为width * height * 4，上传后不再使用
+     * @param premultiplied 数据是否已预乘alpha，否则上传时预乘
+     * @return 图像id，没有GL环境或图集放不下时返回-1
+     * */
+    int AddOverlayImage(int width, int height, const char *imageData, bool premultiplied);
+
+    /**
+     * 追加一个叠加图层，按追加顺序从下往上混合到输出上，设置了图层时总是走GPU引擎
+     *
+     * @param image AddOverlayImage返回的图像id
+     * @param x 左上角位置，单位为输出像素，原点为输出数据的第一行第一列
+     * @param scale 相对图像原始尺寸的缩放
+     * @param opacity 不透明度[0, 1]
+     * @param blend OVERLAY_BLEND_NORMAL 等
+     * @return 图像id或混合方式无效时返回false
+     * */
+    bool AddOverlay(int image, float x, float y, float scale, float opacity, int blend);
+
+    /**
+     * 清空叠加图层
+     *
+     * @param clearImages 同时清空已上传的图像，之前的图像id失效
+     * */
+    void ClearOverlays(bool clearImages);
+
+    /**
+     * 设置异步读取模式
+     * 开启后Draw只提交读取命令，不等待GPU，GetData时才等待并映射最早完成的一帧
+     *
+     * @param bufferCount PBO环形队列长度，<=0 关闭异步读取
+     * */
+    void SetAsyncReadback(int bufferCount);
+
+    // 异步读取模式下，最早一帧是否已可读取，不阻塞
+    bool IsDataReady();
+
+    /**
+     * 追加一个滤镜，设置了滤镜后不再使用默认的灰度shader
+     * 相邻的逐像素滤镜会合并成一次绘制，模糊等卷积滤镜分水平、垂直两次计算，见FilterChain
+     *
+     * @param type FILTER_GRAYSCALE 等
+     * @return 尚未CreateGlesEnv或类型未知时返回false
+     * */
+    bool AddFilter(int type, const float *params, int paramCount);
+
+    // 清空滤镜，恢复默认的灰度shader
+    void ClearFilters();
+
+    // 当前滤镜链合并后的绘制趟数
+    int GetFilterPassCount();
+
+    /**
+     * 模糊等卷积滤镜是否允许使用计算着色器，默认允许，关闭后使用片元着色器，用于对比两条路径
+     * 不支持OpenGL ES 3.1时总是使用片元着色器
+     * */
+    void SetFilterComputeEnabled(bool enabled);
+
+    /**
+     * 选择渲染引擎
+     * CPU引擎只支持默认的灰度 + 变换，设置了滤镜或开启异步读取时仍走GPU。
+     * 大图默认不保留原图拷贝，切换为ENGINE_CPU后需通过UpdateFrame重新输入图像。
+     *
+     * @param engine ENGINE_AUTO 等
+     * */
+    void SetEngine(int engine);
+
+    // 自动模式下走CPU的像素数阈值
+    void SetCpuThreshold(int pixelCount);
+
+    // 最近一次绘制使用的引擎，ENGINE_GPU 或 ENGINE_CPU
+    int GetLastEngine();
+
+    // 设置旋转角度，同时清除镜像，输出尺寸不变
     void SetRotate(int type);
 
+    // 设置镜像类型，同时清除旋转，输出尺寸不变
     void SetMirrorType(int type);
 
-    // 销毁OpenGL ES运行环境
+    /**
+     * 设置组合变换：先裁剪，再旋转，再镜像，最后缩放到输出尺寸，一次绘制完成
+     *
+     * @param cropWidth 裁剪区域，单位为像素，宽或高<=0时不裁剪
+     * @param rotate ROTATE_0 等
+     * @param mirror MIRROR_NONE 等
+     * @param outWidth 输出尺寸，<=0时使用变换后的自然尺寸（旋转90/270度时宽高互换）
+     * */
+    void SetTransform(int cropX, int cropY, int cropWidth, int cropHeight, int rotate, int mirror,
+                      int outWidth, int outHeight);
+
+    /**
+     * 设置缩放质量，非SCALE_QUALITY_BILINEAR时总是走GPU引擎，每帧多一趟重采样与log2(缩小倍数)趟金字塔。
+     * DrawTiled不受影响
+     *
+     * @param quality SCALE_QUALITY_BILINEAR 等
+     * */
+    void SetScaleQuality(int quality);
+
+    /**
+     * 直接设置仿射变换
+     *
+     * @param matrix 输出 -> 原图的归一化采样坐标变换，2x3行优先，见TexTransform.h
+     * @param outWidth 输出尺寸，<=0时与原图一致
+     * */
+    void SetAffineTransform(const float *matrix, int outWidth, int outHeight);
+
+    // 输出尺寸，变换与裁剪滤镜都会改变输出尺寸
+    void GetOutputSize(int *width, int *height);
+
+    /**
+     * 开启或关闭分阶段耗时统计，关闭时清空已有样本
+     * 没有计时查询扩展时，GPU阶段通过fence等待计时，开启期间绘制会变为同步
+     * */
+    void SetStatsEnabled(bool enabled);
+
+    /**
+     * 读取耗时统计
+     *
+     * @param result 长度为STATS_RESULT_SIZE，见STATS_RESULT_GPU_TIMER 等
+     * @return 未开启统计时返回false
+     * */
+    bool GetStats(long long *result);
+
+    // 释放本实例的GL资源，归还共享的OpenGL ES运行环境
     void DestroyGlesEnv();
 
 };
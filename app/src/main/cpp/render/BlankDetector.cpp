@@ -0,0 +1,206 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "BlankDetector.h"
+#include <string>
+#include "myutils.h"
+
+#define TAG "BlankDetector"
+
+// 工作组16x16个线程，每个线程4x4个像素，一个工作组覆盖64x64像素
+#define GROUP_SIZE 16
+#define THREAD_PIXELS 4
+#define GROUP_PIXELS (GROUP_SIZE * THREAD_PIXELS)
+
+// 全局计数缓冲区：白色计数 + 直方图
+#define COUNTER_SIZE (1 + BLANK_HISTOGRAM_BINS)
+
+static const char *DETECT_SHADER_HEAD =
+        "#version 310 es\n"
+        "precision highp float;\n"
+        "precision highp int;\n"
+        "layout(local_size_x = 16, local_size_y = 16) in;\n"
+        "layout(std430, binding = 0) buffer Counter {\n"
+        "    uint white;\n"
+        "    uint histogram[64];\n"
+        "} counter;\n"
+        "uniform ivec4 u_region;\n"  // xy：图像宽高，zw：起止行
+        "shared uint sWhite[256];\n"
+        "shared uint sHistogram[64];\n";
+
+static const char *DETECT_SHADER_MAIN =
+        "void main()\n"
+        "{\n"
+        "    uint local = gl_LocalInvocationIndex;\n"
+        "    if (local < 64u) {\n"
+        "        sHistogram[local] = 0u;\n"
+        "    }\n"
+        "    barrier();\n"
+        // 第1级：线程内统计4x4像素，连续落在同一个桶的像素合并为一次原子操作
+        "    ivec2 origin = ivec2(gl_GlobalInvocationID.xy) * 4 + ivec2(0, u_region.z);\n"
+        "    uint white = 0u;\n"
+        "    uint runBin = 0u;\n"
+        "    uint runCount = 0u;\n"
+        "    for (int dy = 0; dy < 4; dy++) {\n"
+        "        int y = origin.y + dy;\n"
+        "        for (int dx = 0; dx < 4; dx++) {\n"
+        "            int x = origin.x + dx;\n"
+        "            if (x >= u_region.x || y >= u_region.w) {\n"
+        "                continue;\n"
+        "            }\n"
+        "            vec2 coord = (vec2(x, y) + 0.5) / vec2(u_region.xy);\n"
+        "            uvec3 c = uvec3(clamp(sampleSource(coord).rgb, 0.0, 1.0) * 255.0 + 0.5);\n"
+        "            if (all(equal(c, uvec3(255u)))) {\n"
+        "                white++;\n"
+        "            }\n"
+        "            uint bin = (c.r >> 6u) << 4u | (c.g >> 6u) << 2u | (c.b >> 6u);\n"
+        "            if (runCount > 0u && bin != runBin) {\n"
+        "                atomicAdd(sHistogram[runBin], runCount);\n"
+        "                runCount = 0u;\n"
+        "            }\n"
+        "            runBin = bin;\n"
+        "            runCount++;\n"
+        "        }\n"
+        "    }\n"
+        "    if (runCount > 0u) {\n"
+        "        atomicAdd(sHistogram[runBin], runCount);\n"
+        "    }\n"
+        // 第2级：工作组内二分归约白色计数
+        "    sWhite[local] = white;\n"
+        "    barrier();\n"
+        "    for (uint stride = 128u; stride > 0u; stride >>= 1u) {\n"
+        "        if (local < stride) {\n"
+        "            sWhite[local] += sWhite[local + stride];\n"
+        "        }\n"
+        "        barrier();\n"
+        "    }\n"
+        // 第3级：每个工作组只提交一次
+        "    if (local == 0u && sWhite[0] > 0u) {\n"
+        "        atomicAdd(counter.white, sWhite[0]);\n"
+        "    }\n"
+        "    if (local < 64u && sHistogram[local] > 0u) {\n"
+        "        atomicAdd(counter.histogram[local], sHistogram[local]);\n"
+        "    }\n"
+        "}\n";
+
+BlankDetector::BlankDetector(GlesEnv *env) {
+    mEnv = env;
+    mProgramId = 0;
+    mProgramFormat = -1;
+    mRegionLoc = -1;
+    mBufferId = 0;
+    mCompute = nullptr;
+}
+
+BlankDetector::~BlankDetector() {
+    LOGD(TAG, "BlankDetector un constructor");
+}
+
+bool BlankDetector::ensureProgram(int format) {
+    if (mProgramId != 0 && mProgramFormat == format) {
+        return true;
+    }
+    if (mCompute == nullptr) {
+        mCompute = mEnv->LoadComputeFunctions();
+        if (mCompute == nullptr) {
+            LOGE(TAG, "compute shader not supported");
+            return false;
+        }
+    }
+    std::string shader = std::string(DETECT_SHADER_HEAD)
+                         + InputTexture::GetSampleFunction(format)
+                         + DETECT_SHADER_MAIN;
+    mProgramId = mEnv->GetComputeProgram(shader.c_str());
+    if (mProgramId == 0) {
+        return false;
+    }
+    mProgramFormat = format;
+    mRegionLoc = glGetUniformLocation(mProgramId, "u_region");
+    if (mBufferId == 0) {
+        glGenBuffers(1, &mBufferId);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, mBufferId);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, COUNTER_SIZE * sizeof(GLuint), nullptr,
+                     GL_DYNAMIC_READ);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, GL_NONE);
+    }
+    return true;
+}
+
+bool BlankDetector::Detect(InputTexture *input, int startHeight, int endHeight, int *result) {
+    int width = input->GetWidth();
+    int height = input->GetHeight();
+    if (startHeight < 0) {
+        startHeight = 0;
+    }
+    if (endHeight > height) {
+        endHeight = height;
+    }
+    if (width <= 0 || startHeight >= endHeight) {
+        LOGE(TAG, "Detect empty region start=%d end=%d height=%d", startHeight, endHeight, height);
+        return false;
+    }
+    if (!ensureProgram(input->GetFormat())) {
+        return false;
+    }
+
+    GLuint zero[COUNTER_SIZE] = {0};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, mBufferId);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), zero);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mBufferId);
+
+    glUseProgram(mProgramId);
+    glUniform4i(mRegionLoc, width, height, startHeight, endHeight);
+    input->Bind(mProgramId);
+    mCompute->dispatchCompute((width + GROUP_PIXELS - 1) / GROUP_PIXELS,
+                     (endHeight - startHeight + GROUP_PIXELS - 1) / GROUP_PIXELS, 1);
+    // 计数结果通过映射缓冲区读取
+    mCompute->memoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    const GLuint *counter = (const GLuint *) glMapBufferRange(
+            GL_SHADER_STORAGE_BUFFER, 0, COUNTER_SIZE * sizeof(GLuint), GL_MAP_READ_BIT);
+    if (counter == nullptr) {
+        LOGE(TAG, "glMapBufferRange error=%d", glGetError());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, GL_NONE);
+        return false;
+    }
+    result[BLANK_RESULT_PIXELS] = width * (endHeight - startHeight);
+    result[BLANK_RESULT_WHITE] = (int) counter[0];
+    for (int i = 0; i < BLANK_HISTOGRAM_BINS; i++) {
+        result[BLANK_RESULT_HISTOGRAM + i] = (int) counter[1 + i];
+    }
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, GL_NONE);
+
+    // 纯白也计入最后一个桶，选主色时先去掉，否则白色页面上抗锯齿的近白像素会让该桶总是不少于纯白
+    int whiteBin = BLANK_HISTOGRAM_BINS - 1;
+    int dominant = whiteBin;
+    int dominantCount = result[BLANK_RESULT_HISTOGRAM + whiteBin] - result[BLANK_RESULT_WHITE];
+    for (int i = 0; i < whiteBin; i++) {
+        if (result[BLANK_RESULT_HISTOGRAM + i] > dominantCount) {
+            dominant = i;
+            dominantCount = result[BLANK_RESULT_HISTOGRAM + i];
+        }
+    }
+
+    // 桶的中心颜色，每通道64级中取中间值
+    int r = (dominant >> 4 & 3) * 64 + 32;
+    int g = (dominant >> 2 & 3) * 64 + 32;
+    int b = (dominant & 3) * 64 + 32;
+    result[BLANK_RESULT_DOMINANT_COLOR] = (int) (0xFF000000u | r << 16 | g << 8 | b);
+    result[BLANK_RESULT_DOMINANT_COUNT] = dominantCount;
+    LOGD(TAG, "Detect pixels=%d white=%d dominant=%d count=%d", result[BLANK_RESULT_PIXELS],
+         result[BLANK_RESULT_WHITE], dominant, result[BLANK_RESULT_DOMINANT_COUNT]);
+    return true;
+}
+
+void BlankDetector::Release() {
+    LOGD(TAG, "Release");
+    if (mBufferId != 0) {
+        glDeleteBuffers(1, &mBufferId);
+        mBufferId = 0;
+    }
+    // 程序由GlesEnv缓存
+    mProgramId = 0;
+    mProgramFormat = -1;
+}
@@ -0,0 +1,73 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_BLANKDETECTOR_H
+#define GLLEARNING_BLANKDETECTOR_H
+
+#include <GLES3/gl3.h>
+#include "GlesEnv.h"
+#include "InputTexture.h"
+
+// 颜色直方图每通道取高2位，共64个桶
+#define BLANK_HISTOGRAM_BINS 64
+
+// 检测结果下标
+// 参与统计的像素数
+#define BLANK_RESULT_PIXELS 0
+// 纯白（255, 255, 255）像素数
+#define BLANK_RESULT_WHITE 1
+// 像素最多的桶的中心颜色，ARGB，比较时最后一个桶不含纯白像素
+#define BLANK_RESULT_DOMINANT_COLOR 2
+// 像素最多的桶的像素数，为最后一个桶时不含纯白像素
+#define BLANK_RESULT_DOMINANT_COUNT 3
+// 之后为BLANK_HISTOGRAM_BINS个桶的像素数，桶下标 = r >> 6 << 4 | g >> 6 << 2 | b >> 6
+#define BLANK_RESULT_HISTOGRAM 4
+#define BLANK_RESULT_SIZE (BLANK_RESULT_HISTOGRAM + BLANK_HISTOGRAM_BINS)
+
+/**
+ * 白屏检测，在GPU上统计指定行范围内的颜色直方图与纯白像素数，只读回几十个整数
+ *
+ * 计算着色器分三级归约：
+ * 1. 每个线程统计一个4x4像素块，白色计数累加在寄存器中，直方图按连续相同的桶合并后再提交
+ * 2. 工作组内白色计数在共享内存中二分归约，直方图在共享内存中原子累加
+ * 3. 每个工作组只向全局缓冲区提交一次白色计数以及非空的桶
+ * 纯色页面所有像素落在同一个桶，第1级的合并使共享内存原子操作从每像素一次降到每线程一次。
+ *
+ * 需要OpenGL ES 3.1，3.1的函数见GlesEnv::LoadComputeFunctions
+ * */
+class BlankDetector {
+
+private:
+    GlesEnv *mEnv;
+    // OpenGL ES 3.1的函数，首次创建程序时获取
+    const ComputeFunctions *mCompute;
+    // 按输入格式生成的程序，格式变化时重新获取
+    GLuint mProgramId;
+    int mProgramFormat;
+    GLint mRegionLoc;
+    // 全局计数缓冲区，白色计数 + 直方图
+    GLuint mBufferId;
+
+    bool ensureProgram(int format);
+
+public:
+
+    explicit BlankDetector(GlesEnv *env);
+
+    ~BlankDetector();
+
+    /**
+     * 统计输入纹理[startHeight, endHeight)行的颜色分布，行号从图像顶部开始
+     *
+     * @param result 长度为BLANK_RESULT_SIZE，见BLANK_RESULT_PIXELS 等
+     * @return 不支持计算着色器或行范围为空时返回false
+     * */
+    bool Detect(InputTexture *input, int startHeight, int endHeight, int *result);
+
+    // 释放GL资源，需在上下文所在线程调用
+    void Release();
+
+};
+
+#endif //GLLEARNING_BLANKDETECTOR_H
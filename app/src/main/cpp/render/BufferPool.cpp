@@ -0,0 +1,157 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "BufferPool.h"
+#include <cstdlib>
+#include <cstring>
+#include "myutils.h"
+
+#define TAG "BufferPool"
+
+// 每个2的幂细分的档数
+#define SUB_CLASS_COUNT 4
+// BUFFER_POOL_MIN_SIZE = 1 << MIN_SIZE_SHIFT
+#define MIN_SIZE_SHIFT 12
+
+// 对齐头，位于返回地址之前，占BUFFER_POOL_ALIGNMENT字节
+struct BufferHeader {
+    long long capacity;
+    int sizeClass;
+};
+
+BufferPool *BufferPool::sInstance = nullptr;
+std::once_flag BufferPool::sOnce;
+
+BufferPool::BufferPool() {
+    mIdleBytes = 0;
+    mBudget = 0;
+    memset(mStats, 0, sizeof(mStats));
+}
+
+BufferPool *BufferPool::Get() {
+    std::call_once(sOnce, []() {
+        // 与进程同生命周期
+        sInstance = new BufferPool();
+    });
+    return sInstance;
+}
+
+int BufferPool::sizeClass(long long size, long long *capacity) {
+    if (size <= BUFFER_POOL_MIN_SIZE) {
+        *capacity = BUFFER_POOL_MIN_SIZE;
+        return 0;
+    }
+    // power为小于size的最大的2的幂，档位容量为power * (1 + step / 4)
+    int shift = MIN_SIZE_SHIFT;
+    while ((1LL << (shift + 1)) < size) {
+        shift++;
+    }
+    long long power = 1LL << shift;
+    long long quarter = power / SUB_CLASS_COUNT;
+    long long step = (size - power + quarter - 1) / quarter;
+    if (step == SUB_CLASS_COUNT) {
+        shift++;
+        power <<= 1;
+        step = 0;
+    }
+    *capacity = power + step * quarter;
+    return (shift - MIN_SIZE_SHIFT) * SUB_CLASS_COUNT + (int) step;
+}
+
+void *BufferPool::Alloc(long long size) {
+    long long capacity;
+    int index = sizeClass(size, &capacity);
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    long long &live = mStats[BUFFER_POOL_LIVE_BYTES];
+    mStats[BUFFER_POOL_ALLOC_COUNT]++;
+    char *raw = nullptr;
+    if (index < (int) mFree.size() && !mFree[index].empty()) {
+        raw = mFree[index].back();
+        mFree[index].pop_back();
+        mIdleBytes -= capacity;
+        mStats[BUFFER_POOL_REUSE_COUNT]++;
+    } else {
+        if (mBudget > 0 && live + mIdleBytes + capacity > mBudget) {
+            // 先腾出空闲缓冲区，正在使用的部分仍超预算时失败
+            trim(mBudget - live - capacity);
+            if (live + capacity > mBudget) {
+                LOGE(TAG, "Alloc size=%lld over budget, live=%lld budget=%lld", size, live,
+                     mBudget);
+                mStats[BUFFER_POOL_FAIL_COUNT]++;
+                return nullptr;
+            }
+        }
+        void *memory = nullptr;
+        if (posix_memalign(&memory, BUFFER_POOL_ALIGNMENT, capacity + BUFFER_POOL_ALIGNMENT) != 0) {
+            LOGE(TAG, "Alloc size=%lld out of memory", size);
+            mStats[BUFFER_POOL_FAIL_COUNT]++;
+            return nullptr;
+        }
+        raw = (char *) memory;
+        BufferHeader *header = (BufferHeader *) raw;
+        header->capacity = capacity;
+        header->sizeClass = index;
+    }
+    live += capacity;
+    if (live > mStats[BUFFER_POOL_PEAK_BYTES]) {
+        mStats[BUFFER_POOL_PEAK_BYTES] = live;
+    }
+    return raw + BUFFER_POOL_ALIGNMENT;
+}
+
+void BufferPool::Free(void *buffer) {
+    if (buffer == nullptr) {
+        return;
+    }
+    char *raw = (char *) buffer - BUFFER_POOL_ALIGNMENT;
+    BufferHeader *header = (BufferHeader *) raw;
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    mStats[BUFFER_POOL_LIVE_BYTES] -= header->capacity;
+    long long idleLimit = mBudget > 0 ? mBudget - mStats[BUFFER_POOL_LIVE_BYTES]
+                                      : BUFFER_POOL_IDLE_LIMIT;
+    if (mIdleBytes + header->capacity > idleLimit) {
+        // 优先保留刚归还的，同尺寸的下一次分配最可能用到它
+        trim(idleLimit - header->capacity);
+        if (mIdleBytes + header->capacity > idleLimit) {
+            free(raw);
+            return;
+        }
+    }
+    if (header->sizeClass >= (int) mFree.size()) {
+        mFree.resize(header->sizeClass + 1);
+    }
+    mFree[header->sizeClass].push_back(raw);
+    mIdleBytes += header->capacity;
+}
+
+void BufferPool::trim(long long idleBytes) {
+    // 从大档开始释放，尽快回到限制以内
+    for (int i = (int) mFree.size() - 1; i >= 0 && mIdleBytes > idleBytes; i--) {
+        while (!mFree[i].empty() && mIdleBytes > idleBytes) {
+            char *raw = mFree[i].back();
+            mFree[i].pop_back();
+            mIdleBytes -= ((BufferHeader *) raw)->capacity;
+            free(raw);
+        }
+    }
+}
+
+void BufferPool::SetBudget(long long bytes) {
+    LOGD(TAG, "SetBudget bytes=%lld", bytes);
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    mBudget = bytes > 0 ? bytes : 0;
+    trim(mBudget > 0 ? mBudget - mStats[BUFFER_POOL_LIVE_BYTES] : BUFFER_POOL_IDLE_LIMIT);
+}
+
+void BufferPool::Trim() {
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    trim(0);
+}
+
+void BufferPool::GetStats(long long *stats) {
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    mStats[BUFFER_POOL_IDLE_BYTES] = mIdleBytes;
+    mStats[BUFFER_POOL_BUDGET] = mBudget;
+    memcpy(stats, mStats, sizeof(mStats));
+}
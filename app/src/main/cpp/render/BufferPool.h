@@ -0,0 +1,93 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_BUFFERPOOL_H
+#define GLLEARNING_BUFFERPOOL_H
+
+#include <mutex>
+#include <vector>
+
+// 缓冲区首地址对齐，满足NEON/SSE以及缓存行
+#define BUFFER_POOL_ALIGNMENT 64
+// 最小的大小档位
+#define BUFFER_POOL_MIN_SIZE 4096
+// 不限制预算时，空闲缓冲区最多保留的字节数
+#define BUFFER_POOL_IDLE_LIMIT (32 * 1024 * 1024)
+
+// 统计项下标，见GetStats
+// 调用方正在使用的字节数，按档位容量计算
+#define BUFFER_POOL_LIVE_BYTES 0
+#define BUFFER_POOL_PEAK_BYTES 1
+// 已归还、等待复用的字节数
+#define BUFFER_POOL_IDLE_BYTES 2
+#define BUFFER_POOL_ALLOC_COUNT 3
+// 从空闲缓冲区复用的次数
+#define BUFFER_POOL_REUSE_COUNT 4
+// 超出预算而分配失败的次数
+#define BUFFER_POOL_FAIL_COUNT 5
+#define BUFFER_POOL_BUDGET 6
+#define BUFFER_POOL_STATS_COUNT 7
+
+/**
+ * 进程内共享的像素缓冲区池，用于读取结果、CPU引擎原图拷贝、结果缓存等帧大小的内存
+ *
+ * 1. 按大小分档：每个2的幂再细分4档，浪费不超过25%，同一档的缓冲区在所有BgRender实例间复用，
+ *    连续处理同尺寸图片时不再反复向系统申请、释放大块内存
+ * 2. 首地址按BUFFER_POOL_ALIGNMENT对齐，前面的对齐头记录档位，Free时不需要传大小
+ * 3. 预算限制正在使用与空闲的总字节数，超出时先释放空闲缓冲区，仍不够时分配失败返回nullptr
+ *
+ * 可在任意线程调用。
+ * */
+class BufferPool {
+
+private:
+    // 每个档位的空闲缓冲区，下标见sizeClass
+    std::vector<std::vector<char *>> mFree;
+    long long mIdleBytes;
+    long long mBudget;
+    long long mStats[BUFFER_POOL_STATS_COUNT];
+    std::mutex mLock;
+
+    static BufferPool *sInstance;
+    static std::once_flag sOnce;
+
+    BufferPool();
+
+    // 大小对应的档位与容量
+    static int sizeClass(long long size, long long *capacity);
+
+    // 释放空闲缓冲区直到不超过idleBytes，需持有mLock
+    void trim(long long idleBytes);
+
+public:
+
+    // 获取进程内共享的缓冲区池
+    static BufferPool *Get();
+
+    /**
+     * 分配至少size字节，内容未初始化
+     *
+     * @return 超出预算时返回nullptr
+     * */
+    void *Alloc(long long size);
+
+    // 归还Alloc得到的缓冲区，nullptr时不处理
+    void Free(void *buffer);
+
+    /**
+     * 设置内存预算，包括正在使用与空闲的缓冲区，按档位容量计算，超出时立即释放空闲缓冲区
+     *
+     * @param bytes <=0 不限制
+     * */
+    void SetBudget(long long bytes);
+
+    // 释放所有空闲缓冲区
+    void Trim();
+
+    // 统计，长度为BUFFER_POOL_STATS_COUNT，下标见BUFFER_POOL_LIVE_BYTES 等
+    void GetStats(long long *stats);
+
+};
+
+#endif //GLLEARNING_BUFFERPOOL_H
@@ -0,0 +1,285 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "CpuRender.h"
+#include "myutils.h"
+#include "BufferPool.h"
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CPU_RENDER_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CPU_RENDER_SSE2 1
+#if defined(__GNUC__) || defined(__clang__)
+#include <immintrin.h>
+#define CPU_RENDER_AVX2 1
+#endif
+#endif
+
+#define TAG "CpuRender"
+
+// 分块大小，32x32个像素（4KB）同时放得进L1缓存的读写两侧
+#define BLOCK_SIZE 32
+
+// 灰度定点系数，和为256，对应 0.299 0.587 0.114
+#define WEIGHT_R 77
+#define WEIGHT_G 150
+#define WEIGHT_B 29
+
+static inline uint32_t grayPixel(const uint8_t *px) {
+    uint32_t y = (px[0] * WEIGHT_R + px[1] * WEIGHT_G + px[2] * WEIGHT_B + 128) >> 8;
+    return y | (y << 8) | (y << 16) | 0xff000000u;
+}
+
+static void grayscaleScalar(const uint8_t *src, uint8_t *dst, int pixelCount) {
+    for (int i = 0; i < pixelCount; i++) {
+        uint32_t value = grayPixel(src + i * 4);
+        memcpy(dst + i * 4, &value, 4);
+    }
+}
+
+#if CPU_RENDER_NEON
+
+// 每次处理16个像素，vld4q_u8按通道解交织
+static void grayscaleNeon(const uint8_t *src, uint8_t *dst, int pixelCount) {
+    const uint8x8_t wr = vdup_n_u8(WEIGHT_R);
+    const uint8x8_t wg = vdup_n_u8(WEIGHT_G);
+    const uint8x8_t wb = vdup_n_u8(WEIGHT_B);
+    const uint8x16_t alpha = vdupq_n_u8(255);
+    int i = 0;
+    for (; i + 16 <= pixelCount; i += 16) {
+        uint8x16x4_t px = vld4q_u8(src + i * 4);
+        uint16x8_t lo = vmull_u8(vget_low_u8(px.val[0]), wr);
+        lo = vmlal_u8(lo, vget_low_u8(px.val[1]), wg);
+        lo = vmlal_u8(lo, vget_low_u8(px.val[2]), wb);
+        uint16x8_t hi = vmull_u8(vget_high_u8(px.val[0]), wr);
+        hi = vmlal_u8(hi, vget_high_u8(px.val[1]), wg);
+        hi = vmlal_u8(hi, vget_high_u8(px.val[2]), wb);
+        // 四舍五入右移8位
+        uint8x16_t y = vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8));
+        uint8x16x4_t out;
+        out.val[0] = y;
+        out.val[1] = y;
+        out.val[2] = y;
+        out.val[3] = alpha;
+        vst4q_u8(dst + i * 4, out);
+    }
+    grayscaleScalar(src + i * 4, dst + i * 4, pixelCount - i);
+}
+
+#endif
+
+#if CPU_RENDER_SSE2
+
+// 每次处理4个像素：扩展为16位后用madd求 r*wr + g*wg 与 b*wb，再两两相加
+static void grayscaleSse2(const uint8_t *src, uint8_t *dst, int pixelCount) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weight = _mm_setr_epi16(WEIGHT_R, WEIGHT_G, WEIGHT_B, 0,
+                                          WEIGHT_R, WEIGHT_G, WEIGHT_B, 0);
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+    int i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i *) (src + i * 4));
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), weight);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), weight);
+        lo = _mm_add_epi32(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+        hi = _mm_add_epi32(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128i sum = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+                                                      _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i y = _mm_srli_epi32(_mm_add_epi32(sum, round), 8);
+        __m128i out = _mm_or_si128(_mm_or_si128(y, _mm_slli_epi32(y, 8)),
+                                   _mm_or_si128(_mm_slli_epi32(y, 16), alpha));
+        _mm_storeu_si128((__m128i *) (dst + i * 4), out);
+    }
+    grayscaleScalar(src + i * 4, dst + i * 4, pixelCount - i);
+}
+
+#endif
+
+#if CPU_RENDER_AVX2
+
+// 与SSE2实现相同，每次处理8个像素，unpack/shuffle均在128位通道内进行，结果顺序不变
+__attribute__((target("avx2")))
+static void grayscaleAvx2(const uint8_t *src, uint8_t *dst, int pixelCount) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i weight = _mm256_setr_epi16(WEIGHT_R, WEIGHT_G, WEIGHT_B, 0,
+                                             WEIGHT_R, WEIGHT_G, WEIGHT_B, 0,
+                                             WEIGHT_R, WEIGHT_G, WEIGHT_B, 0,
+                                             WEIGHT_R, WEIGHT_G, WEIGHT_B, 0);
+    const __m256i round = _mm256_set1_epi32(128);
+    const __m256i alpha = _mm256_set1_epi32((int) 0xff000000);
+    int i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i px = _mm256_loadu_si256((const __m256i *) (src + i * 4));
+        __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), weight);
+        __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), weight);
+        lo = _mm256_add_epi32(lo, _mm256_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+        hi = _mm256_add_epi32(hi, _mm256_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m256i sum = _mm256_castps_si256(
+                _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi),
+                                  _MM_SHUFFLE(2, 0, 2, 0)));
+        __m256i y = _mm256_srli_epi32(_mm256_add_epi32(sum, round), 8);
+        __m256i out = _mm256_or_si256(_mm256_or_si256(y, _mm256_slli_epi32(y, 8)),
+                                      _mm256_or_si256(_mm256_slli_epi32(y, 16), alpha));
+        _mm256_storeu_si256((__m256i *) (dst + i * 4), out);
+    }
+    grayscaleSse2(src + i * 4, dst + i * 4, pixelCount - i);
+}
+
+#endif
+
+void CpuRender::Grayscale(const uint8_t *src, uint8_t *dst, int pixelCount) {
+#if CPU_RENDER_NEON
+    grayscaleNeon(src, dst, pixelCount);
+#elif CPU_RENDER_SSE2
+#if CPU_RENDER_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) {
+        grayscaleAvx2(src, dst, pixelCount);
+        return;
+    }
+#endif
+    grayscaleSse2(src, dst, pixelCount);
+#else
+    grayscaleScalar(src, dst, pixelCount);
+#endif
+}
+
+CpuRender::CpuRender() {
+    mSource = nullptr;
+    mWidth = 0;
+    mHeight = 0;
+    mCapacity = 0;
+}
+
+CpuRender::~CpuRender() {
+    BufferPool::Get()->Free(mSource);
+}
+
+void CpuRender::SetFrame(int width, int height, const void *data) {
+    int size = width * height * 4;
+    if (size > mCapacity) {
+        BufferPool::Get()->Free(mSource);
+        mSource = (uint8_t *) BufferPool::Get()->Alloc(size);
+        mCapacity = mSource != nullptr ? size : 0;
+        if (mSource == nullptr) {
+            // 超出内存预算，没有原图拷贝，之后走GPU
+            ClearFrame();
+            return;
+        }
+    }
+    mWidth = width;
+    mHeight = height;
+    memcpy(mSource, data, size);
+}
+
+void CpuRender::ClearFrame() {
+    mWidth = 0;
+    mHeight = 0;
+}
+
+bool CpuRender::HasFrame() {
+    return mSource != nullptr && mWidth > 0 && mHeight > 0;
+}
+
+// 归一化坐标转为像素下标，超出范围按GL_CLAMP_TO_EDGE处理
+static inline int texelIndex(double coord, int size) {
+    int index = (int) floor(coord * size);
+    return index < 0 ? 0 : (index >= size ? size - 1 : index);
+}
+
+// 输出像素(x, y)的中心(u, v)按matrix映射到原图(s, t)，取最近的像素
+void CpuRender::Render(uint8_t *dst, const float *matrix, int outWidth, int outHeight) {
+    if (!HasFrame()) {
+        LOGW(TAG, "Render without frame");
+        return;
+    }
+    int width = mWidth;
+    int height = mHeight;
+    const uint32_t *src = (const uint32_t *) mSource;
+    uint32_t *out = (uint32_t *) dst;
+    // 非零项的位置决定是否轴对齐：s只依赖u、t只依赖v，或交换
+    bool aligned = matrix[1] == 0.0f && matrix[3] == 0.0f;
+    bool swap = matrix[0] == 0.0f && matrix[4] == 0.0f;
+
+    if (aligned && outWidth == width && outHeight == height
+        && matrix[0] == 1.0f && matrix[2] == 0.0f && matrix[4] == 1.0f && matrix[5] == 0.0f) {
+        Grayscale(mSource, dst, width * height);
+        return;
+    }
+
+    if (aligned) {
+        // 按行处理，列下标查表，行内连续时直接拷贝
+        std::vector<int> colOfX(outWidth);
+        for (int x = 0; x < outWidth; x++) {
+            colOfX[x] = texelIndex(matrix[0] * ((x + 0.5) / outWidth) + matrix[2], width);
+        }
+        bool contiguous = outWidth <= width;
+        for (int x = 1; x < outWidth && contiguous; x++) {
+            contiguous = colOfX[x] == colOfX[x - 1] + 1;
+        }
+        for (int y = 0; y < outHeight; y++) {
+            int row = texelIndex(matrix[4] * ((y + 0.5) / outHeight) + matrix[5], height);
+            const uint32_t *srcRow = src + row * width;
+            uint32_t *outRow = out + y * outWidth;
+            if (contiguous) {
+                memcpy(outRow, srcRow + colOfX[0], outWidth * 4);
+            } else {
+                for (int x = 0; x < outWidth; x++) {
+                    outRow[x] = srcRow[colOfX[x]];
+                }
+            }
+        }
+    } else if (swap) {
+        // 输出的x对应原图的行，输出的y对应原图的列
+        std::vector<int> rowOfX(outWidth);
+        std::vector<int> colOfY(outHeight);
+        for (int x = 0; x < outWidth; x++) {
+            rowOfX[x] = texelIndex(matrix[3] * ((x + 0.5) / outWidth) + matrix[5], height);
+        }
+        for (int y = 0; y < outHeight; y++) {
+            colOfY[y] = texelIndex(matrix[1] * ((y + 0.5) / outHeight) + matrix[2], width);
+        }
+        // 分块转置，读写两侧都落在缓存内
+        for (int by = 0; by < outHeight; by += BLOCK_SIZE) {
+            int endY = by + BLOCK_SIZE < outHeight ? by + BLOCK_SIZE : outHeight;
+            for (int bx = 0; bx < outWidth; bx += BLOCK_SIZE) {
+                int endX = bx + BLOCK_SIZE < outWidth ? bx + BLOCK_SIZE : outWidth;
+                for (int y = by; y < endY; y++) {
+                    const uint32_t *srcCol = src + colOfY[y];
+                    uint32_t *outRow = out + y * outWidth;
+                    for (int x = bx; x < endX; x++) {
+                        outRow[x] = srcCol[rowOfX[x] * width];
+                    }
+                }
+            }
+        }
+    } else {
+        // 任意角度，逐像素计算
+        for (int y = 0; y < outHeight; y++) {
+            double v = (y + 0.5) / outHeight;
+            uint32_t *outRow = out + y * outWidth;
+            for (int x = 0; x < outWidth; x++) {
+                double u = (x + 0.5) / outWidth;
+                int col = texelIndex(matrix[0] * u + matrix[1] * v + matrix[2], width);
+                int row = texelIndex(matrix[3] * u + matrix[4] * v + matrix[5], height);
+                outRow[x] = src[row * width + col];
+            }
+        }
+    }
+    Grayscale(dst, dst, outWidth * outHeight);
+}
+
+void CpuRender::Release() {
+    BufferPool::Get()->Free(mSource);
+    mSource = nullptr;
+    mCapacity = 0;
+    mWidth = 0;
+    mHeight = 0;
+}
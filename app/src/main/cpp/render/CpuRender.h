@@ -0,0 +1,62 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_CPURENDER_H
+#define GLLEARNING_CPURENDER_H
+
+#include <cstdint>
+
+/**
+ * BgRender默认效果（灰度 + 旋转/镜像）的CPU实现
+ * 1. 小图走GPU时EGL/GL调用与同步读取的开销比计算本身还大，直接用CPU更快
+ * 2. 没有可用的GL上下文时作为兜底
+ *
+ * 采样规则与BgRender的u_texMatrix完全一致（见TexTransform.h），按最近邻取样：
+ * 旋转90度倍数、镜像、裁剪、缩放这类轴对齐的变换按行/列查表，其他仿射变换逐像素计算。
+ * 灰度使用8位定点系数，不缩放时与GPU结果最多相差1。
+ * 灰度内核在ARM上使用NEON，x86上使用SSE2，支持AVX2时运行期切换到AVX2实现。
+ * */
+class CpuRender {
+
+private:
+    // 原图拷贝，GPU路径不持有原图，CPU路径需要自己保留一份
+    uint8_t *mSource;
+    int mWidth;
+    int mHeight;
+    // mSource已分配的字节数
+    int mCapacity;
+
+public:
+
+    CpuRender();
+
+    ~CpuRender();
+
+    // 拷贝一帧RGBA原图
+    void SetFrame(int width, int height, const void *data);
+
+    // 丢弃原图拷贝
+    void ClearFrame();
+
+    bool HasFrame();
+
+    /**
+     * 按变换输出灰度图
+     *
+     * @param dst 输出地址，大小为 outWidth * outHeight * 4
+     * @param matrix 输出 -> 原图的采样坐标变换，见TexTransform.h
+     * */
+    void Render(uint8_t *dst, const float *matrix, int outWidth, int outHeight);
+
+    /**
+     * RGBA转灰度，输出仍为RGBA，alpha为255，src与dst可以相同
+     * */
+    static void Grayscale(const uint8_t *src, uint8_t *dst, int pixelCount);
+
+    // 释放原图拷贝
+    void Release();
+
+};
+
+#endif //GLLEARNING_CPURENDER_H
@@ -0,0 +1,306 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "Downscaler.h"
+#include "TexTransform.h"
+#include "myutils.h"
+#include <cmath>
+
+#define TAG "Downscaler"
+
+// 滤波核半径，双三次与Lanczos2都是2
+#define KERNEL_RADIUS 2
+// 每个方向的最大采样半径，金字塔保证剩余缩小倍数小于2
+#define MAX_SAMPLE_RADIUS 4
+
+// 单位矩形展开为全屏，采样坐标经过变换，与BgRender的FBO绘制方向一致
+static const char *SCALE_VERTEX_SHADER =
+        "#version 300 es\n"
+        "layout(location = 0) in vec2 a_corner;\n"
+        "uniform mat3 u_texMatrix;\n"
+        "out vec2 v_texCoord;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(a_corner * 2.0 - 1.0, 0.0, 1.0);\n"
+        "    v_texCoord = (u_texMatrix * vec3(a_corner, 1.0)).xy;\n"
+        "}\n";
+
+// 中间插入InputTexture::GetSampleFunction
+static const char *SCALE_FRAGMENT_HEAD =
+        "#version 300 es\n"
+        "precision highp float;\n"
+        "in vec2 v_texCoord;\n"
+        "layout(location = 0) out vec4 outColor;\n";
+
+// 宽高减半时采样点正好落在2x2块的中心，一次双线性采样即为4个像素的平均
+static const char *HALVE_MAIN =
+        "void main()\n"
+        "{\n"
+        "    outColor = sampleSource(v_texCoord);\n"
+        "}\n";
+
+// 在源像素空间按可分离的核加权，核按缩小倍数u_filterScale展宽
+// 采样点取像素中心，sampleSource的双线性插值不改变像素值
+static const char *RESAMPLE_MAIN =
+        "uniform vec2 u_sourceSize;\n"
+        "uniform vec2 u_filterScale;\n"
+        "uniform ivec2 u_radius;\n"
+        "uniform int u_kernel;\n"
+        "float kernel(float x)\n"
+        "{\n"
+        "    x = abs(x);\n"
+        "    if (u_kernel == 1) {\n"
+        // Catmull-Rom，a = -0.5
+        "        if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;\n"
+        "        if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;\n"
+        "        return 0.0;\n"
+        "    }\n"
+        // Lanczos2：sinc(x) * sinc(x / 2)
+        "    if (x < 1e-4) return 1.0;\n"
+        "    if (x >= 2.0) return 0.0;\n"
+        "    float px = 3.14159265 * x;\n"
+        "    return 2.0 * sin(px) * sin(px * 0.5) / (px * px);\n"
+        "}\n"
+        "void main()\n"
+        "{\n"
+        "    vec2 p = v_texCoord * u_sourceSize - 0.5;\n"
+        "    vec2 base = floor(p);\n"
+        "    vec2 maxTexel = u_sourceSize - 1.0;\n"
+        "    vec4 sum = vec4(0.0);\n"
+        "    float weightSum = 0.0;\n"
+        "    for (int j = 1 - u_radius.y; j <= u_radius.y; j++) {\n"
+        "        float ty = base.y + float(j);\n"
+        "        float wy = kernel((ty - p.y) / u_filterScale.y);\n"
+        "        if (wy == 0.0) continue;\n"
+        "        float cy = (clamp(ty, 0.0, maxTexel.y) + 0.5) / u_sourceSize.y;\n"
+        "        for (int i = 1 - u_radius.x; i <= u_radius.x; i++) {\n"
+        "            float tx = base.x + float(i);\n"
+        "            float w = wy * kernel((tx - p.x) / u_filterScale.x);\n"
+        "            float cx = (clamp(tx, 0.0, maxTexel.x) + 0.5) / u_sourceSize.x;\n"
+        "            sum += sampleSource(vec2(cx, cy)) * w;\n"
+        "            weightSum += w;\n"
+        "        }\n"
+        "    }\n"
+        // 负瓣会产生越界的值
+        "    outColor = clamp(sum / weightSum, 0.0, 1.0);\n"
+        "}\n";
+
+Downscaler::Downscaler(GlesEnv *env) {
+    mEnv = env;
+    mSource = nullptr;
+    mValidLevels = 0;
+    mResultTextureId = 0;
+    mResultFboId = 0;
+    mResultWidth = 0;
+    mResultHeight = 0;
+    mResult = new InputTexture();
+    mVboId = 0;
+    mVaoId = 0;
+}
+
+Downscaler::~Downscaler() {
+    LOGD(TAG, "Downscaler un constructor");
+    for (Level &level : mLevels) {
+        delete level.texture;
+    }
+    delete mResult;
+}
+
+GLuint Downscaler::getProgram(const std::string &fragmentShader) {
+    return mEnv->GetProgram(SCALE_VERTEX_SHADER, fragmentShader.c_str());
+}
+
+void Downscaler::ensureTarget(GLuint *textureId, GLuint *fboId, int width, int height) {
+    if (*fboId == 0) {
+        glGenTextures(1, textureId);
+        glGenFramebuffers(1, fboId);
+    }
+    glBindTexture(GL_TEXTURE_2D, *textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindFramebuffer(GL_FRAMEBUFFER, *fboId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *textureId, 0);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+}
+
+void Downscaler::drawQuad() {
+    if (mVaoId == 0) {
+        // 三角形带：左下、右下、左上、右上
+        GLfloat corners[] = {
+                0.0f, 0.0f,
+                1.0f, 0.0f,
+                0.0f, 1.0f,
+                1.0f, 1.0f,
+        };
+        glGenBuffers(1, &mVboId);
+        glBindBuffer(GL_ARRAY_BUFFER, mVboId);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glGenVertexArrays(1, &mVaoId);
+        glBindVertexArray(mVaoId);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+        glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+    } else {
+        glBindVertexArray(mVaoId);
+    }
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(GL_NONE);
+}
+
+bool Downscaler::buildLevel(int index, bool halveX, bool halveY) {
+    InputTexture *previous = index == 0 ? mSource : mLevels[index - 1].texture;
+    int width = halveX ? (previous->GetWidth() + 1) / 2 : previous->GetWidth();
+    int height = halveY ? (previous->GetHeight() + 1) / 2 : previous->GetHeight();
+    GLuint programId = getProgram(std::string(SCALE_FRAGMENT_HEAD)
+                                  + InputTexture::GetSampleFunction(previous->GetFormat())
+                                  + HALVE_MAIN);
+    if (programId == 0) {
+        LOGE(TAG, "buildLevel program fail");
+        return false;
+    }
+    if (index == (int) mLevels.size()) {
+        Level level;
+        level.textureId = 0;
+        level.fboId = 0;
+        level.width = 0;
+        level.height = 0;
+        level.texture = new InputTexture();
+        mLevels.push_back(level);
+    }
+    Level &level = mLevels[index];
+    if (level.width != width || level.height != height) {
+        ensureTarget(&level.textureId, &level.fboId, width, height);
+        level.width = width;
+        level.height = height;
+        level.texture->Wrap(level.textureId, width, height);
+    }
+    level.halveX = halveX;
+    level.halveY = halveY;
+
+    GLfloat identity[TEX_TRANSFORM_SIZE];
+    GLfloat matrix[9];
+    texTransformIdentity(identity);
+    texTransformToMat3(identity, matrix);
+    glBindFramebuffer(GL_FRAMEBUFFER, level.fboId);
+    glViewport(0, 0, width, height);
+    glUseProgram(programId);
+    glUniformMatrix3fv(glGetUniformLocation(programId, "u_texMatrix"), 1, GL_FALSE, matrix);
+    previous->Bind(programId);
+    drawQuad();
+    return true;
+}
+
+InputTexture *Downscaler::Resample(InputTexture *input, const GLfloat *transform, int width,
+                                   int height, int quality) {
+    if (input != mSource) {
+        mSource = input;
+        mValidLevels = 0;
+    }
+    int sourceWidth = input->GetWidth();
+    int sourceHeight = input->GetHeight();
+    // 每个输出像素对应的原图像素数，按原图的两个方向分别计算
+    double spanX = fmax(fabs(transform[0]) / width, fabs(transform[1]) / height) * sourceWidth;
+    double spanY = fmax(fabs(transform[3]) / width, fabs(transform[4]) / height) * sourceHeight;
+
+    // 逐层减半，与已缓存的层相同时直接复用
+    InputTexture *level = input;
+    int index = 0;
+    while (true) {
+        double remainX = spanX * level->GetWidth() / sourceWidth;
+        double remainY = spanY * level->GetHeight() / sourceHeight;
+        bool halveX = remainX >= 2.0 && level->GetWidth() > 1;
+        bool halveY = remainY >= 2.0 && level->GetHeight() > 1;
+        if (!halveX && !halveY) {
+            break;
+        }
+        bool cached = index < mValidLevels && mLevels[index].halveX == halveX
+                      && mLevels[index].halveY == halveY;
+        if (!cached) {
+            mValidLevels = index;
+            if (!buildLevel(index, halveX, halveY)) {
+                return nullptr;
+            }
+            mValidLevels = index + 1;
+        }
+        level = mLevels[index].texture;
+        index++;
+    }
+
+    GLuint programId = getProgram(std::string(SCALE_FRAGMENT_HEAD)
+                                  + InputTexture::GetSampleFunction(level->GetFormat())
+                                  + RESAMPLE_MAIN);
+    if (programId == 0) {
+        LOGE(TAG, "Resample program fail");
+        return nullptr;
+    }
+    if (width != mResultWidth || height != mResultHeight) {
+        ensureTarget(&mResultTextureId, &mResultFboId, width, height);
+        mResultWidth = width;
+        mResultHeight = height;
+    }
+    // 放大时按原始的核插值，缩小时核按剩余倍数展宽，兼作低通滤波
+    float filterX = (float) fmax(1.0, spanX * level->GetWidth() / sourceWidth);
+    float filterY = (float) fmax(1.0, spanY * level->GetHeight() / sourceHeight);
+    int radiusX = (int) ceil(KERNEL_RADIUS * filterX);
+    int radiusY = (int) ceil(KERNEL_RADIUS * filterY);
+    radiusX = radiusX > MAX_SAMPLE_RADIUS ? MAX_SAMPLE_RADIUS : radiusX;
+    radiusY = radiusY > MAX_SAMPLE_RADIUS ? MAX_SAMPLE_RADIUS : radiusY;
+
+    GLfloat matrix[9];
+    texTransformToMat3(transform, matrix);
+    glBindFramebuffer(GL_FRAMEBUFFER, mResultFboId);
+    glViewport(0, 0, width, height);
+    glUseProgram(programId);
+    glUniformMatrix3fv(glGetUniformLocation(programId, "u_texMatrix"), 1, GL_FALSE, matrix);
+    glUniform2f(glGetUniformLocation(programId, "u_sourceSize"), (GLfloat) level->GetWidth(),
+                (GLfloat) level->GetHeight());
+    glUniform2f(glGetUniformLocation(programId, "u_filterScale"), filterX, filterY);
+    glUniform2i(glGetUniformLocation(programId, "u_radius"), radiusX, radiusY);
+    glUniform1i(glGetUniformLocation(programId, "u_kernel"),
+                quality == SCALE_QUALITY_BICUBIC ? 1 : 2);
+    level->Bind(programId);
+    drawQuad();
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    LOGD(TAG, "Resample %dx%d -> %dx%d levels=%d error=%d", sourceWidth, sourceHeight, width,
+         height, index, glGetError());
+    mResult->Wrap(mResultTextureId, width, height);
+    return mResult;
+}
+
+void Downscaler::Invalidate() {
+    mValidLevels = 0;
+}
+
+void Downscaler::Release() {
+    LOGD(TAG, "Release");
+    for (Level &level : mLevels) {
+        if (level.fboId != 0) {
+            glDeleteFramebuffers(1, &level.fboId);
+            glDeleteTextures(1, &level.textureId);
+        }
+        level.texture->Release();
+        delete level.texture;
+    }
+    mLevels.clear();
+    mValidLevels = 0;
+    mSource = nullptr;
+    if (mResultFboId != 0) {
+        glDeleteFramebuffers(1, &mResultFboId);
+        glDeleteTextures(1, &mResultTextureId);
+    }
+    mResultFboId = 0;
+    mResultTextureId = 0;
+    mResultWidth = 0;
+    mResultHeight = 0;
+    mResult->Release();
+    if (mVaoId != 0) {
+        glDeleteVertexArrays(1, &mVaoId);
+        glDeleteBuffers(1, &mVboId);
+    }
+    mVaoId = 0;
+    mVboId = 0;
+}
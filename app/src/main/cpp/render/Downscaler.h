@@ -0,0 +1,101 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_DOWNSCALER_H
+#define GLLEARNING_DOWNSCALER_H
+
+#include <GLES3/gl3.h>
+#include <string>
+#include <vector>
+#include "GlesEnv.h"
+#include "InputTexture.h"
+
+// 缩放质量
+// 直接双线性采样，缩小超过2倍时会有锯齿与摩尔纹
+#define SCALE_QUALITY_BILINEAR 0
+// 金字塔 + Catmull-Rom双三次
+#define SCALE_QUALITY_BICUBIC 1
+// 金字塔 + Lanczos2，边缘更锐利，可能有轻微振铃
+#define SCALE_QUALITY_LANCZOS 2
+
+/**
+ * 高质量缩放，按输出尺寸在GPU上重采样原图
+ *
+ * 1. 金字塔：每趟用一次双线性采样取2x2块平均，宽高分别减半，直到剩余缩小倍数不足2倍，
+ *    共log2(倍数)趟；宽高的缩小倍数不同时只减半需要的方向。
+ *    第一层经过InputTexture的sampleSource，YUV输入也可以直接建金字塔。
+ * 2. 最后一趟从金字塔中取合适的一层，按采样坐标变换做双三次或Lanczos2重采样到准确的输出尺寸，
+ *    滤波核按剩余的缩小倍数展宽，每个方向最多8个采样点。
+ *
+ * 金字塔在输入不变时缓存，同一帧生成多个缩略图时只有第一次需要建金字塔。
+ * 结果为变换后的RGBA纹理，之后的滤镜、灰度按1:1采样，不再有缩放。
+ * 所有方法需在上下文所在线程调用。
+ * */
+class Downscaler {
+
+private:
+    // 金字塔中的一层
+    struct Level {
+        GLuint textureId;
+        GLuint fboId;
+        int width;
+        int height;
+        // 相对上一层是否减半了宽、高
+        bool halveX;
+        bool halveY;
+        InputTexture *texture;
+    };
+
+    GlesEnv *mEnv;
+    // 建金字塔的输入，输入变化时需Invalidate
+    InputTexture *mSource;
+    std::vector<Level> mLevels;
+    // 已生成的层数，之后的层纹理可以复用，但内容已失效
+    int mValidLevels;
+
+    // 重采样结果
+    GLuint mResultTextureId;
+    GLuint mResultFboId;
+    int mResultWidth;
+    int mResultHeight;
+    InputTexture *mResult;
+
+    // 全屏矩形，顶点为单位矩形的四个角
+    GLuint mVboId;
+    GLuint mVaoId;
+
+    GLuint getProgram(const std::string &fragmentShader);
+
+    // 生成第index层，上一层为mSource或mLevels[index - 1]
+    bool buildLevel(int index, bool halveX, bool halveY);
+
+    void ensureTarget(GLuint *textureId, GLuint *fboId, int width, int height);
+
+    void drawQuad();
+
+public:
+
+    explicit Downscaler(GlesEnv *env);
+
+    ~Downscaler();
+
+    /**
+     * 按采样坐标变换重采样到width x height
+     *
+     * @param transform 输出 -> 原图的归一化采样坐标变换，见TexTransform.h
+     * @param quality SCALE_QUALITY_BICUBIC 或 SCALE_QUALITY_LANCZOS
+     * @return 变换后的RGBA结果，下次调用前有效；程序创建失败时返回nullptr
+     * */
+    InputTexture *Resample(InputTexture *input, const GLfloat *transform, int width, int height,
+                           int quality);
+
+    // 输入内容变化，金字塔需要重建
+    void Invalidate();
+
+    // 释放GL资源，需在上下文所在线程调用
+    void Release();
+
+};
+
+#endif //GLLEARNING_DOWNSCALER_H
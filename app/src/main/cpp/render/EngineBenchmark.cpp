@@ -0,0 +1,103 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "EngineBenchmark.h"
+#include "BgRender.h"
+#include "RenderPool.h"
+#include "myutils.h"
+
+#define TAG "EngineBenchmark"
+
+// 按引擎跑iterations帧，返回每帧平均耗时
+static long long runEngine(BgRender *render, int engine, int width, int height, const char *image,
+                           signed char *output, int iterations) {
+    render->SetEngine(engine);
+    // 预热，同时让CPU引擎拿到原图拷贝
+    render->UpdateFrame(width, height, image);
+    render->DrawTo(output);
+    long long start = currentTimeUs();
+    for (int i = 0; i < iterations; i++) {
+        render->UpdateFrame(width, height, image);
+        render->DrawTo(output);
+    }
+    return (currentTimeUs() - start) / iterations;
+}
+
+// 渐变图，避免全同像素
+static char *createImage(int width, int height) {
+    char *image = new char[width * height * 4];
+    for (int i = 0; i < width * height; i++) {
+        image[i * 4] = (char) (i % width);
+        image[i * 4 + 1] = (char) (i / width);
+        image[i * 4 + 2] = (char) (i * 7);
+        image[i * 4 + 3] = (char) 255;
+    }
+    return image;
+}
+
+// 提交count张图并等待全部完成
+static void runPool(RenderPool *pool, int width, int height, const char *image, int count) {
+    RenderFuture **futures = new RenderFuture *[count];
+    for (int i = 0; i < count; i++) {
+        futures[i] = pool->SubmitImage(width, height, image, ROTATE_90, nullptr);
+    }
+    for (int i = 0; i < count; i++) {
+        futures[i]->Wait(-1);
+        futures[i]->Release();
+    }
+    delete[] futures;
+}
+
+double benchmarkPool(int width, int height, int workerCount, int imageCount) {
+    if (width <= 0 || height <= 0) {
+        return -1;
+    }
+    imageCount = imageCount <= 0 ? 1 : imageCount;
+    char *image = createImage(width, height);
+    RenderPool *pool = new RenderPool(workerCount);
+    double imagesPerSecond = -1;
+    if (pool->Start() > 0) {
+        // 预热，让每个工作线程都创建好渲染器与程序
+        runPool(pool, width, height, image, workerCount * 2);
+        long long start = currentTimeUs();
+        runPool(pool, width, height, image, imageCount);
+        long long cost = currentTimeUs() - start;
+        imagesPerSecond = imageCount * 1000000.0 / (cost > 0 ? cost : 1);
+    }
+    pool->Stop();
+    delete pool;
+    LOGI(TAG, "benchmarkPool %dx%d workers=%d images=%d %.1f images/s", width, height,
+         workerCount, imageCount, imagesPerSecond);
+    delete[] image;
+    return imagesPerSecond;
+}
+
+void benchmarkEngines(int width, int height, int rotate, int iterations, long long *result) {
+    result[BENCHMARK_GPU_US] = -1;
+    result[BENCHMARK_CPU_US] = -1;
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    iterations = iterations <= 0 ? 1 : iterations;
+    int size = width * height * 4;
+    char *image = createImage(width, height);
+    signed char *output = new signed char[size];
+
+    BgRender *render = new BgRender(width, height, image);
+    bool gpu = render->CreateGlesEnv();
+    render->SetRotate(rotate);
+    if (gpu) {
+        result[BENCHMARK_GPU_US] = runEngine(render, ENGINE_GPU, width, height, image, output,
+                                             iterations);
+    }
+    result[BENCHMARK_CPU_US] = runEngine(render, ENGINE_CPU, width, height, image, output,
+                                         iterations);
+    render->DestroyGlesEnv();
+    delete render;
+    LOGI(TAG, "benchmarkEngines %dx%d rotate=%d gpu=%lldus cpu=%lldus", width, height, rotate,
+         result[BENCHMARK_GPU_US], result[BENCHMARK_CPU_US]);
+
+    delete[] image;
+    delete[] output;
+}
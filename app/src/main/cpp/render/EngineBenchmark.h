@@ -0,0 +1,30 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_ENGINEBENCHMARK_H
+#define GLLEARNING_ENGINEBENCHMARK_H
+
+// 结果下标
+#define BENCHMARK_GPU_US 0
+#define BENCHMARK_CPU_US 1
+#define BENCHMARK_RESULT_COUNT 2
+
+/**
+ * 对比同一张图在GPU与CPU引擎下的单帧耗时，用于在具体机型上调整CPU阈值
+ * 每帧包含输入图像（UpdateFrame）与渲染读取（DrawTo）
+ *
+ * @param rotate 旋转角度，ROTATE_0 等
+ * @param result 每帧平均耗时，单位微秒，下标见BENCHMARK_GPU_US等；GPU不可用时为-1
+ * */
+void benchmarkEngines(int width, int height, int rotate, int iterations, long long *result);
+
+/**
+ * 测试RenderPool在指定工作线程数下的吞吐，每张图包含输入图像与渲染读取
+ * 需在共享环境所在的线程调用，见RenderPool::Start
+ *
+ * @return 每秒处理的图像数，工作线程创建失败时为-1
+ * */
+double benchmarkPool(int width, int height, int workerCount, int imageCount);
+
+#endif //GLLEARNING_ENGINEBENCHMARK_H
@@ -0,0 +1,827 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "FilterChain.h"
+#include "TexTransform.h"
+#include "ResultCache.h"
+#include "myutils.h"
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+#define TAG "FilterChain"
+
+// 计算着色器每个工作组处理一行（列）中连续的像素数，OpenGL ES 3.1保证工作组至少128个线程
+#define CONV_GROUP_SIZE 128
+// 片元路径合并后单侧最多的抽头数
+#define CONV_MAX_TAPS ((FILTER_MAX_RADIUS + 1) / 2)
+
+// 滤镜链通用的顶点shader，采样坐标经过裁剪及调用方的变换
+static const char *FILTER_VERTEX_SHADER =
+        "#version 300 es                            \n"
+        "layout(location = 0) in vec4 a_position;   \n"
+        "layout(location = 1) in vec2 a_texCoord;   \n"
+        "uniform mat3 u_texMatrix;                  \n"  // 采样坐标变换，见TexTransform.h
+        "out vec2 v_texCoord;                       \n"
+        "void main()                                \n"
+        "{                                          \n"
+        "   gl_Position = a_position;               \n"
+        "   v_texCoord = (u_texMatrix * vec3(a_texCoord, 1.0)).xy; \n"
+        "}                                          \n";
+
+// 读取ping-pong纹理，有效区域只占纹理的一部分，采样坐标限制在有效区域内，
+// 与有效区域恰好等于纹理时的CLAMP_TO_EDGE一致，邻域采样不会读到区域外的旧数据
+static const char *SAMPLE_PING_PONG =
+        "uniform sampler2D s_TextureMap;\n"
+        "uniform vec2 u_uvMax;\n"  // 有效区域最后一个像素的中心
+        "vec4 sampleSource(vec2 coord)\n"
+        "{\n"
+        "    return texture(s_TextureMap, min(coord, u_uvMax));\n"
+        "}\n";
+
+// 片元路径的可分离卷积，u_step为沿卷积方向一个像素的采样坐标偏移
+// 每个抽头对称地采样两侧，边缘外的像素与CLAMP_TO_EDGE一致取最边上的像素
+static const char *CONV_FRAGMENT_MAIN =
+        "uniform sampler2D s_Original;\n"
+        "uniform vec2 u_step;\n"
+        "uniform float u_center;\n"
+        "uniform vec2 u_taps[64];\n"  // CONV_MAX_TAPS，偏移、权重
+        "uniform int u_tapCount;\n"
+        "uniform int u_sharpen;\n"
+        "uniform float u_amount;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 sum = sampleSource(v_texCoord) * u_center;\n"
+        "    for (int i = 0; i < u_tapCount; i++) {\n"
+        "        vec2 offset = u_step * u_taps[i].x;\n"
+        "        sum += (sampleSource(v_texCoord + offset) + sampleSource(v_texCoord - offset))\n"
+        "            * u_taps[i].y;\n"
+        "    }\n"
+        // USM锐化在垂直方向时与卷积前的原图合成
+        "    if (u_sharpen != 0) {\n"
+        "        vec4 original = texture(s_Original, v_texCoord);\n"
+        "        sum = clamp(original + (original - sum) * u_amount, 0.0, 1.0);\n"
+        "    }\n"
+        "    outColor = sum;\n"
+        "}\n";
+
+// 计算着色器路径：每个工作组处理一行（列）中的128个像素，先把这一段连同两侧半径宽的邻域读入共享内存，
+// 每个像素只从显存读取约(128 + 2 * 半径) / 128次，之后的乘加都在共享内存中完成
+static const char *CONV_COMPUTE_SHADER =
+        "#version 310 es\n"
+        "precision highp float;\n"
+        "precision highp int;\n"
+        "layout(local_size_x = 128) in;\n"  // CONV_GROUP_SIZE
+        "uniform highp sampler2D s_Input;\n"
+        "uniform highp sampler2D s_Original;\n"
+        "layout(rgba8, binding = 0) writeonly uniform highp image2D u_output;\n"
+        "uniform ivec2 u_size;\n"
+        "uniform int u_vertical;\n"
+        "uniform int u_radius;\n"
+        "uniform vec4 u_weights[33];\n"  // FILTER_MAX_RADIUS / 4 + 1，4个权重一组
+        "uniform int u_sharpen;\n"
+        "uniform float u_amount;\n"
+        "shared vec4 sLine[384];\n"  // CONV_GROUP_SIZE + 2 * FILTER_MAX_RADIUS
+        "ivec2 coordAt(int position, int line)\n"
+        "{\n"
+        "    return u_vertical != 0 ? ivec2(line, position) : ivec2(position, line);\n"
+        "}\n"
+        "void main()\n"
+        "{\n"
+        "    int local = int(gl_LocalInvocationID.x);\n"
+        "    int line = int(gl_WorkGroupID.y);\n"
+        "    int start = int(gl_WorkGroupID.x) * 128;\n"
+        "    int length = u_vertical != 0 ? u_size.y : u_size.x;\n"
+        "    for (int i = local; i < 128 + 2 * u_radius; i += 128) {\n"
+        "        int position = clamp(start - u_radius + i, 0, length - 1);\n"
+        "        sLine[i] = texelFetch(s_Input, coordAt(position, line), 0);\n"
+        "    }\n"
+        "    barrier();\n"
+        "    int position = start + local;\n"
+        "    if (position >= length) {\n"
+        "        return;\n"
+        "    }\n"
+        "    int center = local + u_radius;\n"
+        "    vec4 sum = sLine[center] * u_weights[0].x;\n"
+        "    for (int k = 1; k <= u_radius; k++) {\n"
+        "        sum += (sLine[center - k] + sLine[center + k]) * u_weights[k >> 2][k & 3];\n"
+        "    }\n"
+        "    ivec2 coord = coordAt(position, line);\n"
+        "    if (u_sharpen != 0) {\n"
+        "        vec4 original = texelFetch(s_Original, coord, 0);\n"
+        "        sum = clamp(original + (original - sum) * u_amount, 0.0, 1.0);\n"
+        "    }\n"
+        "    imageStore(u_output, coord, sum);\n"
+        "}\n";
+
+// 每种滤镜占用的uniform vec4个数
+static int paramVec4Count(int type) {
+    switch (type) {
+        case FILTER_COLOR_MATRIX:
+            // 4列矩阵 + 1个偏移
+            return 5;
+        case FILTER_BRIGHTNESS_CONTRAST:
+        case FILTER_SHARPEN:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static bool isConvolution(int type) {
+    return type == FILTER_GAUSSIAN_BLUR || type == FILTER_BOX_BLUR || type == FILTER_UNSHARP_MASK;
+}
+
+// 卷积半径，限制在[1, FILTER_MAX_RADIUS]
+static int convolutionRadius(const GLfloat *params) {
+    int radius = (int) params[0];
+    return radius < 1 ? 1 : (radius > FILTER_MAX_RADIUS ? FILTER_MAX_RADIUS : radius);
+}
+
+// 一维卷积核中心及右侧的权重，左右对称，归一化后总和为1
+static void convolutionWeights(int type, const GLfloat *params, int radius,
+                               std::vector<GLfloat> *weights) {
+    weights->resize(radius + 1);
+    if (type == FILTER_BOX_BLUR) {
+        for (int i = 0; i <= radius; i++) {
+            (*weights)[i] = 1.0f / (2 * radius + 1);
+        }
+        return;
+    }
+    GLfloat sigma = type == FILTER_GAUSSIAN_BLUR ? params[1] : params[2];
+    if (sigma <= 0.0f) {
+        sigma = radius / 3.0f;
+    }
+    double sum = 0.0;
+    for (int i = 0; i <= radius; i++) {
+        double weight = exp(-(double) i * i / (2.0 * sigma * sigma));
+        (*weights)[i] = (GLfloat) weight;
+        sum += i == 0 ? weight : 2.0 * weight;
+    }
+    for (int i = 0; i <= radius; i++) {
+        (*weights)[i] = (GLfloat) ((*weights)[i] / sum);
+    }
+}
+
+// 将裁剪参数限制在图像范围内
+static void clampCrop(const GLfloat *params, int width, int height, int *x, int *y, int *w,
+                      int *h) {
+    *x = (int) params[0];
+    *y = (int) params[1];
+    *x = *x < 0 ? 0 : (*x >= width ? width - 1 : *x);
+    *y = *y < 0 ? 0 : (*y >= height ? height - 1 : *y);
+    *w = (int) params[2];
+    *h = (int) params[3];
+    *w = (*w <= 0 || *x + *w > width) ? width - *x : *w;
+    *h = (*h <= 0 || *y + *h > height) ? height - *y : *h;
+}
+
+FilterChain::FilterChain(GlesEnv *env) {
+    mEnv = env;
+    mDirty = true;
+    mInWidth = 0;
+    mInHeight = 0;
+    mSourceFormat = IMAGE_FORMAT_RGBA;
+    mPingPongTextureIds[0] = mPingPongTextureIds[1] = mPingPongTextureIds[2] = 0;
+    mPingPongFboIds[0] = mPingPongFboIds[1] = mPingPongFboIds[2] = 0;
+    mPingPongWidth = 0;
+    mPingPongHeight = 0;
+    mConvProgramId = 0;
+    mConvComputeProgramId = 0;
+    mCompute = nullptr;
+    mComputeEnabled = true;
+    mVboIds[0] = mVboIds[1] = mVboIds[2] = 0;
+    mVaoId = 0;
+}
+
+FilterChain::~FilterChain() {
+    LOGD(TAG, "FilterChain un constructor");
+}
+
+bool FilterChain::AddFilter(int type, const GLfloat *params, int paramCount) {
+    LOGD(TAG, "AddFilter type=%d paramCount=%d", type, paramCount);
+    FilterStage stage;
+    stage.type = type;
+    memset(stage.params, 0, sizeof(stage.params));
+    // 默认值
+    switch (type) {
+        case FILTER_GRAYSCALE:
+        case FILTER_SHARPEN:
+        case FILTER_CROP:
+            break;
+        case FILTER_COLOR_MATRIX:
+            // 单位矩阵
+            stage.params[0] = stage.params[6] = stage.params[12] = stage.params[18] = 1.0f;
+            break;
+        case FILTER_BRIGHTNESS_CONTRAST:
+            stage.params[1] = 1.0f;
+            break;
+        case FILTER_GAUSSIAN_BLUR:
+        case FILTER_BOX_BLUR:
+            stage.params[0] = 1.0f;
+            break;
+        case FILTER_UNSHARP_MASK:
+            stage.params[0] = 1.0f;
+            stage.params[1] = 1.0f;
+            break;
+        default:
+            LOGE(TAG, "AddFilter unknown type=%d", type);
+            return false;
+    }
+    if (params != nullptr) {
+        int count = paramCount > FILTER_MAX_PARAMS ? FILTER_MAX_PARAMS : paramCount;
+        memcpy(stage.params, params, count * sizeof(GLfloat));
+    }
+    mStages.push_back(stage);
+    mDirty = true;
+    return true;
+}
+
+void FilterChain::Clear() {
+    mStages.clear();
+    mPasses.clear();
+    mDirty = true;
+}
+
+bool FilterChain::IsEmpty() {
+    return mStages.empty();
+}
+
+unsigned long long FilterChain::Hash(unsigned long long seed) {
+    // 参数已按默认值补齐，FilterStage没有填充字节，可以直接按内存哈希
+    if (mStages.empty()) {
+        return seed;
+    }
+    unsigned long long hash = ResultCache::Hash(
+            mStages.data(), (long long) (mStages.size() * sizeof(FilterStage)), seed);
+    // 卷积的计算着色器与片元着色器路径舍入不同，结果按所用路径区分
+    for (const FilterStage &stage : mStages) {
+        if (isConvolution(stage.type)) {
+            return ResultCache::Hash(&mComputeEnabled, sizeof(mComputeEnabled), hash);
+        }
+    }
+    return hash;
+}
+
+int FilterChain::GetHaloSize() {
+    // 锐化每次采样上下左右各1个像素，卷积各半径个像素，多个邻域滤镜的邻域逐趟扩大
+    int halo = 0;
+    for (const FilterStage &stage : mStages) {
+        if (stage.type == FILTER_SHARPEN) {
+            halo++;
+        } else if (isConvolution(stage.type)) {
+            halo += convolutionRadius(stage.params);
+        }
+    }
+    return halo;
+}
+
+int FilterChain::GetPassCount(int inWidth, int inHeight) {
+    build(inWidth, inHeight);
+    return (int) mPasses.size();
+}
+
+void FilterChain::SetComputeEnabled(bool enabled) {
+    LOGD(TAG, "SetComputeEnabled enabled=%d", enabled);
+    mComputeEnabled = enabled;
+}
+
+void FilterChain::GetOutputSize(int inWidth, int inHeight, int *outWidth, int *outHeight) {
+    int width = inWidth;
+    int height = inHeight;
+    for (auto &stage : mStages) {
+        if (stage.type == FILTER_CROP) {
+            int x, y;
+            clampCrop(stage.params, width, height, &x, &y, &width, &height);
+        }
+    }
+    *outWidth = width;
+    *outHeight = height;
+}
+
+// 划分绘制趟数：锐化之前若已有颜色处理，则从锐化开始新的一趟；逐像素滤镜与裁剪并入当前这一趟；
+// 卷积单独占一趟
+void FilterChain::build(int inWidth, int inHeight) {
+    if (!mDirty && inWidth == mInWidth && inHeight == mInHeight) {
+        return;
+    }
+    mPasses.clear();
+    mInWidth = inWidth;
+    mInHeight = inHeight;
+    mDirty = false;
+    if (mStages.empty()) {
+        return;
+    }
+
+    int width = inWidth;
+    int height = inHeight;
+    FilterPass pass;
+    // pass是否已开始，尚未放入mPasses
+    bool opened = false;
+    bool hasColorStage = false;
+    auto startPass = [&](int firstStage) {
+        pass = FilterPass();
+        pass.firstStage = firstStage;
+        pass.stageCount = 0;
+        pass.inWidth = width;
+        pass.inHeight = height;
+        pass.uvOffset[0] = pass.uvOffset[1] = 0.0f;
+        pass.uvScale[0] = pass.uvScale[1] = 1.0f;
+        pass.programId = 0;
+        pass.convolution = false;
+        pass.radius = 0;
+        opened = true;
+        hasColorStage = false;
+    };
+    auto finishPass = [&]() {
+        pass.outWidth = width;
+        pass.outHeight = height;
+        mPasses.push_back(pass);
+        opened = false;
+    };
+    for (int i = 0; i < (int) mStages.size(); i++) {
+        const FilterStage &stage = mStages[i];
+        if (isConvolution(stage.type)) {
+            if (!opened) {
+                // 第一个滤镜就是卷积时，先画一趟变换后的原图
+                startPass(i);
+            }
+            finishPass();
+            startPass(i);
+            pass.stageCount = 1;
+            pass.convolution = true;
+            pass.radius = convolutionRadius(stage.params);
+            convolutionWeights(stage.type, stage.params, pass.radius, &pass.weights);
+            // 片元路径：相邻两个抽头i、i + 1合并为一次双线性采样，采样点按权重插值
+            for (int tap = 1; tap <= pass.radius; tap += 2) {
+                GLfloat weight = pass.weights[tap];
+                GLfloat offset = (GLfloat) tap;
+                if (tap + 1 <= pass.radius) {
+                    GLfloat next = pass.weights[tap + 1];
+                    offset = (tap * weight + (tap + 1) * next) / (weight + next);
+                    weight += next;
+                }
+                pass.uniformParams.push_back(offset);
+                pass.uniformParams.push_back(weight);
+            }
+            finishPass();
+            continue;
+        }
+        if (!opened || (stage.type == FILTER_SHARPEN && hasColorStage)) {
+            if (opened) {
+                finishPass();
+            }
+            startPass(i);
+        }
+        if (stage.type == FILTER_CROP) {
+            // 裁剪区域换算成当前这一趟的采样坐标，多次裁剪逐级嵌套
+            int x, y, w, h;
+            clampCrop(stage.params, width, height, &x, &y, &w, &h);
+            pass.uvOffset[0] += pass.uvScale[0] * x / width;
+            pass.uvOffset[1] += pass.uvScale[1] * y / height;
+            pass.uvScale[0] *= (GLfloat) w / width;
+            pass.uvScale[1] *= (GLfloat) h / height;
+            width = w;
+            height = h;
+        } else {
+            hasColorStage = true;
+            for (int j = 0; j < paramVec4Count(stage.type) * 4; j++) {
+                pass.uniformParams.push_back(0.0f);
+            }
+            GLfloat *dst = pass.uniformParams.data() + pass.uniformParams.size() -
+                           paramVec4Count(stage.type) * 4;
+            if (stage.type == FILTER_COLOR_MATRIX) {
+                // 行优先的4x5矩阵转换为GLSL的列向量，偏移量从0~255换算到0~1
+                for (int col = 0; col < 4; col++) {
+                    for (int row = 0; row < 4; row++) {
+                        dst[col * 4 + row] = stage.params[row * 5 + col];
+                    }
+                }
+                for (int row = 0; row < 4; row++) {
+                    dst[16 + row] = stage.params[row * 5 + 4] / 255.0f;
+                }
+            } else if (paramVec4Count(stage.type) > 0) {
+                memcpy(dst, stage.params, 4 * sizeof(GLfloat));
+            }
+        }
+        pass.stageCount++;
+    }
+    if (opened) {
+        finishPass();
+    }
+    LOGD(TAG, "build stageCount=%d passCount=%d", (int) mStages.size(), (int) mPasses.size());
+}
+
+std::string FilterChain::generateFragmentShader(const FilterPass &pass, int sourceFormat,
+                                                bool pingPong) {
+    int vec4Count = (int) pass.uniformParams.size() / 4;
+    char line[256];
+    // 采样坐标需要highp，mediump在部分GPU上为半精度，大图上相邻像素的坐标都无法区分
+    std::string shader =
+            "#version 300 es\n"
+            "precision highp float;\n"
+            "in vec2 v_texCoord;\n"
+            "layout(location = 0) out vec4 outColor;\n"
+            "uniform vec2 u_texelSize;\n";
+    // 采样函数sampleSource，YUV输入在其中转换为RGB
+    shader += pingPong ? SAMPLE_PING_PONG : InputTexture::GetSampleFunction(sourceFormat);
+    if (vec4Count > 0) {
+        snprintf(line, sizeof(line), "uniform vec4 u_params[%d];\n", vec4Count);
+        shader += line;
+    }
+    shader += "void main()\n{\n";
+
+    bool sampled = false;
+    int paramIndex = 0;
+    for (int i = pass.firstStage; i < pass.firstStage + pass.stageCount; i++) {
+        int type = mStages[i].type;
+        if (type == FILTER_CROP) {
+            continue;
+        }
+        if (!sampled) {
+            sampled = true;
+            if (type == FILTER_SHARPEN) {
+                // 锐化作为这一趟的第一个颜色处理，直接对输入纹理做邻域采样
+                snprintf(line, sizeof(line), "    float s = u_params[%d].x;\n", paramIndex);
+                shader += line;
+                shader +=
+                        "    vec4 color = sampleSource(v_texCoord) * (1.0 + 4.0 * s)\n"
+                        "        - (sampleSource(v_texCoord + vec2(u_texelSize.x, 0.0))\n"
+                        "        + sampleSource(v_texCoord - vec2(u_texelSize.x, 0.0))\n"
+                        "        + sampleSource(v_texCoord + vec2(0.0, u_texelSize.y))\n"
+                        "        + sampleSource(v_texCoord - vec2(0.0, u_texelSize.y))) * s;\n"
+                        "    color = clamp(color, 0.0, 1.0);\n";
+                paramIndex += paramVec4Count(type);
+                continue;
+            }
+            shader += "    vec4 color = sampleSource(v_texCoord);\n";
+        }
+        // 每一步都截断到[0, 1]，与分多趟写入RGBA8纹理的结果保持一致
+        switch (type) {
+            case FILTER_GRAYSCALE:
+                shader += "    color.rgb = vec3(dot(color.rgb, vec3(0.299, 0.587, 0.114)));\n";
+                break;
+            case FILTER_COLOR_MATRIX:
+                snprintf(line, sizeof(line),
+                         "    color = clamp(mat4(u_params[%d], u_params[%d], u_params[%d], u_params[%d]) * color + u_params[%d], 0.0, 1.0);\n",
+                         paramIndex, paramIndex + 1, paramIndex + 2, paramIndex + 3,
+                         paramIndex + 4);
+                shader += line;
+                break;
+            case FILTER_BRIGHTNESS_CONTRAST:
+                snprintf(line, sizeof(line),
+                         "    color.rgb = clamp((color.rgb - 0.5) * u_params[%d].y + 0.5 + u_params[%d].x, 0.0, 1.0);\n",
+                         paramIndex, paramIndex);
+                shader += line;
+                break;
+            default:
+                break;
+        }
+        paramIndex += paramVec4Count(type);
+    }
+    if (!sampled) {
+        // 只有裁剪
+        shader += "    vec4 color = sampleSource(v_texCoord);\n";
+    }
+    shader += "    outColor = color;\n}\n";
+    return shader;
+}
+
+void FilterChain::ensurePingPong(int width, int height, bool convolution) {
+    if (mPingPongFboIds[0] != 0 && width <= mPingPongWidth && height <= mPingPongHeight
+        && (!convolution || mPingPongTextureIds[2] != 0)) {
+        return;
+    }
+    if (mPingPongFboIds[0] == 0) {
+        glGenFramebuffers(3, mPingPongFboIds);
+    } else {
+        // 只扩大不足的一边，另一边保持原来的大小，避免宽高交替变化时反复分配
+        width = width > mPingPongWidth ? width : mPingPongWidth;
+        height = height > mPingPongHeight ? height : mPingPongHeight;
+    }
+    LOGD(TAG, "ensurePingPong width=%d height=%d convolution=%d", width, height, convolution);
+    mPingPongWidth = width;
+    mPingPongHeight = height;
+    // 不可变存储不能重新分配，尺寸变化时重建纹理
+    for (int i = 0; i < 3; i++) {
+        if (mPingPongTextureIds[i] != 0) {
+            glDeleteTextures(1, &mPingPongTextureIds[i]);
+            mPingPongTextureIds[i] = 0;
+        }
+    }
+    int count = convolution ? 3 : 2;
+    glGenTextures(count, mPingPongTextureIds);
+    for (int i = 0; i < count; i++) {
+        glBindTexture(GL_TEXTURE_2D, mPingPongTextureIds[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, mPingPongFboIds[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               mPingPongTextureIds[i], 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+}
+
+void FilterChain::ensureQuad() {
+    if (mVaoId != 0) {
+        return;
+    }
+    GLfloat vVertices[] = {
+            -1.0f, -1.0f, 0.0f,
+            1.0f, -1.0f, 0.0f,
+            -1.0f, 1.0f, 0.0f,
+            1.0f, 1.0f, 0.0f,
+    };
+    GLfloat vTexCoors[] = {
+            0.0f, 0.0f,
+            1.0f, 0.0f,
+            0.0f, 1.0f,
+            1.0f, 1.0f,
+    };
+    GLushort indices[] = {0, 1, 2, 1, 2, 3};
+    glGenBuffers(3, mVboIds);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vVertices), vVertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[1]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vTexCoors), vTexCoors, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mVboIds[2]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &mVaoId);
+    glBindVertexArray(mVaoId);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[0]);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[1]);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mVboIds[2]);
+    glBindVertexArray(GL_NONE);
+}
+
+void FilterChain::Render(InputTexture *input, const GLfloat *texMatrix, int inWidth, int inHeight,
+                         GLuint outFboId) {
+    if (input->GetFormat() != mSourceFormat) {
+        // 第一趟的程序需要重新生成
+        mSourceFormat = input->GetFormat();
+        mDirty = true;
+    }
+    build(inWidth, inHeight);
+    if (mPasses.empty()) {
+        return;
+    }
+    ensureQuad();
+    if (mPasses.size() > 1) {
+        bool convolution = false;
+        for (const FilterPass &pass : mPasses) {
+            convolution |= pass.convolution;
+        }
+        ensurePingPong(inWidth, inHeight, convolution);
+    }
+
+    for (int i = 0; i < (int) mPasses.size(); i++) {
+        FilterPass &pass = mPasses[i];
+        bool last = i == (int) mPasses.size() - 1;
+        if (pass.convolution) {
+            renderConvolution(pass, i, last, outFboId);
+            continue;
+        }
+        if (pass.programId == 0) {
+            int sourceFormat = i == 0 ? mSourceFormat : IMAGE_FORMAT_RGBA;
+            pass.programId = mEnv->GetProgram(
+                    FILTER_VERTEX_SHADER, generateFragmentShader(pass, sourceFormat, i > 0).c_str());
+            if (pass.programId == 0) {
+                LOGE(TAG, "Render pass=%d program fail", i);
+                return;
+            }
+            pass.texMatrixLoc = glGetUniformLocation(pass.programId, "u_texMatrix");
+            pass.texelSizeLoc = glGetUniformLocation(pass.programId, "u_texelSize");
+            pass.paramsLoc = glGetUniformLocation(pass.programId, "u_params");
+            pass.uvMaxLoc = glGetUniformLocation(pass.programId, "u_uvMax");
+        }
+
+        // 第一趟读原图并带上调用方的变换，之后读上一趟写入的ping-pong纹理，有效区域只占纹理的一部分
+        int textureWidth = input->GetWidth();
+        int textureHeight = input->GetHeight();
+        GLfloat sourceMatrix[TEX_TRANSFORM_SIZE];
+        if (i == 0) {
+            memcpy(sourceMatrix, texMatrix, sizeof(sourceMatrix));
+        } else {
+            textureWidth = mPingPongWidth;
+            textureHeight = mPingPongHeight;
+            texTransformIdentity(sourceMatrix);
+            sourceMatrix[0] = (GLfloat) pass.inWidth / textureWidth;
+            sourceMatrix[4] = (GLfloat) pass.inHeight / textureHeight;
+        }
+        // 先裁剪，再映射到纹理
+        GLfloat crop[TEX_TRANSFORM_SIZE] = {pass.uvScale[0], 0.0f, pass.uvOffset[0],
+                                            0.0f, pass.uvScale[1], pass.uvOffset[1]};
+        GLfloat matrix[9];
+        texTransformConcat(sourceMatrix, crop, crop);
+        texTransformToMat3(crop, matrix);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, last ? outFboId : mPingPongFboIds[i % 2]);
+        glViewport(0, 0, pass.outWidth, pass.outHeight);
+        glUseProgram(pass.programId);
+        glUniformMatrix3fv(pass.texMatrixLoc, 1, GL_FALSE, matrix);
+        glUniform2f(pass.texelSizeLoc, 1.0f / textureWidth, 1.0f / textureHeight);
+        if (i > 0) {
+            glUniform2f(pass.uvMaxLoc, (pass.inWidth - 0.5f) / textureWidth,
+                        (pass.inHeight - 0.5f) / textureHeight);
+        }
+        if (pass.paramsLoc >= 0) {
+            glUniform4fv(pass.paramsLoc, (GLsizei) pass.uniformParams.size() / 4,
+                         pass.uniformParams.data());
+        }
+        if (i == 0) {
+            input->Bind(pass.programId);
+        } else {
+            glBindTexture(GL_TEXTURE_2D, mPingPongTextureIds[(i - 1) % 2]);
+        }
+        glBindVertexArray(mVaoId);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const void *) 0);
+    }
+    glBindVertexArray(GL_NONE);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    LOGD(TAG, "Render passCount=%d error=%d", (int) mPasses.size(), glGetError());
+}
+
+bool FilterChain::ensureConvProgram() {
+    if (mConvProgramId != 0) {
+        return true;
+    }
+    std::string shader = std::string("#version 300 es\n"
+                                     "precision highp float;\n"
+                                     "in vec2 v_texCoord;\n"
+                                     "layout(location = 0) out vec4 outColor;\n")
+                         + SAMPLE_PING_PONG + CONV_FRAGMENT_MAIN;
+    mConvProgramId = mEnv->GetProgram(FILTER_VERTEX_SHADER, shader.c_str());
+    if (mConvProgramId == 0) {
+        LOGE(TAG, "ensureConvProgram fail");
+        return false;
+    }
+    mConvTexMatrixLoc = glGetUniformLocation(mConvProgramId, "u_texMatrix");
+    mConvUvMaxLoc = glGetUniformLocation(mConvProgramId, "u_uvMax");
+    mConvStepLoc = glGetUniformLocation(mConvProgramId, "u_step");
+    mConvCenterLoc = glGetUniformLocation(mConvProgramId, "u_center");
+    mConvTapsLoc = glGetUniformLocation(mConvProgramId, "u_taps");
+    mConvTapCountLoc = glGetUniformLocation(mConvProgramId, "u_tapCount");
+    mConvSharpenLoc = glGetUniformLocation(mConvProgramId, "u_sharpen");
+    mConvAmountLoc = glGetUniformLocation(mConvProgramId, "u_amount");
+    mConvOriginalLoc = glGetUniformLocation(mConvProgramId, "s_Original");
+    return true;
+}
+
+bool FilterChain::ensureComputeProgram() {
+    if (!mComputeEnabled) {
+        return false;
+    }
+    if (mConvComputeProgramId != 0) {
+        return true;
+    }
+    if (mCompute == nullptr) {
+        mCompute = mEnv->LoadComputeFunctions();
+        if (mCompute == nullptr) {
+            LOGD(TAG, "compute shader not supported, use fragment shader");
+            mComputeEnabled = false;
+            return false;
+        }
+    }
+    mConvComputeProgramId = mEnv->GetComputeProgram(CONV_COMPUTE_SHADER);
+    if (mConvComputeProgramId == 0) {
+        LOGE(TAG, "ensureComputeProgram fail, use fragment shader");
+        mComputeEnabled = false;
+        return false;
+    }
+    mConvComputeSizeLoc = glGetUniformLocation(mConvComputeProgramId, "u_size");
+    mConvComputeVerticalLoc = glGetUniformLocation(mConvComputeProgramId, "u_vertical");
+    mConvComputeRadiusLoc = glGetUniformLocation(mConvComputeProgramId, "u_radius");
+    mConvComputeWeightsLoc = glGetUniformLocation(mConvComputeProgramId, "u_weights");
+    mConvComputeSharpenLoc = glGetUniformLocation(mConvComputeProgramId, "u_sharpen");
+    mConvComputeAmountLoc = glGetUniformLocation(mConvComputeProgramId, "u_amount");
+    mConvComputeOriginalLoc = glGetUniformLocation(mConvComputeProgramId, "s_Original");
+    return true;
+}
+
+void FilterChain::renderConvolution(const FilterPass &pass, int index, bool last,
+                                    GLuint outFboId) {
+    const FilterStage &stage = mStages[pass.firstStage];
+    bool sharpen = stage.type == FILTER_UNSHARP_MASK;
+    // 上一趟的结果，卷积趟之前总有一趟
+    GLuint source = mPingPongTextureIds[(index - 1) % 2];
+    int width = pass.inWidth;
+    int height = pass.inHeight;
+
+    if (ensureComputeProgram()) {
+        GLfloat weights[(FILTER_MAX_RADIUS / 4 + 1) * 4] = {0};
+        memcpy(weights, pass.weights.data(), pass.weights.size() * sizeof(GLfloat));
+        glUseProgram(mConvComputeProgramId);
+        glUniform2i(mConvComputeSizeLoc, width, height);
+        glUniform1i(mConvComputeRadiusLoc, pass.radius);
+        glUniform4fv(mConvComputeWeightsLoc, FILTER_MAX_RADIUS / 4 + 1, weights);
+        glUniform1f(mConvComputeAmountLoc, stage.params[1]);
+        glUniform1i(mConvComputeOriginalLoc, 1);
+        // 水平：上一趟的结果 -> 中间结果
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glUniform1i(mConvComputeVerticalLoc, 0);
+        glUniform1i(mConvComputeSharpenLoc, 0);
+        mCompute->bindImageTexture(0, mPingPongTextureIds[2], 0, GL_FALSE, 0, GL_WRITE_ONLY,
+                                   GL_RGBA8);
+        mCompute->dispatchCompute((width + CONV_GROUP_SIZE - 1) / CONV_GROUP_SIZE, height, 1);
+        mCompute->memoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        // 垂直：中间结果 -> 本趟的ping-pong纹理，USM锐化同时读取卷积前的结果
+        glBindTexture(GL_TEXTURE_2D, mPingPongTextureIds[2]);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glUniform1i(mConvComputeVerticalLoc, 1);
+        glUniform1i(mConvComputeSharpenLoc, sharpen ? 1 : 0);
+        mCompute->bindImageTexture(0, mPingPongTextureIds[index % 2], 0, GL_FALSE, 0,
+                                   GL_WRITE_ONLY, GL_RGBA8);
+        mCompute->dispatchCompute((height + CONV_GROUP_SIZE - 1) / CONV_GROUP_SIZE, width, 1);
+        mCompute->memoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+        if (last) {
+            // 调用方的FBO纹理不是不可变存储，不能作为image写入，拷贝过去
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, mPingPongFboIds[index % 2]);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outFboId);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT,
+                              GL_NEAREST);
+        }
+        return;
+    }
+
+    if (!ensureConvProgram()) {
+        return;
+    }
+    glUseProgram(mConvProgramId);
+    // 输出的[0, 1]映射到ping-pong纹理中的有效区域
+    GLfloat transform[TEX_TRANSFORM_SIZE];
+    texTransformIdentity(transform);
+    transform[0] = (GLfloat) width / mPingPongWidth;
+    transform[4] = (GLfloat) height / mPingPongHeight;
+    GLfloat matrix[9];
+    texTransformToMat3(transform, matrix);
+    glUniformMatrix3fv(mConvTexMatrixLoc, 1, GL_FALSE, matrix);
+    glUniform2f(mConvUvMaxLoc, (width - 0.5f) / mPingPongWidth, (height - 0.5f) / mPingPongHeight);
+    glUniform1f(mConvCenterLoc, pass.weights[0]);
+    glUniform2fv(mConvTapsLoc, (GLsizei) pass.uniformParams.size() / 2,
+                 pass.uniformParams.data());
+    glUniform1i(mConvTapCountLoc, (GLint) pass.uniformParams.size() / 2);
+    glUniform1f(mConvAmountLoc, stage.params[1]);
+    glUniform1i(mConvOriginalLoc, 1);
+    glBindVertexArray(mVaoId);
+    // 水平：上一趟的结果 -> 中间结果
+    glBindFramebuffer(GL_FRAMEBUFFER, mPingPongFboIds[2]);
+    glViewport(0, 0, width, height);
+    glUniform2f(mConvStepLoc, 1.0f / mPingPongWidth, 0.0f);
+    glUniform1i(mConvSharpenLoc, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const void *) 0);
+    // 垂直：中间结果 -> 本趟的输出，USM锐化同时读取卷积前的结果
+    glBindFramebuffer(GL_FRAMEBUFFER, last ? outFboId : mPingPongFboIds[index % 2]);
+    glUniform2f(mConvStepLoc, 0.0f, 1.0f / mPingPongHeight);
+    glUniform1i(mConvSharpenLoc, sharpen ? 1 : 0);
+    glBindTexture(GL_TEXTURE_2D, mPingPongTextureIds[2]);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const void *) 0);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    glBindVertexArray(GL_NONE);
+}
+
+void FilterChain::Release() {
+    LOGD(TAG, "Release");
+    if (mPingPongFboIds[0] != 0) {
+        glDeleteFramebuffers(3, mPingPongFboIds);
+        for (int i = 0; i < 3; i++) {
+            if (mPingPongTextureIds[i] != 0) {
+                glDeleteTextures(1, &mPingPongTextureIds[i]);
+            }
+        }
+    }
+    mPingPongFboIds[0] = mPingPongFboIds[1] = mPingPongFboIds[2] = 0;
+    mPingPongTextureIds[0] = mPingPongTextureIds[1] = mPingPongTextureIds[2] = 0;
+    mPingPongWidth = 0;
+    mPingPongHeight = 0;
+    if (mVaoId != 0) {
+        glDeleteVertexArrays(1, &mVaoId);
+        glDeleteBuffers(3, mVboIds);
+    }
+    mVaoId = 0;
+    // 程序由GlesEnv缓存
+    mConvProgramId = 0;
+    mConvComputeProgramId = 0;
+    mPasses.clear();
+    mDirty = true;
+}
@@ -0,0 +1,208 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_FILTERCHAIN_H
+#define GLLEARNING_FILTERCHAIN_H
+
+#include <GLES3/gl3.h>
+#include <string>
+#include <vector>
+#include "GlesEnv.h"
+#include "InputTexture.h"
+
+// 灰度，无参数
+#define FILTER_GRAYSCALE 0
+// 颜色矩阵，20个参数，与android.graphics.ColorMatrix一致：4x5行优先，偏移量取值0~255
+#define FILTER_COLOR_MATRIX 1
+// 亮度/对比度，2个参数：亮度偏移[-1, 1]，对比度系数（1为不变）
+#define FILTER_BRIGHTNESS_CONTRAST 2
+// 锐化，1个参数：强度（0为不变）
+#define FILTER_SHARPEN 3
+// 裁剪，4个参数：x、y、宽、高，单位为像素，相对于该阶段的输入图像
+#define FILTER_CROP 4
+// 高斯模糊，2个参数：半径（像素），sigma（<=0时为半径 / 3）
+#define FILTER_GAUSSIAN_BLUR 5
+// 方框模糊，1个参数：半径（像素），窗口为(2 * 半径 + 1)的正方形
+#define FILTER_BOX_BLUR 6
+// USM锐化，3个参数：半径（像素），强度（0为不变），sigma（<=0时为半径 / 3）
+// 输出 = 原图 + (原图 - 高斯模糊) * 强度
+#define FILTER_UNSHARP_MASK 7
+
+// 卷积滤镜的最大半径，超出时按最大值处理
+#define FILTER_MAX_RADIUS 128
+
+// 单个滤镜最多的参数个数
+#define FILTER_MAX_PARAMS 20
+
+/**
+ * 可组合的滤镜链
+ * 1. 逐像素的滤镜（灰度、颜色矩阵、亮度/对比度）相邻时合并生成一个片元shader，一次绘制完成
+ * 2. 需要采样邻域的滤镜（锐化）必须读取前一步的完整结果，作为新一趟绘制的开始
+ * 3. 裁剪只改变采样坐标与输出尺寸，合并进所在的那一趟绘制
+ * 4. 中间结果在两个FBO之间来回切换（ping-pong），最后一趟直接画到调用方的FBO
+ * 5. 模糊、USM锐化为可分离卷积，单独占一趟，先水平后垂直各执行一次，每像素采样次数与半径成正比：
+ *    - 支持OpenGL ES 3.1时用计算着色器，每个工作组把一行（列）的128个像素连同两侧半径宽的邻域
+ *      读入共享内存，之后的2 * 半径 + 1次乘加都只访问共享内存
+ *    - 否则用片元着色器，相邻两个抽头合并为一次双线性采样，采样点按两者的权重插值，采样次数减半
+ *    卷积读取上一趟的完整结果，位于第一个滤镜时先多画一趟变换后的原图
+ *
+ * 生成的程序通过GlesEnv缓存，滤镜结构相同的链只编译一次，参数以uniform传入
+ * */
+class FilterChain {
+
+private:
+
+    struct FilterStage {
+        int type;
+        GLfloat params[FILTER_MAX_PARAMS];
+    };
+
+    // 一趟绘制
+    struct FilterPass {
+        // 包含的滤镜范围 [firstStage, firstStage + stageCount)
+        int firstStage;
+        int stageCount;
+        // 本趟输入、输出尺寸
+        int inWidth;
+        int inHeight;
+        int outWidth;
+        int outHeight;
+        // 裁剪合并后的采样坐标变换：uv = offset + a_texCoord * scale
+        GLfloat uvOffset[2];
+        GLfloat uvScale[2];
+        GLuint programId;
+        GLint texMatrixLoc;
+        GLint texelSizeLoc;
+        GLint paramsLoc;
+        // 读取ping-pong纹理时有效区域的上限
+        GLint uvMaxLoc;
+        // 本趟uniform参数，每个滤镜占用的vec4个数见paramVec4Count
+        // 卷积趟为片元路径的合并抽头，每个抽头为偏移、权重
+        std::vector<GLfloat> uniformParams;
+        // 卷积趟，只包含一个卷积滤镜
+        bool convolution;
+        // 卷积核的半径与中心右侧的权重，权重[0]为中心，计算着色器路径使用
+        int radius;
+        std::vector<GLfloat> weights;
+    };
+
+    GlesEnv *mEnv;
+    std::vector<FilterStage> mStages;
+    std::vector<FilterPass> mPasses;
+    // 滤镜或输入尺寸变化后需重新划分
+    bool mDirty;
+    int mInWidth;
+    int mInHeight;
+    // 原图格式，第一趟的采样代码随之变化
+    int mSourceFormat;
+
+    // ping-pong 纹理与FBO，按输入尺寸分配，第三个为卷积水平方向的中间结果
+    // 纹理为不可变存储，计算着色器可以直接写入
+    GLuint mPingPongTextureIds[3];
+    GLuint mPingPongFboIds[3];
+    int mPingPongWidth;
+    int mPingPongHeight;
+
+    // 卷积程序，片元路径与计算着色器路径
+    GLuint mConvProgramId;
+    GLint mConvTexMatrixLoc;
+    GLint mConvUvMaxLoc;
+    GLint mConvStepLoc;
+    GLint mConvCenterLoc;
+    GLint mConvTapsLoc;
+    GLint mConvTapCountLoc;
+    GLint mConvSharpenLoc;
+    GLint mConvAmountLoc;
+    GLint mConvOriginalLoc;
+    GLuint mConvComputeProgramId;
+    GLint mConvComputeSizeLoc;
+    GLint mConvComputeVerticalLoc;
+    GLint mConvComputeRadiusLoc;
+    GLint mConvComputeWeightsLoc;
+    GLint mConvComputeSharpenLoc;
+    GLint mConvComputeAmountLoc;
+    GLint mConvComputeOriginalLoc;
+    // OpenGL ES 3.1的函数，首次创建计算程序时获取
+    const ComputeFunctions *mCompute;
+    // 是否允许使用计算着色器，不支持OpenGL ES 3.1或程序创建失败时置为false
+    bool mComputeEnabled;
+
+    // 全屏矩形，纹理坐标固定，旋转、镜像等由u_texMatrix完成
+    GLuint mVboIds[3];
+    GLuint mVaoId;
+
+    // 按输入尺寸划分绘制趟数并生成程序
+    void build(int inWidth, int inHeight);
+
+    // 生成一趟绘制的片元shader，sourceFormat为该趟输入纹理的格式，pingPong为是否读取上一趟的结果
+    std::string generateFragmentShader(const FilterPass &pass, int sourceFormat, bool pingPong);
+
+    // 确保ping-pong纹理足够大，convolution为是否需要卷积的中间结果
+    void ensurePingPong(int width, int height, bool convolution);
+
+    // 执行卷积趟，读取上一趟的结果，最后一趟写入outFboId
+    void renderConvolution(const FilterPass &pass, int index, bool last, GLuint outFboId);
+
+    // 计算着色器路径，不支持时返回false
+    bool ensureComputeProgram();
+
+    bool ensureConvProgram();
+
+    void ensureQuad();
+
+public:
+
+    explicit FilterChain(GlesEnv *env);
+
+    ~FilterChain();
+
+    /**
+     * 追加一个滤镜
+     *
+     * @param type FILTER_GRAYSCALE 等
+     * @param params 参数，个数不足时按默认值补齐
+     * @return 类型未知时返回false
+     * */
+    bool AddFilter(int type, const GLfloat *params, int paramCount);
+
+    // 清空滤镜
+    void Clear();
+
+    bool IsEmpty();
+
+    // 滤镜类型与参数的哈希，用于结果缓存的key，空链返回seed
+    unsigned long long Hash(unsigned long long seed);
+
+    // 输出像素依赖的邻域半径，单位为像素，分块渲染时每块需向外扩展这么多
+    int GetHaloSize();
+
+    // 合并后的绘制趟数，用于验证相邻的逐像素滤镜是否合并，卷积趟计为一趟
+    int GetPassCount(int inWidth, int inHeight);
+
+    /**
+     * 卷积是否允许使用计算着色器，默认允许，关闭后总是使用片元着色器，用于对比两条路径
+     * 不支持OpenGL ES 3.1时设置无效
+     * */
+    void SetComputeEnabled(bool enabled);
+
+    // 计算输出尺寸，裁剪会让输出小于输入
+    void GetOutputSize(int inWidth, int inHeight, int *outWidth, int *outHeight);
+
+    /**
+     * 执行滤镜链
+     *
+     * @param input 原图纹理，可以是YUV格式，第一趟绘制时转换为RGB
+     * @param texMatrix 第一趟绘制的采样坐标变换，见TexTransform.h，滤镜链看到的是变换后的图像
+     * @param inWidth 变换后的图像宽高，即滤镜链的输入尺寸
+     * @param outFboId 最后一趟输出的FBO，从(0, 0)开始写入GetOutputSize大小的区域
+     * */
+    void Render(InputTexture *input, const GLfloat *texMatrix, int inWidth, int inHeight,
+                GLuint outFboId);
+
+    // 释放GL资源，需在上下文所在线程调用
+    void Release();
+
+};
+
+#endif //GLLEARNING_FILTERCHAIN_H
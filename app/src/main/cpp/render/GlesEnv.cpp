@@ -0,0 +1,446 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "GlesEnv.h"
+#include <EGL/eglext.h>
+#include "myutils.h"
+#include <cstdlib>
+#include <cstring>
+
+#define TAG "GlesEnv"
+
+GlesEnv *GlesEnv::sInstance = nullptr;
+int GlesEnv::sRefCount = 0;
+std::mutex GlesEnv::sLock;
+ProgramCache GlesEnv::sProgramCache;
+// 函数地址与上下文无关，所有环境共用
+static ComputeFunctions sComputeFunctions = {nullptr, nullptr, nullptr};
+
+// 编译shader，失败时打印日志并返回0
+static GLuint compileShader(GLenum type, const char *shaderStr) {
+    GLuint shader = glCreateShader(type);
+    if (shader == 0) {
+        LOGE(TAG, "glCreateShader type=%d error=%d", type, glGetError());
+        return 0;
+    }
+    // 替换着色器对象的源代码
+    GLint sourceLen = strlen(shaderStr);
+    glShaderSource(shader, 1, &shaderStr, &sourceLen);
+    // 编译shader
+    glCompileShader(shader);
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE) {
+        char log[512] = {0};
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        LOGE(TAG, "glCompileShader type=%d fail: %s", type, log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// 链接已编译的shader，链接后shader对象即删除，失败返回0
+static GLuint linkProgram(GLuint programId, const GLuint *shaders, int count) {
+    for (int i = 0; i < count; i++) {
+        glAttachShader(programId, shaders[i]);
+    }
+    glLinkProgram(programId);
+    // 链接完成后shader对象不再需要，程序保留编译结果
+    for (int i = 0; i < count; i++) {
+        glDetachShader(programId, shaders[i]);
+        glDeleteShader(shaders[i]);
+    }
+    GLint linked = GL_FALSE;
+    glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        char log[512] = {0};
+        glGetProgramInfoLog(programId, sizeof(log), nullptr, log);
+        LOGE(TAG, "glLinkProgram fail: %s", log);
+        glDeleteProgram(programId);
+        return 0;
+    }
+    return programId;
+}
+
+GlesEnv::GlesEnv() {
+    mEglDisplay = EGL_NO_DISPLAY;
+    mEglConfig = nullptr;
+    mEglSurface = EGL_NO_SURFACE;
+    mEglContext = EGL_NO_CONTEXT;
+    mShared = false;
+}
+
+GlesEnv::~GlesEnv() {
+    LOGD(TAG, "GlesEnv un constructor");
+}
+
+GlesEnv *GlesEnv::Acquire() {
+    std::lock_guard<std::mutex> lockGuard(sLock);
+    if (sInstance == nullptr) {
+        GlesEnv *env = new GlesEnv();
+        if (!env->create(EGL_NO_CONTEXT)) {
+            env->destroy();
+            delete env;
+            return nullptr;
+        }
+        sInstance = env;
+    } else if (!sInstance->MakeCurrent()) {
+        return nullptr;
+    }
+    sRefCount++;
+    LOGD(TAG, "Acquire refCount=%d", sRefCount);
+    return sInstance;
+}
+
+void GlesEnv::Release() {
+    std::lock_guard<std::mutex> lockGuard(sLock);
+    if (sRefCount > 0) {
+        sRefCount--;
+    }
+    LOGD(TAG, "Release refCount=%d", sRefCount);
+}
+
+GlesEnv *GlesEnv::CreateShared() {
+    EGLContext shareContext;
+    {
+        std::lock_guard<std::mutex> lockGuard(sLock);
+        if (sInstance == nullptr) {
+            LOGE(TAG, "CreateShared before Acquire");
+            return nullptr;
+        }
+        // 工作上下文存在期间共享环境不能被Terminate
+        sRefCount++;
+        shareContext = sInstance->mEglContext;
+    }
+    GlesEnv *env = new GlesEnv();
+    env->mShared = true;
+    if (!env->create(shareContext)) {
+        env->destroy();
+        delete env;
+        Release();
+        return nullptr;
+    }
+    LOGD(TAG, "CreateShared context=%p", env->mEglContext);
+    return env;
+}
+
+void GlesEnv::DestroyShared(GlesEnv *env) {
+    if (env == nullptr) {
+        return;
+    }
+    env->destroy();
+    delete env;
+    Release();
+}
+
+void GlesEnv::Terminate() {
+    std::lock_guard<std::mutex> lockGuard(sLock);
+    LOGD(TAG, "Terminate refCount=%d", sRefCount);
+    if (sInstance == nullptr || sRefCount > 0) {
+        return;
+    }
+    sInstance->destroy();
+    delete sInstance;
+    sInstance = nullptr;
+}
+
+// 获取EGLDisplay
+// 主机构建（如基准测试）没有窗口系统时，未指定EGL_PLATFORM则优先使用Mesa的surfaceless平台
+static EGLDisplay getDisplay() {
+#ifndef __ANDROID__
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (getenv("EGL_PLATFORM") == nullptr && extensions != nullptr
+        && strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay != nullptr) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                                    EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+#endif
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+// 创建 GLES 环境，一般步骤如下：
+// 1. 获取 EGLDisplay 对象，建立与本地窗口系统的连接
+//        调用 eglGetDisplay 方法得到 EGLDisplay。
+// 2. 初始化 EGL 方法
+//        打开连接之后，调用 eglInitialize 方法初始化。
+// 3. 获取 EGLConfig 对象，确定渲染表面的配置信息
+//        调用 eglChooseConfig 方法得到 EGLConfig。
+// 4. 创建渲染表面 EGLSurface
+//        通过 EGLDisplay 和 EGLConfig ，调用 eglCreateWindowSurface 或 eglCreatePbufferSurface 方法创建渲染表面，得到 EGLSurface，其中 eglCreateWindowSurface 用于创建屏幕上渲染区域，eglCreatePbufferSurface 用于创建屏幕外渲染区域。
+// 5. **创建渲染上下文 EGLContext **
+//        通过 EGLDisplay 和 EGLConfig ，调用 eglCreateContext 方法创建渲染上下文，得到 EGLContext。
+// 6. 绑定上下文
+//        通过 eglMakeCurrent 方法将 EGLSurface、EGLContext、EGLDisplay 三者绑定，绑定成功之后 OpenGLES 环境就创建好了，接下来便可以进行渲染。
+// 7. 交换缓冲
+//        OpenGLES 绘制结束后，使用 eglSwapBuffers 方法交换前后缓冲，将绘制内容显示到屏幕上，而屏幕外的渲染不需要调用此方法。
+// 8. 释放 EGL 环境
+//        绘制结束后，不再需要使用 EGL 时，需要取消 eglMakeCurrent 的绑定，销毁 EGLDisplay、EGLSurface、EGLContext 三个对象。
+bool GlesEnv::create(EGLContext shareContext) {
+    LOGD(TAG, "create");
+    // EGL config 属性
+    const EGLint confAttr[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+            // EGL_WINDOW_BIT EGL_PBUFFER_BIT we will create a pixelbuffer surface
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,// if you need the alpha channel
+            EGL_DEPTH_SIZE, 8,// if you need the depth buffer
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+    };
+    // 没有pbuffer配置时的退路，只渲染到FBO，不需要表面与深度、模板缓冲，
+    // 上下文不绑定表面，需要EGL_KHR_surfaceless_context
+    const EGLint fallbackConfAttr[] = {
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+            EGL_SURFACE_TYPE, 0,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_NONE
+    };
+
+    // EGL context 属性
+    const EGLint ctxAttr[] = {
+            EGL_CONTEXT_CLIENT_VERSION, 3, // shader使用#version 300 es，需要OpenGL ES 3.0上下文
+            EGL_NONE
+    };
+
+    // surface 属性，只做离屏渲染，1x1即可
+    const EGLint surfaceAttr[] = {
+            EGL_WIDTH, 1,
+            EGL_HEIGHT, 1,
+            EGL_NONE
+    };
+
+    EGLint eglMajVers, eglMinVers; // 版本信息
+    EGLint numConfigs;
+
+    // 1.获取EGLDisplay对象，建立与本地窗口系统的连接
+    mEglDisplay = getDisplay();
+    if (mEglDisplay == EGL_NO_DISPLAY) {
+        LOGE(TAG, "eglGetDisplay fail, eglError=%d", eglGetError());
+        return false;
+    }
+
+    // 2. 初始化 EGL 方法
+    EGLBoolean ret = eglInitialize(mEglDisplay, &eglMajVers, &eglMinVers);
+    LOGD(TAG, "eglInitialize ret=%d, eglMajVers=%d, eglMinVers=%d", ret, eglMajVers, eglMinVers);
+    if (ret != EGL_TRUE) {
+        mEglDisplay = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    // 3. 获取EGLConfig对象，确定渲染表面的配置信息
+    numConfigs = 0;
+    ret = eglChooseConfig(mEglDisplay, confAttr, &mEglConfig, 1, &numConfigs);
+    LOGD(TAG, "eglChooseConfig ret=%d, numConfigs=%d", ret, numConfigs);
+    bool pbuffer = ret == EGL_TRUE && numConfigs > 0;
+    if (!pbuffer) {
+        numConfigs = 0;
+        ret = eglChooseConfig(mEglDisplay, fallbackConfAttr, &mEglConfig, 1, &numConfigs);
+        LOGW(TAG, "no pbuffer config, fallback ret=%d, numConfigs=%d", ret, numConfigs);
+        if (ret != EGL_TRUE || numConfigs < 1) {
+            LOGE(TAG, "eglChooseConfig fail, eglError=%d", eglGetError());
+            return false;
+        }
+    }
+
+    // 4. 创建渲染表面EGLSurface，使用eglCreatePbufferSurface创建屏幕外渲染区域
+    mEglSurface = pbuffer ? eglCreatePbufferSurface(mEglDisplay, mEglConfig, surfaceAttr)
+                          : EGL_NO_SURFACE;
+    LOGD(TAG, "mEglSurface == EGL_NO_SURFACE ? %d eglError=%d", (mEglSurface == EGL_NO_SURFACE),
+         eglGetError());
+
+    // 5. 创建渲染上下文 EGLContext
+    mEglContext = eglCreateContext(mEglDisplay, mEglConfig, shareContext, ctxAttr);
+    LOGD(TAG, "mEglContext == EGL_NO_CONTEXT ? %d eglError=%d", (mEglContext == EGL_NO_CONTEXT),
+         eglGetError());
+    if (mEglContext == EGL_NO_CONTEXT) {
+        return false;
+    }
+
+    // 6. 绑定上下文
+    if (!MakeCurrent()) {
+        return false;
+    }
+    if (shareContext == EGL_NO_CONTEXT) {
+        sProgramCache.Init();
+    }
+    return true;
+}
+
+void GlesEnv::destroy() {
+    LOGD(TAG, "destroy programCount=%d", (int) mProgramMap.size());
+    if (mEglDisplay == EGL_NO_DISPLAY) {
+        return;
+    }
+    // 程序属于上下文，需要在上下文销毁前删除
+    if (mEglContext != EGL_NO_CONTEXT && MakeCurrent()) {
+        for (auto &item : mProgramMap) {
+            glDeleteProgram(item.second);
+        }
+    }
+    mProgramMap.clear();
+
+    // 8. 释放EGL环境
+    // 解绑上下文
+    eglMakeCurrent(mEglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (mEglContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(mEglDisplay, mEglContext);
+    }
+    if (mEglSurface != EGL_NO_SURFACE) {
+        eglDestroySurface(mEglDisplay, mEglSurface);
+    }
+    eglReleaseThread();
+    // 工作上下文与共享环境使用同一个display，只由共享环境terminate
+    if (!mShared) {
+        eglTerminate(mEglDisplay);
+    }
+
+    mEglDisplay = EGL_NO_DISPLAY;
+    mEglConfig = nullptr;
+    mEglSurface = EGL_NO_SURFACE;
+    mEglContext = EGL_NO_CONTEXT;
+}
+
+bool GlesEnv::MakeCurrent() {
+    if (eglGetCurrentContext() == mEglContext) {
+        return true;
+    }
+    EGLBoolean ret = eglMakeCurrent(mEglDisplay, mEglSurface, mEglSurface, mEglContext);
+    if (ret != EGL_TRUE) {
+        LOGE(TAG, "eglMakeCurrent fail, eglError=%d", eglGetError());
+        return false;
+    }
+    return true;
+}
+
+GLuint GlesEnv::GetProgram(const char *vShaderStr, const char *fShaderStr) {
+    // 工作上下文各自链接一份：uniform的值属于程序对象，多个上下文共用同一程序时会相互覆盖
+    // 以两段源码拼接作为key，'\0'分隔避免拼接歧义
+    std::string key(vShaderStr);
+    key.push_back('\0');
+    key.append(fShaderStr);
+
+    std::lock_guard<std::mutex> lockGuard(sLock);
+    auto iterator = mProgramMap.find(key);
+    if (iterator != mProgramMap.end()) {
+        return iterator->second;
+    }
+
+    // 内存未命中，先尝试磁盘缓存，避免编译
+    GLuint programId = sProgramCache.Load(key);
+    if (programId != 0) {
+        mProgramMap[key] = programId;
+        return programId;
+    }
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vShaderStr);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fShaderStr);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+
+    // 创建程序
+    programId = glCreateProgram();
+    sProgramCache.PrepareLink(programId);
+    // 绑定shader并链接
+    GLuint shaders[] = {vertexShader, fragmentShader};
+    programId = linkProgram(programId, shaders, 2);
+    if (programId == 0) {
+        return 0;
+    }
+    LOGD(TAG, "GetProgram new programId=%d, programCount=%d", programId,
+         (int) mProgramMap.size() + 1);
+    mProgramMap[key] = programId;
+    sProgramCache.Save(key, programId);
+    return programId;
+}
+
+bool GlesEnv::SupportCompute() {
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    return major > 3 || (major == 3 && minor >= 1);
+}
+
+const ComputeFunctions *GlesEnv::LoadComputeFunctions() {
+    if (!SupportCompute()) {
+        LOGD(TAG, "compute shader needs OpenGL ES 3.1");
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lockGuard(sLock);
+    if (sComputeFunctions.dispatchCompute == nullptr) {
+        ComputeFunctions functions;
+        functions.dispatchCompute = (void (*)(GLuint, GLuint, GLuint)) eglGetProcAddress(
+                "glDispatchCompute");
+        functions.memoryBarrier = (void (*)(GLbitfield)) eglGetProcAddress("glMemoryBarrier");
+        functions.bindImageTexture =
+                (void (*)(GLuint, GLuint, GLint, GLboolean, GLint, GLenum, GLenum))
+                        eglGetProcAddress("glBindImageTexture");
+        if (functions.dispatchCompute == nullptr || functions.memoryBarrier == nullptr
+            || functions.bindImageTexture == nullptr) {
+            LOGE(TAG, "eglGetProcAddress compute functions fail");
+            return nullptr;
+        }
+        sComputeFunctions = functions;
+    }
+    return &sComputeFunctions;
+}
+
+GLuint GlesEnv::GetComputeProgram(const char *cShaderStr) {
+    // 与顶点 + 片元程序的key不会冲突，后者中间带有'\0'
+    std::string key(cShaderStr);
+
+    std::lock_guard<std::mutex> lockGuard(sLock);
+    auto iterator = mProgramMap.find(key);
+    if (iterator != mProgramMap.end()) {
+        return iterator->second;
+    }
+    GLuint programId = sProgramCache.Load(key);
+    if (programId != 0) {
+        mProgramMap[key] = programId;
+        return programId;
+    }
+
+    GLuint computeShader = compileShader(GL_COMPUTE_SHADER, cShaderStr);
+    if (computeShader == 0) {
+        return 0;
+    }
+    programId = glCreateProgram();
+    sProgramCache.PrepareLink(programId);
+    programId = linkProgram(programId, &computeShader, 1);
+    if (programId == 0) {
+        return 0;
+    }
+    LOGD(TAG, "GetComputeProgram new programId=%d, programCount=%d", programId,
+         (int) mProgramMap.size() + 1);
+    mProgramMap[key] = programId;
+    sProgramCache.Save(key, programId);
+    return programId;
+}
+
+void GlesEnv::SetProgramCacheDir(const char *directory) {
+    std::lock_guard<std::mutex> lockGuard(sLock);
+    sProgramCache.SetDirectory(directory);
+}
+
+void GlesEnv::GetProgramCacheStats(int *stats) {
+    std::lock_guard<std::mutex> lockGuard(sLock);
+    sProgramCache.GetStats(stats);
+}
@@ -0,0 +1,172 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_GLESENV_H
+#define GLLEARNING_GLESENV_H
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include "ProgramCache.h"
+
+// OpenGL ES 3.1，gl3.h中没有定义
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_FRAMEBUFFER_BARRIER_BIT
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#endif
+
+// OpenGL ES 3.1的函数，通过eglGetProcAddress获取，minSdkVersion不受影响，见GlesEnv::LoadComputeFunctions
+struct ComputeFunctions {
+    void (*dispatchCompute)(GLuint numGroupsX, GLuint numGroupsY, GLuint numGroupsZ);
+
+    void (*memoryBarrier)(GLbitfield barriers);
+
+    void (*bindImageTexture)(GLuint unit, GLuint texture, GLint level, GLboolean layered,
+                             GLint layer, GLenum access, GLenum format);
+};
+
+/**
+ * 进程内共享的OpenGL ES运行环境
+ * 1. EGLDisplay、EGLContext、EGLSurface只在第一次Acquire时创建
+ * 2. 引用计数归零时保留环境，供后续BgRender复用，只有Terminate才真正释放
+ * 3. 缓存已链接的shader程序，相同的shader源码只编译、链接一次
+ * 4. 设置缓存目录后，程序二进制会写入磁盘，下次启动直接加载，见ProgramCache
+ * 5. CreateShared创建与共享环境同一share group的工作上下文，用于多线程并行渲染，
+ *    纹理等对象可共享，程序由每个上下文各自链接、缓存一份，避免多个线程同时修改同一程序的uniform；
+ *    开启磁盘缓存时之后的上下文直接加载二进制，不再编译
+ *
+ * 注意：EGLContext同一时刻只能在一个线程current，所有使用者需在同一线程调用，JNI层统一在RenderThread中调用
+ * */
+class GlesEnv {
+
+private:
+    // Display 对象
+    EGLDisplay mEglDisplay;
+    // config信息
+    EGLConfig mEglConfig;
+    // 渲染绘制表面
+    EGLSurface mEglSurface;
+    // 渲染上下文
+    EGLContext mEglContext;
+    // 是否为CreateShared创建的工作上下文
+    bool mShared;
+
+    // shader源码 -> 已链接的程序id，每个上下文一份
+    std::map<std::string, GLuint> mProgramMap;
+
+    // 单例
+    static GlesEnv *sInstance;
+    // 引用计数
+    static int sRefCount;
+    static std::mutex sLock;
+    // 程序二进制磁盘缓存，跨环境保留配置与统计
+    static ProgramCache sProgramCache;
+
+    GlesEnv();
+
+    ~GlesEnv();
+
+    // 创建EGL环境，shareContext不为EGL_NO_CONTEXT时与其共享纹理、程序等对象，成功返回true
+    bool create(EGLContext shareContext);
+
+    // 释放缓存的程序以及EGL环境
+    void destroy();
+
+public:
+
+    /**
+     * 获取共享环境，引用计数+1，首次调用时创建EGL环境
+     * 返回前已在当前线程eglMakeCurrent
+     *
+     * @return 创建失败时返回nullptr
+     * */
+    static GlesEnv *Acquire();
+
+    /**
+     * 引用计数-1，计数归零时环境依然保留
+     * */
+    static void Release();
+
+    /**
+     * 释放所有缓存的程序并销毁EGL环境，仅在引用计数为0时生效
+     * */
+    static void Terminate();
+
+    /**
+     * 设置程序二进制缓存目录，传空字符串关闭磁盘缓存
+     * */
+    static void SetProgramCacheDir(const char *directory);
+
+    /**
+     * 获取程序缓存命中、未命中、过期次数
+     *
+     * @param stats 长度为PROGRAM_CACHE_STATS_COUNT
+     * */
+    static void GetProgramCacheStats(int *stats);
+
+    /**
+     * 创建一个与共享环境同一share group的工作上下文，并绑定到当前线程
+     * 持有共享环境的一个引用；需先调用Acquire创建共享环境，否则返回nullptr
+     *
+     * @return 创建失败时返回nullptr
+     * */
+    static GlesEnv *CreateShared();
+
+    /**
+     * 销毁CreateShared创建的工作上下文并归还共享环境的引用，需在其绑定的线程调用
+     * */
+    static void DestroyShared(GlesEnv *env);
+
+    // 将本环境的上下文绑定到当前线程
+    bool MakeCurrent();
+
+    /**
+     * 从缓存中获取程序，未命中时编译并链接
+     *
+     * @param vShaderStr 顶点shader源码
+     * @param fShaderStr 片元shader源码
+     * @return 程序id，失败返回0
+     * */
+    GLuint GetProgram(const char *vShaderStr, const char *fShaderStr);
+
+    /**
+     * 当前上下文是否支持计算着色器，即OpenGL ES 3.1及以上
+     * 上下文按3.0请求，驱动通常会返回其支持的最高兼容版本
+     * */
+    bool SupportCompute();
+
+    /**
+     * 获取OpenGL ES 3.1的计算着色器相关函数，进程内只加载一次
+     *
+     * @return 当前上下文不支持计算着色器或加载失败时返回nullptr
+     * */
+    const ComputeFunctions *LoadComputeFunctions();
+
+    /**
+     * 从缓存中获取计算着色器程序，未命中时编译并链接，需先确认SupportCompute
+     *
+     * @param cShaderStr 计算shader源码
+     * @return 程序id，失败返回0
+     * */
+    GLuint GetComputeProgram(const char *cShaderStr);
+
+};
+
+#endif //GLLEARNING_GLESENV_H
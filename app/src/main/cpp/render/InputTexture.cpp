@@ -0,0 +1,273 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "InputTexture.h"
+#include "myutils.h"
+#include <cstring>
+
+#define TAG "InputTexture"
+
+static const char *SAMPLE_RGBA =
+        "uniform sampler2D s_TextureMap;\n"
+        "vec4 sampleSource(vec2 coord)\n"
+        "{\n"
+        "    return texture(s_TextureMap, coord);\n"
+        "}\n";
+
+// NV21的色度纹理 r = V，g = U
+static const char *SAMPLE_NV21 =
+        "uniform sampler2D s_TextureMap;\n"
+        "uniform sampler2D s_ChromaMap;\n"
+        "uniform mat4 u_yuvMatrix;\n"
+        "vec4 sampleSource(vec2 coord)\n"
+        "{\n"
+        "    vec2 vu = texture(s_ChromaMap, coord).rg;\n"
+        "    vec4 yuv = vec4(texture(s_TextureMap, coord).r, vu.g, vu.r, 1.0);\n"
+        "    return vec4(clamp((u_yuvMatrix * yuv).rgb, 0.0, 1.0), 1.0);\n"
+        "}\n";
+
+static const char *SAMPLE_NV12 =
+        "uniform sampler2D s_TextureMap;\n"
+        "uniform sampler2D s_ChromaMap;\n"
+        "uniform mat4 u_yuvMatrix;\n"
+        "vec4 sampleSource(vec2 coord)\n"
+        "{\n"
+        "    vec4 yuv = vec4(texture(s_TextureMap, coord).r, texture(s_ChromaMap, coord).rg, 1.0);\n"
+        "    return vec4(clamp((u_yuvMatrix * yuv).rgb, 0.0, 1.0), 1.0);\n"
+        "}\n";
+
+static const char *SAMPLE_I420 =
+        "uniform sampler2D s_TextureMap;\n"
+        "uniform sampler2D s_ChromaMap;\n"
+        "uniform sampler2D s_ChromaMap2;\n"
+        "uniform mat4 u_yuvMatrix;\n"
+        "vec4 sampleSource(vec2 coord)\n"
+        "{\n"
+        "    vec4 yuv = vec4(texture(s_TextureMap, coord).r, texture(s_ChromaMap, coord).r,\n"
+        "                    texture(s_ChromaMap2, coord).r, 1.0);\n"
+        "    return vec4(clamp((u_yuvMatrix * yuv).rgb, 0.0, 1.0), 1.0);\n"
+        "}\n";
+
+InputTexture::InputTexture() {
+    mTextureIds[0] = mTextureIds[1] = mTextureIds[2] = 0;
+    mFormat = IMAGE_FORMAT_RGBA;
+    mWidth = 0;
+    mHeight = 0;
+    mExternal = false;
+    mStandard = YUV_STANDARD_BT601;
+    mFullRange = true;
+    mBoundProgramId = 0;
+    mChromaLoc = -1;
+    mChroma2Loc = -1;
+    mYuvMatrixLoc = -1;
+    updateYuvMatrix();
+}
+
+InputTexture::~InputTexture() {
+    LOGD(TAG, "InputTexture un constructor");
+}
+
+int InputTexture::GetDataSize(int format, int width, int height) {
+    // 色度平面宽高向上取整，与Android的YUV_420_888一致
+    int chromaSize = ((width + 1) / 2) * ((height + 1) / 2);
+    switch (format) {
+        case IMAGE_FORMAT_RGBA:
+            return width * height * 4;
+        case IMAGE_FORMAT_NV21:
+        case IMAGE_FORMAT_NV12:
+        case IMAGE_FORMAT_I420:
+            return width * height + chromaSize * 2;
+        case IMAGE_FORMAT_GRAY:
+            return width * height;
+        case IMAGE_FORMAT_RGB565:
+            return width * height * 2;
+        case IMAGE_FORMAT_RGB:
+            return width * height * 3;
+        default:
+            return 0;
+    }
+}
+
+const char *InputTexture::GetSampleFunction(int format) {
+    switch (format) {
+        case IMAGE_FORMAT_NV21:
+            return SAMPLE_NV21;
+        case IMAGE_FORMAT_NV12:
+            return SAMPLE_NV12;
+        case IMAGE_FORMAT_I420:
+            return SAMPLE_I420;
+        default:
+            return SAMPLE_RGBA;
+    }
+}
+
+void InputTexture::uploadPlane(int index, GLint internalFormat, GLenum format, int width,
+                               int height, const void *data, bool realloc) {
+    if (mTextureIds[index] == 0) {
+        glGenTextures(1, &mTextureIds[index]);
+        glBindTexture(GL_TEXTURE_2D, mTextureIds[index]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        realloc = true;
+    } else {
+        glBindTexture(GL_TEXTURE_2D, mTextureIds[index]);
+    }
+    if (realloc) {
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE,
+                     data);
+    } else {
+        // 复用已分配的纹理内存，只上传像素
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+    }
+}
+
+bool InputTexture::Upload(int format, int width, int height, const void *data) {
+    if (format > IMAGE_FORMAT_I420 || GetDataSize(format, width, height) == 0) {
+        // 灰度、RGB565、RGB只用于输出
+        LOGE(TAG, "Upload unknown format=%d", format);
+        return false;
+    }
+    if (mExternal) {
+        // 不能写入外部的纹理
+        mTextureIds[0] = 0;
+        mExternal = false;
+    }
+    bool realloc = format != mFormat || width != mWidth || height != mHeight;
+    if (realloc) {
+        LOGD(TAG, "Upload realloc format=%d width=%d height=%d", format, width, height);
+    }
+    mFormat = format;
+    mWidth = width;
+    mHeight = height;
+
+    const GLubyte *bytes = (const GLubyte *) data;
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    if (format == IMAGE_FORMAT_RGBA) {
+        uploadPlane(0, GL_RGBA, GL_RGBA, width, height, bytes, realloc);
+    } else {
+        // 单通道平面的行宽不一定是4的倍数
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        uploadPlane(0, GL_R8, GL_RED, width, height, bytes, realloc);
+        bytes = bytes == nullptr ? nullptr : bytes + width * height;
+        if (format == IMAGE_FORMAT_I420) {
+            uploadPlane(1, GL_R8, GL_RED, chromaWidth, chromaHeight, bytes, realloc);
+            bytes = bytes == nullptr ? nullptr : bytes + chromaWidth * chromaHeight;
+            uploadPlane(2, GL_R8, GL_RED, chromaWidth, chromaHeight, bytes, realloc);
+        } else {
+            uploadPlane(1, GL_RG8, GL_RG, chromaWidth, chromaHeight, bytes, realloc);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    return true;
+}
+
+void InputTexture::Wrap(GLuint textureId, int width, int height) {
+    if (!mExternal) {
+        Release();
+    }
+    mTextureIds[0] = textureId;
+    mFormat = IMAGE_FORMAT_RGBA;
+    mWidth = width;
+    mHeight = height;
+    mExternal = true;
+}
+
+void InputTexture::SetColorSpace(int standard, bool fullRange) {
+    mStandard = standard == YUV_STANDARD_BT709 ? YUV_STANDARD_BT709 : YUV_STANDARD_BT601;
+    mFullRange = fullRange;
+    updateYuvMatrix();
+}
+
+// R = Y + 2(1 - Kr)V，B = Y + 2(1 - Kb)U，G = Y - 2Kb(1 - Kb)/Kg U - 2Kr(1 - Kr)/Kg V
+// 视频范围先将Y从[16, 235]、UV从[16, 240]拉伸到全范围
+void InputTexture::updateYuvMatrix() {
+    float kr = mStandard == YUV_STANDARD_BT709 ? 0.2126f : 0.299f;
+    float kb = mStandard == YUV_STANDARD_BT709 ? 0.0722f : 0.114f;
+    float kg = 1.0f - kr - kb;
+    float yScale = mFullRange ? 1.0f : 255.0f / 219.0f;
+    float cScale = mFullRange ? 1.0f : 255.0f / 224.0f;
+    float yOffset = mFullRange ? 0.0f : 16.0f / 255.0f;
+    float cOffset = 128.0f / 255.0f;
+
+    float rv = 2.0f * (1.0f - kr) * cScale;
+    float gu = -2.0f * kb * (1.0f - kb) / kg * cScale;
+    float gv = -2.0f * kr * (1.0f - kr) / kg * cScale;
+    float bu = 2.0f * (1.0f - kb) * cScale;
+    GLfloat matrix[16] = {
+            // y
+            yScale, yScale, yScale, 0.0f,
+            // u
+            0.0f, gu, bu, 0.0f,
+            // v
+            rv, gv, 0.0f, 0.0f,
+            // 偏移
+            -yScale * yOffset - rv * cOffset,
+            -yScale * yOffset - (gu + gv) * cOffset,
+            -yScale * yOffset - bu * cOffset,
+            1.0f,
+    };
+    memcpy(mYuvMatrix, matrix, sizeof(matrix));
+}
+
+int InputTexture::GetFormat() {
+    return mFormat;
+}
+
+int InputTexture::GetWidth() {
+    return mWidth;
+}
+
+int InputTexture::GetHeight() {
+    return mHeight;
+}
+
+int InputTexture::GetStandard() {
+    return mStandard;
+}
+
+bool InputTexture::IsFullRange() {
+    return mFullRange;
+}
+
+void InputTexture::Bind(GLuint programId) {
+    if (programId != mBoundProgramId) {
+        mBoundProgramId = programId;
+        mChromaLoc = glGetUniformLocation(programId, "s_ChromaMap");
+        mChroma2Loc = glGetUniformLocation(programId, "s_ChromaMap2");
+        mYuvMatrixLoc = glGetUniformLocation(programId, "u_yuvMatrix");
+    }
+    if (mFormat != IMAGE_FORMAT_RGBA) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, mTextureIds[1]);
+        glUniform1i(mChromaLoc, 1);
+        if (mFormat == IMAGE_FORMAT_I420) {
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, mTextureIds[2]);
+            glUniform1i(mChroma2Loc, 2);
+        }
+        glUniformMatrix4fv(mYuvMatrixLoc, 1, GL_FALSE, mYuvMatrix);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mTextureIds[0]);
+}
+
+void InputTexture::Release() {
+    if (mExternal) {
+        mTextureIds[0] = 0;
+        mExternal = false;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (mTextureIds[i] != 0) {
+            glDeleteTextures(1, &mTextureIds[i]);
+            mTextureIds[i] = 0;
+        }
+    }
+    mWidth = 0;
+    mHeight = 0;
+    mBoundProgramId = 0;
+}
@@ -0,0 +1,122 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_INPUTTEXTURE_H
+#define GLLEARNING_INPUTTEXTURE_H
+
+#include <GLES3/gl3.h>
+
+// RGBA，每像素4字节
+#define IMAGE_FORMAT_RGBA 0
+// YUV420SP，Y平面之后为VU交错平面，Android相机默认格式
+#define IMAGE_FORMAT_NV21 1
+// YUV420SP，Y平面之后为UV交错平面
+#define IMAGE_FORMAT_NV12 2
+// YUV420P，依次为Y、U、V三个平面
+#define IMAGE_FORMAT_I420 3
+// 以下格式只用于输出，见BgRender::SetOutputFormat
+// 单通道亮度，每像素1字节
+#define IMAGE_FORMAT_GRAY 4
+// RGB565，每像素2字节，小端，与Bitmap.Config.RGB_565一致
+#define IMAGE_FORMAT_RGB565 5
+// RGB紧密排列，每像素3字节
+#define IMAGE_FORMAT_RGB 6
+
+// YUV转RGB的系数标准
+#define YUV_STANDARD_BT601 0
+#define YUV_STANDARD_BT709 1
+
+/**
+ * BgRender的输入纹理
+ * 1. RGBA使用一张GL_RGBA纹理
+ * 2. NV21/NV12使用GL_R8的Y纹理 + 半宽半高GL_RG8的色度纹理，I420使用三张GL_R8纹理，
+ *    上传的数据量只有RGBA的37.5%，YUV转RGB在片元shader中完成
+ * 3. 格式与尺寸不变时只做glTexSubImage2D
+ *
+ * 使用输入纹理的片元shader需包含GetSampleFunction返回的代码，通过sampleSource(coord)取RGBA颜色
+ * */
+class InputTexture {
+
+private:
+    // RGBA或Y、色度（UV/VU或U）、V
+    GLuint mTextureIds[3];
+    int mFormat;
+    int mWidth;
+    int mHeight;
+    // 纹理由外部持有，见Wrap
+    bool mExternal;
+    int mStandard;
+    bool mFullRange;
+    // rgb = mat4 * vec4(y, u, v, 1)，列优先
+    GLfloat mYuvMatrix[16];
+
+    // 最近一次Bind的程序及其uniform位置
+    GLuint mBoundProgramId;
+    GLint mChromaLoc;
+    GLint mChroma2Loc;
+    GLint mYuvMatrixLoc;
+
+    void updateYuvMatrix();
+
+    // 分配或更新一个平面
+    void uploadPlane(int index, GLint internalFormat, GLenum format, int width, int height,
+                     const void *data, bool realloc);
+
+public:
+
+    InputTexture();
+
+    ~InputTexture();
+
+    // 指定格式一帧数据的字节数，格式未知时返回0
+    static int GetDataSize(int format, int width, int height);
+
+    /**
+     * 片元shader中采样输入纹理的代码，声明了所需的sampler与uniform，以及 vec4 sampleSource(vec2 coord)
+     * */
+    static const char *GetSampleFunction(int format);
+
+    /**
+     * 上传一帧，格式或尺寸变化时重新分配纹理内存
+     *
+     * @return 格式未知时返回false
+     * */
+    bool Upload(int format, int width, int height, const void *data);
+
+    /**
+     * 包装一张外部持有的RGBA纹理（如中间结果），用于复用Bind与采样代码，Release时不删除该纹理
+     * 之后再Upload会重新创建自己的纹理
+     * */
+    void Wrap(GLuint textureId, int width, int height);
+
+    /**
+     * YUV转RGB使用的标准与范围
+     *
+     * @param standard YUV_STANDARD_BT601 等
+     * @param fullRange true为0~255全范围（相机、JPEG），false为16~235视频范围
+     * */
+    void SetColorSpace(int standard, bool fullRange);
+
+    int GetFormat();
+
+    int GetWidth();
+
+    int GetHeight();
+
+    int GetStandard();
+
+    bool IsFullRange();
+
+    /**
+     * 将输入纹理绑定到纹理单元0~2并设置程序的uniform，程序需已glUseProgram
+     * 结束时当前纹理单元为GL_TEXTURE0
+     * */
+    void Bind(GLuint programId);
+
+    // 释放纹理，需在上下文所在线程调用
+    void Release();
+
+};
+
+#endif //GLLEARNING_INPUTTEXTURE_H
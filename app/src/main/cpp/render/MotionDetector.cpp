@@ -0,0 +1,368 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "MotionDetector.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "myutils.h"
+
+#define TAG "MotionDetector"
+
+// 上一帧亮度使用的纹理单元，0~2留给InputTexture的各个平面
+#define PREVIOUS_TEXTURE_UNIT 3
+
+// 单位矩形展开为全屏，片元坐标与纹理的行列一一对应
+static const char *MOTION_VERTEX_SHADER =
+        "#version 300 es\n"
+        "layout(location = 0) in vec2 a_corner;\n"
+        "out vec2 v_texCoord;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(a_corner * 2.0 - 1.0, 0.0, 1.0);\n"
+        "    v_texCoord = a_corner;\n"
+        "}\n";
+
+// 中间插入InputTexture::GetSampleFunction
+static const char *DIFF_FRAGMENT_HEAD =
+        "#version 300 es\n"
+        "precision highp float;\n"
+        "in vec2 v_texCoord;\n"
+        "layout(location = 0) out vec4 outLuma;\n"
+        "layout(location = 1) out vec4 outMask;\n"
+        "uniform sampler2D s_Previous;\n"
+        "uniform float u_threshold;\n"
+        "uniform int u_hasPrevious;\n";
+
+// 亮度先量化到0~255，与R8中保存的上一帧按同样的精度比较
+static const char *DIFF_FRAGMENT_MAIN =
+        "void main()\n"
+        "{\n"
+        "    vec4 color = sampleSource(v_texCoord);\n"
+        "    float luma = floor(dot(color.rgb, vec3(0.299, 0.587, 0.114)) * 255.0 + 0.5);\n"
+        "    outLuma = vec4(luma / 255.0, 0.0, 0.0, 1.0);\n"
+        "    float previous = floor(texelFetch(s_Previous, ivec2(gl_FragCoord.xy), 0).r * 255.0 + 0.5);\n"
+        "    bool changed = u_hasPrevious != 0 && abs(luma - previous) > u_threshold;\n"
+        "    outMask = vec4(vec3(changed ? 1.0 : 0.0), 1.0);\n"
+        "}\n";
+
+// 每个片元统计一个分块，边长与MOTION_TILE_SIZE一致
+// 计数最大为16 * 16 = 256，拆成两个字节才能无损写入RGBA8
+static const char *TILE_FRAGMENT_SHADER =
+        "#version 300 es\n"
+        "precision highp float;\n"
+        "precision highp int;\n"
+        "layout(location = 0) out vec4 outCount;\n"
+        "uniform sampler2D s_Mask;\n"
+        "uniform ivec2 u_size;\n"
+        "void main()\n"
+        "{\n"
+        "    ivec2 origin = ivec2(gl_FragCoord.xy) * 16;\n"
+        "    ivec2 end = min(origin + 16, u_size);\n"
+        "    int count = 0;\n"
+        "    for (int y = origin.y; y < end.y; y++) {\n"
+        "        for (int x = origin.x; x < end.x; x++) {\n"
+        "            count += texelFetch(s_Mask, ivec2(x, y), 0).r > 0.5 ? 1 : 0;\n"
+        "        }\n"
+        "    }\n"
+        "    outCount = vec4(float(count & 255), float(count >> 8), 0.0, 0.0) / 255.0;\n"
+        "}\n";
+
+MotionDetector::MotionDetector(GlesEnv *env) {
+    mEnv = env;
+    mDiffProgramId = 0;
+    mDiffProgramFormat = -1;
+    mPreviousLoc = -1;
+    mThresholdLoc = -1;
+    mHasPreviousLoc = -1;
+    mTileProgramId = 0;
+    mMaskLoc = -1;
+    mSizeLoc = -1;
+    mLumaTextureIds[0] = 0;
+    mLumaTextureIds[1] = 0;
+    mCurrent = 0;
+    mHasPrevious = false;
+    mFormat = -1;
+    mMaskTextureId = 0;
+    mFboId = 0;
+    mWidth = 0;
+    mHeight = 0;
+    mTileTextureId = 0;
+    mTileFboId = 0;
+    mTileColumns = 0;
+    mTileRows = 0;
+    mThreshold = MOTION_DEFAULT_THRESHOLD;
+    mTilePixels = MOTION_DEFAULT_TILE_PIXELS;
+    mVboId = 0;
+    mVaoId = 0;
+}
+
+MotionDetector::~MotionDetector() {
+    LOGD(TAG, "MotionDetector un constructor");
+}
+
+void MotionDetector::SetThreshold(int threshold, int tilePixels) {
+    LOGD(TAG, "SetThreshold threshold=%d tilePixels=%d", threshold, tilePixels);
+    mThreshold = threshold < 0 ? 0 : (threshold > 255 ? 255 : threshold);
+    mTilePixels = tilePixels > 0 ? tilePixels : 1;
+}
+
+bool MotionDetector::ensureProgram(int format) {
+    if (mDiffProgramId == 0 || mDiffProgramFormat != format) {
+        std::string shader = std::string(DIFF_FRAGMENT_HEAD)
+                             + InputTexture::GetSampleFunction(format)
+                             + DIFF_FRAGMENT_MAIN;
+        mDiffProgramId = mEnv->GetProgram(MOTION_VERTEX_SHADER, shader.c_str());
+        if (mDiffProgramId == 0) {
+            LOGE(TAG, "ensureProgram diff program fail");
+            return false;
+        }
+        mDiffProgramFormat = format;
+        mPreviousLoc = glGetUniformLocation(mDiffProgramId, "s_Previous");
+        mThresholdLoc = glGetUniformLocation(mDiffProgramId, "u_threshold");
+        mHasPreviousLoc = glGetUniformLocation(mDiffProgramId, "u_hasPrevious");
+    }
+    if (mTileProgramId == 0) {
+        mTileProgramId = mEnv->GetProgram(MOTION_VERTEX_SHADER, TILE_FRAGMENT_SHADER);
+        if (mTileProgramId == 0) {
+            LOGE(TAG, "ensureProgram tile program fail");
+            return false;
+        }
+        mMaskLoc = glGetUniformLocation(mTileProgramId, "s_Mask");
+        mSizeLoc = glGetUniformLocation(mTileProgramId, "u_size");
+    }
+    return true;
+}
+
+static void allocTexture(GLuint textureId, GLint internalFormat, GLenum format, int width,
+                         int height) {
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE,
+                 nullptr);
+}
+
+void MotionDetector::ensureTargets(int width, int height, int format) {
+    if (mFboId != 0 && width == mWidth && height == mHeight && format == mFormat) {
+        return;
+    }
+    LOGD(TAG, "ensureTargets width=%d height=%d format=%d", width, height, format);
+    if (mFboId == 0) {
+        glGenTextures(2, mLumaTextureIds);
+        glGenTextures(1, &mMaskTextureId);
+        glGenFramebuffers(1, &mFboId);
+        glGenTextures(1, &mTileTextureId);
+        glGenFramebuffers(1, &mTileFboId);
+    }
+    mWidth = width;
+    mHeight = height;
+    mFormat = format;
+    // 尺寸或格式变化后上一帧不再可比
+    mHasPrevious = false;
+    allocTexture(mLumaTextureIds[0], GL_R8, GL_RED, width, height);
+    allocTexture(mLumaTextureIds[1], GL_R8, GL_RED, width, height);
+    allocTexture(mMaskTextureId, GL_RGBA, GL_RGBA, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, mMaskTextureId, 0);
+    GLenum buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, buffers);
+
+    mTileColumns = (width + MOTION_TILE_SIZE - 1) / MOTION_TILE_SIZE;
+    mTileRows = (height + MOTION_TILE_SIZE - 1) / MOTION_TILE_SIZE;
+    allocTexture(mTileTextureId, GL_RGBA, GL_RGBA, mTileColumns, mTileRows);
+    glBindFramebuffer(GL_FRAMEBUFFER, mTileFboId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTileTextureId, 0);
+    mTileData.resize((size_t) mTileColumns * mTileRows * 4);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+}
+
+void MotionDetector::drawQuad() {
+    if (mVaoId == 0) {
+        // 三角形带：左下、右下、左上、右上
+        GLfloat corners[] = {
+                0.0f, 0.0f,
+                1.0f, 0.0f,
+                0.0f, 1.0f,
+                1.0f, 1.0f,
+        };
+        glGenBuffers(1, &mVboId);
+        glBindBuffer(GL_ARRAY_BUFFER, mVboId);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glGenVertexArrays(1, &mVaoId);
+        glBindVertexArray(mVaoId);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+        glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+    } else {
+        glBindVertexArray(mVaoId);
+    }
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(GL_NONE);
+}
+
+bool MotionDetector::Detect(InputTexture *input, int *result) {
+    int width = input->GetWidth();
+    int height = input->GetHeight();
+    if (width <= 0 || height <= 0) {
+        LOGE(TAG, "Detect empty input");
+        return false;
+    }
+    if (!ensureProgram(input->GetFormat())) {
+        return false;
+    }
+    ensureTargets(width, height, input->GetFormat());
+
+    // 差分：当前帧亮度写入另一张亮度纹理，原来的一张作为上一帧
+    int previous = mCurrent;
+    mCurrent = 1 - mCurrent;
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           mLumaTextureIds[mCurrent], 0);
+    glViewport(0, 0, width, height);
+    glUseProgram(mDiffProgramId);
+    glUniform1f(mThresholdLoc, (GLfloat) mThreshold);
+    glUniform1i(mHasPreviousLoc, mHasPrevious ? 1 : 0);
+    glActiveTexture(GL_TEXTURE0 + PREVIOUS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, mLumaTextureIds[previous]);
+    glUniform1i(mPreviousLoc, PREVIOUS_TEXTURE_UNIT);
+    input->Bind(mDiffProgramId);
+    drawQuad();
+
+    // 分块归约
+    glBindFramebuffer(GL_FRAMEBUFFER, mTileFboId);
+    glViewport(0, 0, mTileColumns, mTileRows);
+    glUseProgram(mTileProgramId);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mMaskTextureId);
+    glUniform1i(mMaskLoc, 0);
+    glUniform2i(mSizeLoc, width, height);
+    drawQuad();
+    glReadPixels(0, 0, mTileColumns, mTileRows, GL_RGBA, GL_UNSIGNED_BYTE, mTileData.data());
+    glActiveTexture(GL_TEXTURE0 + PREVIOUS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    LOGD(TAG, "Detect error=%d", glGetError());
+
+    memset(result, 0, MOTION_RESULT_SIZE * sizeof(int));
+    result[MOTION_RESULT_VALID] = mHasPrevious ? 1 : 0;
+    result[MOTION_RESULT_PIXELS] = width * height;
+    if (mHasPrevious) {
+        findRegions(result);
+    }
+    mHasPrevious = true;
+    return true;
+}
+
+void MotionDetector::findRegions(int *result) {
+    struct Region {
+        int left, top, right, bottom;
+        int changed;
+    };
+    int tileCount = mTileColumns * mTileRows;
+    // 0：未变化或已合并，1：待合并
+    std::vector<unsigned char> pending(tileCount);
+    std::vector<int> counts(tileCount);
+    int changed = 0;
+    for (int i = 0; i < tileCount; i++) {
+        counts[i] = mTileData[i * 4] | (mTileData[i * 4 + 1] << 8);
+        changed += counts[i];
+        pending[i] = counts[i] >= mTilePixels ? 1 : 0;
+    }
+    result[MOTION_RESULT_CHANGED] = changed;
+
+    std::vector<Region> regions;
+    std::vector<int> stack;
+    for (int i = 0; i < tileCount; i++) {
+        if (!pending[i]) {
+            continue;
+        }
+        // 8邻域泛洪，分块按行优先排列
+        Region region = {mTileColumns, mTileRows, -1, -1, 0};
+        pending[i] = 0;
+        stack.push_back(i);
+        while (!stack.empty()) {
+            int tile = stack.back();
+            stack.pop_back();
+            int column = tile % mTileColumns;
+            int row = tile / mTileColumns;
+            region.left = std::min(region.left, column);
+            region.top = std::min(region.top, row);
+            region.right = std::max(region.right, column);
+            region.bottom = std::max(region.bottom, row);
+            region.changed += counts[tile];
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    int x = column + dx;
+                    int y = row + dy;
+                    if (x < 0 || y < 0 || x >= mTileColumns || y >= mTileRows) {
+                        continue;
+                    }
+                    int neighbor = y * mTileColumns + x;
+                    if (pending[neighbor]) {
+                        pending[neighbor] = 0;
+                        stack.push_back(neighbor);
+                    }
+                }
+            }
+        }
+        regions.push_back(region);
+    }
+    std::stable_sort(regions.begin(), regions.end(), [](const Region &a, const Region &b) {
+        return a.changed > b.changed;
+    });
+    int count = std::min((int) regions.size(), MOTION_MAX_REGIONS);
+    result[MOTION_RESULT_REGION_COUNT] = count;
+    for (int i = 0; i < count; i++) {
+        // 分块坐标换算为像素，最后一列、一行的分块不满时限制在图像内
+        int *rect = result + MOTION_RESULT_REGIONS + i * 4;
+        rect[0] = regions[i].left * MOTION_TILE_SIZE;
+        rect[1] = regions[i].top * MOTION_TILE_SIZE;
+        rect[2] = std::min((regions[i].right + 1) * MOTION_TILE_SIZE, mWidth) - rect[0];
+        rect[3] = std::min((regions[i].bottom + 1) * MOTION_TILE_SIZE, mHeight) - rect[1];
+    }
+}
+
+GLuint MotionDetector::GetMaskTexture() {
+    return mMaskTextureId;
+}
+
+void MotionDetector::Reset() {
+    mHasPrevious = false;
+}
+
+void MotionDetector::Release() {
+    LOGD(TAG, "Release");
+    if (mFboId != 0) {
+        glDeleteFramebuffers(1, &mFboId);
+        glDeleteTextures(2, mLumaTextureIds);
+        glDeleteTextures(1, &mMaskTextureId);
+        glDeleteFramebuffers(1, &mTileFboId);
+        glDeleteTextures(1, &mTileTextureId);
+    }
+    mFboId = 0;
+    mLumaTextureIds[0] = 0;
+    mLumaTextureIds[1] = 0;
+    mMaskTextureId = 0;
+    mTileFboId = 0;
+    mTileTextureId = 0;
+    mWidth = 0;
+    mHeight = 0;
+    mFormat = -1;
+    mHasPrevious = false;
+    mTileData.clear();
+    if (mVaoId != 0) {
+        glDeleteVertexArrays(1, &mVaoId);
+        glDeleteBuffers(1, &mVboId);
+    }
+    mVaoId = 0;
+    mVboId = 0;
+    // 程序由GlesEnv缓存
+    mDiffProgramId = 0;
+    mDiffProgramFormat = -1;
+    mTileProgramId = 0;
+}
@@ -0,0 +1,130 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_MOTIONDETECTOR_H
+#define GLLEARNING_MOTIONDETECTOR_H
+
+#include <GLES3/gl3.h>
+#include <vector>
+#include "GlesEnv.h"
+#include "InputTexture.h"
+
+// 分块边长，变化区域按块统计与合并
+#define MOTION_TILE_SIZE 16
+// 最多返回的变化区域数，超出时保留变化像素最多的
+#define MOTION_MAX_REGIONS 16
+// 默认的亮度差阈值，超过时视为变化，0~255
+#define MOTION_DEFAULT_THRESHOLD 25
+// 默认的分块最少变化像素数，少于时视为噪点，不计入区域
+#define MOTION_DEFAULT_TILE_PIXELS 8
+
+// 检测结果下标
+// 是否与上一帧比较过，第一帧或尺寸、格式变化后为0，其余统计为0
+#define MOTION_RESULT_VALID 0
+// 参与比较的像素数
+#define MOTION_RESULT_PIXELS 1
+// 亮度差超过阈值的像素数，变化比例 = 变化像素数 / 像素数
+#define MOTION_RESULT_CHANGED 2
+// 之后的区域数
+#define MOTION_RESULT_REGION_COUNT 3
+// 之后为MOTION_MAX_REGIONS组x、y、宽、高，单位为像素，原点为图像的第一行第一列，按变化像素数从多到少
+#define MOTION_RESULT_REGIONS 4
+#define MOTION_RESULT_SIZE (MOTION_RESULT_REGIONS + MOTION_MAX_REGIONS * 4)
+
+/**
+ * 连续帧的运动检测，上一帧的亮度常驻在GPU上，每帧只读回分块计数
+ *
+ * 1. 差分：一次绘制通过两个颜色附着同时写入当前帧的亮度（R8，作为下一帧的上一帧）
+ *    与逐像素亮度差的阈值掩码，两张亮度纹理交替使用，不需要拷贝
+ * 2. 分块归约：每个片元统计掩码中MOTION_TILE_SIZE x MOTION_TILE_SIZE个像素的变化数，
+ *    1080p只读回120x68个计数，约32KB
+ * 3. CPU上把超过最少变化像素数的分块按8邻域合并为连通区域，输出外接矩形
+ *
+ * 掩码按需读取，见GetMaskTexture。所有方法需在上下文所在线程调用。
+ * */
+class MotionDetector {
+
+private:
+    GlesEnv *mEnv;
+    // 差分程序，按输入格式生成
+    GLuint mDiffProgramId;
+    int mDiffProgramFormat;
+    GLint mPreviousLoc;
+    GLint mThresholdLoc;
+    GLint mHasPreviousLoc;
+    // 分块计数程序
+    GLuint mTileProgramId;
+    GLint mMaskLoc;
+    GLint mSizeLoc;
+
+    // 交替使用的亮度纹理，mCurrent为最近一帧
+    GLuint mLumaTextureIds[2];
+    int mCurrent;
+    // 是否已有上一帧
+    bool mHasPrevious;
+    int mFormat;
+    // 掩码，RGBA8，变化像素为白色
+    GLuint mMaskTextureId;
+    // 差分FBO，附着0为当前帧亮度，附着1为掩码
+    GLuint mFboId;
+    int mWidth;
+    int mHeight;
+
+    // 分块计数，RGBA8，r、g为计数的低、高字节
+    GLuint mTileTextureId;
+    GLuint mTileFboId;
+    int mTileColumns;
+    int mTileRows;
+    std::vector<GLubyte> mTileData;
+
+    int mThreshold;
+    int mTilePixels;
+
+    // 全屏矩形
+    GLuint mVboId;
+    GLuint mVaoId;
+
+    bool ensureProgram(int format);
+
+    void ensureTargets(int width, int height, int format);
+
+    void drawQuad();
+
+    // 按分块计数合并连通区域，写入result
+    void findRegions(int *result);
+
+public:
+
+    explicit MotionDetector(GlesEnv *env);
+
+    ~MotionDetector();
+
+    /**
+     * 设置阈值
+     *
+     * @param threshold 亮度差超过该值视为变化，0~255
+     * @param tilePixels 分块中变化像素少于该值时不计入区域，<=0时为1
+     * */
+    void SetThreshold(int threshold, int tilePixels);
+
+    /**
+     * 与上一帧比较，之后当前帧成为上一帧
+     *
+     * @param result 长度为MOTION_RESULT_SIZE，见MOTION_RESULT_VALID 等
+     * @return 输入为空或程序创建失败时返回false
+     * */
+    bool Detect(InputTexture *input, int *result);
+
+    // 最近一次Detect的掩码纹理，RGBA8，大小与输入一致，第一帧全黑
+    GLuint GetMaskTexture();
+
+    // 丢弃上一帧，下一次Detect重新开始
+    void Reset();
+
+    // 释放GL资源，需在上下文所在线程调用
+    void Release();
+
+};
+
+#endif //GLLEARNING_MOTIONDETECTOR_H
@@ -0,0 +1,344 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "OverlayCompositor.h"
+#include "myutils.h"
+
+#define TAG "OverlayCompositor"
+
+// 图集中相邻图像之间留空的像素
+#define ATLAS_PADDING 1
+// 每个实例的属性：目标矩形4 + 图集区域4 + 参数2
+#define INSTANCE_FLOATS 10
+
+// 单位矩形按实例的目标矩形展开，u_view为本次绘制区域在输出中的位置与尺寸
+static const char *OVERLAY_VERTEX_SHADER =
+        "#version 300 es\n"
+        "layout(location = 0) in vec2 a_corner;\n"
+        "layout(location = 1) in vec4 a_dstRect;\n"  // 输出像素：x、y、宽、高
+        "layout(location = 2) in vec4 a_srcRect;\n"  // 图集像素：x、y、宽、高
+        "layout(location = 3) in vec2 a_params;\n"   // 不透明度，alpha是否参与混合（叠加发光为0）
+        "uniform vec4 u_view;\n"
+        "uniform vec2 u_atlasSize;\n"
+        "out vec2 v_texCoord;\n"
+        "flat out vec4 v_texClamp;\n"
+        "flat out vec2 v_params;\n"
+        "void main()\n"
+        "{\n"
+        "    vec2 position = a_dstRect.xy + a_corner * a_dstRect.zw - u_view.xy;\n"
+        "    gl_Position = vec4(position / u_view.zw * 2.0 - 1.0, 0.0, 1.0);\n"
+        "    v_texCoord = (a_srcRect.xy + a_corner * a_srcRect.zw) / u_atlasSize;\n"
+        // 采样限制在本图像内缩半个像素，双线性插值不会取到相邻图像
+        "    v_texClamp = vec4(a_srcRect.xy + 0.5, a_srcRect.xy + a_srcRect.zw - 0.5) / u_atlasSize.xyxy;\n"
+        "    v_params = a_params;\n"
+        "}\n";
+
+static const char *OVERLAY_FRAGMENT_SHADER =
+        "#version 300 es\n"
+        "precision highp float;\n"
+        "in vec2 v_texCoord;\n"
+        "flat in vec4 v_texClamp;\n"
+        "flat in vec2 v_params;\n"
+        "layout(location = 0) out vec4 outColor;\n"
+        "uniform sampler2D s_Atlas;\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 color = texture(s_Atlas, clamp(v_texCoord, v_texClamp.xy, v_texClamp.zw)) * v_params.x;\n"
+        "    outColor = vec4(color.rgb, color.a * v_params.y);\n"
+        "}\n";
+
+// 混合函数相同的图层可以合并为一次绘制
+static int blendGroup(int blend) {
+    switch (blend) {
+        case OVERLAY_BLEND_MULTIPLY:
+            return 1;
+        case OVERLAY_BLEND_SCREEN:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+// 目标alpha保持不变，叠加层不改变输出的透明度
+static void applyBlendGroup(int group) {
+    switch (group) {
+        case 1:
+            glBlendFuncSeparate(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+            break;
+        case 2:
+            glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ONE);
+            break;
+        default:
+            glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+            break;
+    }
+}
+
+OverlayCompositor::OverlayCompositor(GlesEnv *env) {
+    mEnv = env;
+    mProgramId = 0;
+    mViewLoc = -1;
+    mAtlasSizeLoc = -1;
+    mAtlasId = 0;
+    mAtlasSize = 0;
+    mShelfX = 0;
+    mShelfY = 0;
+    mShelfHeight = 0;
+    mLayersDirty = false;
+    mVboIds[0] = mVboIds[1] = 0;
+    mVaoId = 0;
+}
+
+OverlayCompositor::~OverlayCompositor() {
+    LOGD(TAG, "OverlayCompositor un constructor");
+}
+
+bool OverlayCompositor::ensureProgram() {
+    if (mProgramId != 0) {
+        return true;
+    }
+    mProgramId = mEnv->GetProgram(OVERLAY_VERTEX_SHADER, OVERLAY_FRAGMENT_SHADER);
+    if (mProgramId == 0) {
+        LOGE(TAG, "ensureProgram fail");
+        return false;
+    }
+    mViewLoc = glGetUniformLocation(mProgramId, "u_view");
+    mAtlasSizeLoc = glGetUniformLocation(mProgramId, "u_atlasSize");
+
+    // 三角形带：左下、右下、左上、右上
+    GLfloat corners[] = {
+            0.0f, 0.0f,
+            1.0f, 0.0f,
+            0.0f, 1.0f,
+            1.0f, 1.0f,
+    };
+    glGenBuffers(2, mVboIds);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glGenVertexArrays(1, &mVaoId);
+    glBindVertexArray(mVaoId);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+    // 实例属性每个实例前进一次
+    for (GLuint location = 1; location <= 3; location++) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindVertexArray(GL_NONE);
+    glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+    return true;
+}
+
+bool OverlayCompositor::ensureAtlas() {
+    if (mAtlasId != 0) {
+        return true;
+    }
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    mAtlasSize = maxTextureSize < OVERLAY_ATLAS_SIZE ? maxTextureSize : OVERLAY_ATLAS_SIZE;
+    if (mAtlasSize <= 0) {
+        return false;
+    }
+    glGenTextures(1, &mAtlasId);
+    glBindTexture(GL_TEXTURE_2D, mAtlasId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mAtlasSize, mAtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 nullptr);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    LOGD(TAG, "ensureAtlas size=%d error=%d", mAtlasSize, glGetError());
+    return true;
+}
+
+bool OverlayCompositor::allocate(int width, int height, int *x, int *y) {
+    if (width > mAtlasSize || height > mAtlasSize) {
+        return false;
+    }
+    if (mShelfX + width > mAtlasSize) {
+        // 当前行放不下，换到下一行
+        mShelfY += mShelfHeight + ATLAS_PADDING;
+        mShelfX = 0;
+        mShelfHeight = 0;
+    }
+    if (mShelfY + height > mAtlasSize) {
+        return false;
+    }
+    *x = mShelfX;
+    *y = mShelfY;
+    mShelfX += width + ATLAS_PADDING;
+    mShelfHeight = height > mShelfHeight ? height : mShelfHeight;
+    return true;
+}
+
+int OverlayCompositor::AddImage(int width, int height, const char *imageData, bool premultiplied) {
+    LOGD(TAG, "AddImage width=%d height=%d premultiplied=%d", width, height, premultiplied);
+    if (width <= 0 || height <= 0 || imageData == nullptr || !ensureAtlas()) {
+        return -1;
+    }
+    AtlasImage image;
+    if (!allocate(width, height, &image.x, &image.y)) {
+        LOGE(TAG, "AddImage atlas full, image %dx%d", width, height);
+        return -1;
+    }
+    image.width = width;
+    image.height = height;
+
+    const GLubyte *pixels = (const GLubyte *) imageData;
+    GLubyte *converted = nullptr;
+    if (!premultiplied) {
+        // 在装入图集前预乘，双线性插值与缩放后边缘不会出现暗边或亮边
+        size_t size = (size_t) width * height * 4;
+        converted = new GLubyte[size];
+        for (size_t i = 0; i < size; i += 4) {
+            unsigned int alpha = pixels[i + 3];
+            converted[i] = (GLubyte) ((pixels[i] * alpha + 127) / 255);
+            converted[i + 1] = (GLubyte) ((pixels[i + 1] * alpha + 127) / 255);
+            converted[i + 2] = (GLubyte) ((pixels[i + 2] * alpha + 127) / 255);
+            converted[i + 3] = (GLubyte) alpha;
+        }
+        pixels = converted;
+    }
+    glBindTexture(GL_TEXTURE_2D, mAtlasId);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, image.x, image.y, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                    pixels);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    delete[] converted;
+    mImages.push_back(image);
+    return (int) mImages.size() - 1;
+}
+
+bool OverlayCompositor::AddLayer(int image, float x, float y, float scale, float opacity,
+                                 int blend) {
+    if (image < 0 || image >= (int) mImages.size()) {
+        LOGE(TAG, "AddLayer unknown image=%d", image);
+        return false;
+    }
+    if (blend < OVERLAY_BLEND_NORMAL || blend > OVERLAY_BLEND_SCREEN) {
+        LOGE(TAG, "AddLayer unknown blend=%d", blend);
+        return false;
+    }
+    Layer layer;
+    layer.image = image;
+    layer.x = x;
+    layer.y = y;
+    layer.scale = scale;
+    layer.opacity = opacity < 0.0f ? 0.0f : (opacity > 1.0f ? 1.0f : opacity);
+    layer.blend = blend;
+    mLayers.push_back(layer);
+    mLayersDirty = true;
+    return true;
+}
+
+void OverlayCompositor::Clear(bool clearImages) {
+    mLayers.clear();
+    mLayersDirty = true;
+    if (clearImages) {
+        // 图集纹理保留，后续图像覆盖写入
+        mImages.clear();
+        mShelfX = 0;
+        mShelfY = 0;
+        mShelfHeight = 0;
+    }
+}
+
+bool OverlayCompositor::IsEmpty() {
+    return mLayers.empty();
+}
+
+void OverlayCompositor::uploadInstances() {
+    std::vector<GLfloat> instances(mLayers.size() * INSTANCE_FLOATS);
+    GLfloat *instance = instances.data();
+    for (const Layer &layer : mLayers) {
+        const AtlasImage &image = mImages[layer.image];
+        instance[0] = layer.x;
+        instance[1] = layer.y;
+        instance[2] = image.width * layer.scale;
+        instance[3] = image.height * layer.scale;
+        instance[4] = (GLfloat) image.x;
+        instance[5] = (GLfloat) image.y;
+        instance[6] = (GLfloat) image.width;
+        instance[7] = (GLfloat) image.height;
+        instance[8] = layer.opacity;
+        instance[9] = layer.blend == OVERLAY_BLEND_ADD ? 0.0f : 1.0f;
+        instance += INSTANCE_FLOATS;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[1]);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(GLfloat), instances.data(),
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+    mLayersDirty = false;
+}
+
+void OverlayCompositor::bindInstances(int first) {
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[1]);
+    GLsizei stride = INSTANCE_FLOATS * sizeof(GLfloat);
+    size_t offset = (size_t) first * stride;
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (const void *) offset);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride,
+                          (const void *) (offset + 4 * sizeof(GLfloat)));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride,
+                          (const void *) (offset + 8 * sizeof(GLfloat)));
+    glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+}
+
+void OverlayCompositor::Draw(GLuint fbo, int x, int y, int width, int height) {
+    if (mLayers.empty() || !ensureProgram()) {
+        return;
+    }
+    glBindVertexArray(mVaoId);
+    if (mLayersDirty) {
+        uploadInstances();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+    glUseProgram(mProgramId);
+    glUniform4f(mViewLoc, (GLfloat) x, (GLfloat) y, (GLfloat) width, (GLfloat) height);
+    glUniform2f(mAtlasSizeLoc, (GLfloat) mAtlasSize, (GLfloat) mAtlasSize);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mAtlasId);
+    glEnable(GL_BLEND);
+    // 按顺序把混合函数相同的连续图层合并为一次实例化绘制，保证图层之间的先后关系
+    int drawCount = 0;
+    int count = (int) mLayers.size();
+    for (int first = 0; first < count;) {
+        int group = blendGroup(mLayers[first].blend);
+        int last = first + 1;
+        while (last < count && blendGroup(mLayers[last].blend) == group) {
+            last++;
+        }
+        applyBlendGroup(group);
+        bindInstances(first);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, last - first);
+        drawCount++;
+        first = last;
+    }
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    glBindVertexArray(GL_NONE);
+    LOGD(TAG, "Draw layers=%d draws=%d error=%d", count, drawCount, glGetError());
+}
+
+void OverlayCompositor::Release() {
+    LOGD(TAG, "Release");
+    if (mAtlasId != 0) {
+        glDeleteTextures(1, &mAtlasId);
+    }
+    mAtlasId = 0;
+    mAtlasSize = 0;
+    mImages.clear();
+    mShelfX = 0;
+    mShelfY = 0;
+    mShelfHeight = 0;
+    mLayers.clear();
+    mLayersDirty = false;
+    if (mVaoId != 0) {
+        glDeleteVertexArrays(1, &mVaoId);
+        glDeleteBuffers(2, mVboIds);
+    }
+    mVaoId = 0;
+    // 程序由GlesEnv缓存
+    mProgramId = 0;
+}
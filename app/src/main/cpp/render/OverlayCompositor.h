@@ -0,0 +1,137 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_OVERLAYCOMPOSITOR_H
+#define GLLEARNING_OVERLAYCOMPOSITOR_H
+
+#include <GLES3/gl3.h>
+#include <vector>
+#include "GlesEnv.h"
+
+// 叠加层的混合方式，颜色均为预乘alpha
+// 正常覆盖：src + dst * (1 - srcAlpha)
+#define OVERLAY_BLEND_NORMAL 0
+// 叠加发光：src + dst，与正常覆盖共用混合函数，可以在同一次绘制中混排
+#define OVERLAY_BLEND_ADD 1
+// 正片叠底：src * dst + dst * (1 - srcAlpha)
+#define OVERLAY_BLEND_MULTIPLY 2
+// 滤色：src + dst * (1 - src)
+#define OVERLAY_BLEND_SCREEN 3
+
+// 图集边长，超过GL_MAX_TEXTURE_SIZE时按上限
+#define OVERLAY_ATLAS_SIZE 2048
+
+/**
+ * 多图层叠加（水印、贴纸），在渲染结果上按顺序混合，不经过变换与滤镜
+ *
+ * 叠加图像在AddImage时预乘alpha并按行（shelf）装入一张图集纹理，之后每帧不再上传；
+ * 每个图层只是一组实例属性（目标矩形、图集区域、不透明度），所有图层放在一个实例缓冲区里，
+ * 混合函数相同的连续图层用一次glDrawArraysInstanced绘制。
+ * 只用正常覆盖与叠加发光时整个叠加只有一次绘制，盖一个水印与盖几百个贴纸的开销基本相同。
+ *
+ * 坐标单位为输出像素，原点为输出数据的第一行第一列，与读取结果的内存顺序一致。
+ * 所有方法需在上下文所在线程调用。
+ * */
+class OverlayCompositor {
+
+private:
+    // 图集中的一张图像，单位为图集像素
+    struct AtlasImage {
+        int x;
+        int y;
+        int width;
+        int height;
+    };
+
+    struct Layer {
+        int image;
+        float x;
+        float y;
+        float scale;
+        float opacity;
+        int blend;
+    };
+
+    GlesEnv *mEnv;
+    GLuint mProgramId;
+    GLint mViewLoc;
+    GLint mAtlasSizeLoc;
+
+    // 图集纹理与装箱状态
+    GLuint mAtlasId;
+    int mAtlasSize;
+    // 当前行的起点与行高
+    int mShelfX;
+    int mShelfY;
+    int mShelfHeight;
+    std::vector<AtlasImage> mImages;
+
+    std::vector<Layer> mLayers;
+    // 图层变化后需要重新上传实例缓冲区
+    bool mLayersDirty;
+
+    // 单位矩形顶点与实例属性
+    GLuint mVboIds[2];
+    GLuint mVaoId;
+
+    bool ensureProgram();
+
+    bool ensureAtlas();
+
+    // 在图集中分配一块区域，放不下时返回false
+    bool allocate(int width, int height, int *x, int *y);
+
+    void uploadInstances();
+
+    // 从first开始的图层设置实例属性指针，GLES 3.0没有baseInstance
+    void bindInstances(int first);
+
+public:
+
+    explicit OverlayCompositor(GlesEnv *env);
+
+    ~OverlayCompositor();
+
+    /**
+     * 上传一张叠加图像到图集，同一图像可以被多个图层引用
+     *
+     * @param imageData RGBA，大小为width * height * 4，上传后不再使用
+     * @param premultiplied 数据是否已预乘alpha（Android Bitmap为预乘），否则在上传时预乘
+     * @return 图像id，图集放不下或没有GL环境时返回-1
+     * */
+    int AddImage(int width, int height, const char *imageData, bool premultiplied);
+
+    /**
+     * 追加一个图层，图层按追加顺序从下往上叠加
+     *
+     * @param image AddImage返回的图像id
+     * @param x 左上角位置，单位为输出像素
+     * @param scale 相对图像原始尺寸的缩放
+     * @param opacity 不透明度[0, 1]
+     * @param blend OVERLAY_BLEND_NORMAL 等
+     * @return 图像id或混合方式无效时返回false
+     * */
+    bool AddLayer(int image, float x, float y, float scale, float opacity, int blend);
+
+    /**
+     * 清空图层
+     *
+     * @param clearImages 同时清空图集，之前的图像id失效
+     * */
+    void Clear(bool clearImages);
+
+    bool IsEmpty();
+
+    /**
+     * 将所有图层混合到fbo上，fbo对应输出中从(x, y)开始的width x height区域，
+     * 分块渲染时只画落在该块内的部分。结束时fbo保持绑定
+     * */
+    void Draw(GLuint fbo, int x, int y, int width, int height);
+
+    // 释放GL资源，需在上下文所在线程调用
+    void Release();
+
+};
+
+#endif //GLLEARNING_OVERLAYCOMPOSITOR_H
@@ -0,0 +1,149 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "PboReader.h"
+#include "myutils.h"
+#include <cstring>
+
+#define TAG "PboReader"
+
+// 单次等待fence的超时时间，纳秒
+#define FENCE_WAIT_TIMEOUT 100000000
+
+PboReader::PboReader(int count) {
+    mCount = count < 2 ? 2 : count;
+    LOGD(TAG, "PboReader constructor count=%d", mCount);
+    mPboIds = new GLuint[mCount];
+    mFences = new GLsync[mCount];
+    mSizes = new GLsizeiptr[mCount];
+    mCapacities = new GLsizeiptr[mCount];
+    glGenBuffers(mCount, mPboIds);
+    for (int i = 0; i < mCount; i++) {
+        mFences[i] = nullptr;
+        mSizes[i] = 0;
+        mCapacities[i] = 0;
+    }
+    mWriteIndex = 0;
+    mReadIndex = 0;
+    mPendingCount = 0;
+    mDroppedCount = 0;
+}
+
+PboReader::~PboReader() {
+    LOGD(TAG, "PboReader un constructor");
+    delete[] mPboIds;
+    delete[] mFences;
+    delete[] mSizes;
+    delete[] mCapacities;
+}
+
+void PboReader::Read(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                     GLsizeiptr size, GLsizeiptr validSize) {
+    int index = mWriteIndex;
+    if (mFences[index] != nullptr) {
+        // 队列已满，最早一帧没有被取走，直接覆盖
+        glDeleteSync(mFences[index]);
+        mFences[index] = nullptr;
+        mReadIndex = (mReadIndex + 1) % mCount;
+        mPendingCount--;
+        mDroppedCount++;
+        LOGW(TAG, "Read ring full, drop frame, droppedCount=%d", mDroppedCount);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mPboIds[index]);
+    if (mCapacities[index] < size) {
+        // GL_STREAM_READ：GPU写入，CPU读取一次
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        mCapacities[index] = size;
+    }
+    // 绑定了PACK缓冲区时，最后一个参数是缓冲区内的偏移，调用不会等待GPU
+    glReadPixels(x, y, width, height, format, type, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+
+    mFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mSizes[index] = validSize > 0 && validSize < size ? validSize : size;
+    // 提交命令，让GPU尽快开始执行
+    glFlush();
+
+    mWriteIndex = (index + 1) % mCount;
+    mPendingCount++;
+}
+
+bool PboReader::waitFence(int index) {
+    while (true) {
+        GLenum ret = glClientWaitSync(mFences[index], GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      FENCE_WAIT_TIMEOUT);
+        if (ret == GL_ALREADY_SIGNALED || ret == GL_CONDITION_SATISFIED) {
+            return true;
+        }
+        if (ret == GL_WAIT_FAILED) {
+            LOGE(TAG, "glClientWaitSync fail error=%d", glGetError());
+            return false;
+        }
+        LOGW(TAG, "glClientWaitSync timeout, keep waiting");
+    }
+}
+
+bool PboReader::Fetch(void *addr, GLsizeiptr capacity) {
+    if (mPendingCount == 0) {
+        LOGW(TAG, "Fetch no pending frame");
+        return false;
+    }
+    int index = mReadIndex;
+    bool success = waitFence(index);
+    glDeleteSync(mFences[index]);
+    mFences[index] = nullptr;
+    mReadIndex = (index + 1) % mCount;
+    mPendingCount--;
+    if (!success) {
+        return false;
+    }
+    if (mSizes[index] > capacity) {
+        // 读取后输出尺寸或格式变了，调用方按新的大小分配
+        LOGE(TAG, "Fetch frame size=%ld over capacity=%ld", (long) mSizes[index], (long) capacity);
+        return false;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, mPboIds[index]);
+    void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, mSizes[index], GL_MAP_READ_BIT);
+    if (mapped == nullptr) {
+        LOGE(TAG, "glMapBufferRange fail error=%d", glGetError());
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+        return false;
+    }
+    memcpy(addr, mapped, mSizes[index]);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+    return true;
+}
+
+bool PboReader::IsReady() {
+    if (mPendingCount == 0) {
+        return false;
+    }
+    GLenum ret = glClientWaitSync(mFences[mReadIndex], 0, 0);
+    return ret == GL_ALREADY_SIGNALED || ret == GL_CONDITION_SATISFIED;
+}
+
+int PboReader::GetPendingCount() {
+    return mPendingCount;
+}
+
+int PboReader::GetDroppedCount() {
+    return mDroppedCount;
+}
+
+void PboReader::Release() {
+    LOGD(TAG, "Release");
+    for (int i = 0; i < mCount; i++) {
+        if (mFences[i] != nullptr) {
+            glDeleteSync(mFences[i]);
+            mFences[i] = nullptr;
+        }
+        mSizes[i] = 0;
+        mCapacities[i] = 0;
+    }
+    glDeleteBuffers(mCount, mPboIds);
+    mPendingCount = 0;
+}
@@ -0,0 +1,83 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_PBOREADER_H
+#define GLLEARNING_PBOREADER_H
+
+#include <GLES3/gl3.h>
+
+/**
+ * 基于PBO（Pixel Buffer Object）的异步读取
+ * glReadPixels绑定GL_PIXEL_PACK_BUFFER后立即返回，像素由GPU异步传输到PBO，
+ * 每个PBO配一个glFenceSync，等到真正需要数据时才等待fence并映射读取。
+ * 多个PBO组成环形队列，第N帧传输的同时可以提交第N+1帧。
+ *
+ * 所有方法都需要在GL上下文所在线程调用
+ * */
+class PboReader {
+
+private:
+    // PBO数量
+    int mCount;
+    // PBO ids
+    GLuint *mPboIds;
+    // 每个PBO对应的fence，为nullptr表示空闲
+    GLsync *mFences;
+    // 每个PBO当前待读取的字节数
+    GLsizeiptr *mSizes;
+    // 每个PBO已分配的字节数
+    GLsizeiptr *mCapacities;
+    // 下一次写入的位置
+    int mWriteIndex;
+    // 最早一帧未读取数据的位置
+    int mReadIndex;
+    // 未读取的帧数
+    int mPendingCount;
+    // 因未及时读取而被覆盖的帧数
+    int mDroppedCount;
+
+    // 等待fence完成，成功返回true
+    bool waitFence(int index);
+
+public:
+
+    // @param count PBO数量，至少为2
+    explicit PboReader(int count);
+
+    ~PboReader();
+
+    /**
+     * 异步读取当前绑定FBO的像素，立即返回
+     * 环形队列已满时覆盖最早一帧
+     *
+     * @param size 读取区域的字节数
+     * @param validSize Fetch时拷贝的字节数，区域末尾有填充时小于size，<=0表示与size相同
+     * */
+    void Read(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+              GLsizeiptr size, GLsizeiptr validSize = 0);
+
+    /**
+     * 取出最早一帧数据，必要时等待GPU传输完成
+     *
+     * @param addr 目标地址
+     * @param capacity addr可写入的字节数，小于该帧时丢弃该帧
+     * @return 没有待读取的帧、capacity不足或读取失败返回false
+     * */
+    bool Fetch(void *addr, GLsizeiptr capacity);
+
+    // 最早一帧数据是否已传输完成，不阻塞
+    bool IsReady();
+
+    // 未读取的帧数
+    int GetPendingCount();
+
+    // 被覆盖丢弃的帧数
+    int GetDroppedCount();
+
+    // 释放PBO与fence
+    void Release();
+
+};
+
+#endif //GLLEARNING_PBOREADER_H
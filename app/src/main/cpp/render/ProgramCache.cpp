@@ -0,0 +1,176 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "ProgramCache.h"
+#include "myutils.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define TAG "ProgramCache"
+
+// 文件头魔数与格式版本
+#define CACHE_MAGIC 0x42504c47
+#define CACHE_VERSION 1
+
+// 文件头，之后依次是驱动信息字符串与程序二进制
+struct CacheHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int binaryFormat;
+    unsigned int binaryLength;
+    unsigned int driverInfoLength;
+};
+
+// FNV-1a 64位哈希
+static unsigned long long fnv1a(const std::string &data, unsigned long long hash) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+ProgramCache::ProgramCache() {
+    mSupported = false;
+    memset(mStats, 0, sizeof(mStats));
+}
+
+void ProgramCache::Init() {
+    const char *renderer = (const char *) glGetString(GL_RENDERER);
+    const char *version = (const char *) glGetString(GL_VERSION);
+    mDriverInfo = std::string(renderer == nullptr ? "" : renderer) + "|" +
+                  (version == nullptr ? "" : version);
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    mSupported = formatCount > 0;
+    LOGD(TAG, "Init driverInfo=%s formatCount=%d", mDriverInfo.c_str(), formatCount);
+}
+
+void ProgramCache::SetDirectory(const char *directory) {
+    mDirectory = directory == nullptr ? "" : directory;
+    LOGD(TAG, "SetDirectory %s", mDirectory.c_str());
+}
+
+bool ProgramCache::IsEnabled() {
+    return mSupported && !mDirectory.empty();
+}
+
+std::string ProgramCache::getFilePath(const std::string &source) {
+    unsigned long long hash = fnv1a(source, 14695981039346656037ULL);
+    hash = fnv1a(mDriverInfo, hash);
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", hash);
+    return mDirectory + name;
+}
+
+GLuint ProgramCache::Load(const std::string &source) {
+    if (!IsEnabled()) {
+        return 0;
+    }
+    std::string path = getFilePath(source);
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        mStats[PROGRAM_CACHE_MISS]++;
+        return 0;
+    }
+
+    GLuint programId = 0;
+    CacheHeader header;
+    std::vector<char> driverInfo;
+    std::vector<char> binary;
+    // 长度来自文件，先与文件大小核对，损坏或截断的文件不能触发超大分配
+    long fileSize = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        fileSize = ftell(file);
+    }
+    bool valid = fileSize >= (long) sizeof(header) && fseek(file, 0, SEEK_SET) == 0
+                 && fread(&header, sizeof(header), 1, file) == 1
+                 && header.magic == CACHE_MAGIC && header.version == CACHE_VERSION
+                 && header.driverInfoLength == mDriverInfo.size()
+                 && (unsigned long long) sizeof(header) + header.driverInfoLength
+                    + header.binaryLength == (unsigned long long) fileSize;
+    if (valid) {
+        driverInfo.resize(header.driverInfoLength);
+        binary.resize(header.binaryLength);
+        valid = fread(driverInfo.data(), 1, driverInfo.size(), file) == driverInfo.size()
+                && memcmp(driverInfo.data(), mDriverInfo.data(), driverInfo.size()) == 0
+                && fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+
+    if (valid) {
+        programId = glCreateProgram();
+        glProgramBinary(programId, header.binaryFormat, binary.data(), (GLsizei) binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE) {
+            // 驱动拒绝了这份二进制，通常是驱动更新导致
+            glDeleteProgram(programId);
+            programId = 0;
+            valid = false;
+        }
+    }
+    if (!valid) {
+        LOGW(TAG, "Load stale cache %s", path.c_str());
+        remove(path.c_str());
+        mStats[PROGRAM_CACHE_STALE]++;
+        mStats[PROGRAM_CACHE_MISS]++;
+        return 0;
+    }
+    mStats[PROGRAM_CACHE_HIT]++;
+    LOGD(TAG, "Load hit %s programId=%d", path.c_str(), programId);
+    return programId;
+}
+
+void ProgramCache::PrepareLink(GLuint programId) {
+    if (IsEnabled()) {
+        glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void ProgramCache::Save(const std::string &source, GLuint programId) {
+    if (!IsEnabled()) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        LOGW(TAG, "Save binary length=%d", length);
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(programId, length, &length, &binaryFormat, binary.data());
+
+    CacheHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.binaryFormat = binaryFormat;
+    header.binaryLength = (unsigned int) length;
+    header.driverInfoLength = (unsigned int) mDriverInfo.size();
+
+    // 先写临时文件再重命名，避免进程中途退出留下不完整的缓存
+    std::string path = getFilePath(source);
+    std::string tempPath = path + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        LOGW(TAG, "Save open fail %s", tempPath.c_str());
+        return;
+    }
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1
+                   && fwrite(mDriverInfo.data(), 1, mDriverInfo.size(), file) == mDriverInfo.size()
+                   && fwrite(binary.data(), 1, length, file) == (size_t) length;
+    success = fclose(file) == 0 && success;
+    if (!success || rename(tempPath.c_str(), path.c_str()) != 0) {
+        LOGW(TAG, "Save write fail %s", path.c_str());
+        remove(tempPath.c_str());
+        return;
+    }
+    LOGD(TAG, "Save %s length=%d", path.c_str(), length);
+}
+
+void ProgramCache::GetStats(int *stats) {
+    memcpy(stats, mStats, sizeof(mStats));
+}
@@ -0,0 +1,72 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_PROGRAMCACHE_H
+#define GLLEARNING_PROGRAMCACHE_H
+
+#include <GLES3/gl3.h>
+#include <string>
+
+// 统计项下标，见GetStats
+#define PROGRAM_CACHE_HIT 0
+#define PROGRAM_CACHE_MISS 1
+#define PROGRAM_CACHE_STALE 2
+#define PROGRAM_CACHE_STATS_COUNT 3
+
+/**
+ * 基于glGetProgramBinary/glProgramBinary的程序二进制磁盘缓存
+ * 1. 文件名由shader源码与GL_RENDERER、GL_VERSION一起哈希得到，驱动升级后自然失效
+ * 2. 文件头里同样保存驱动信息，与当前不一致或glProgramBinary链接失败都视为过期
+ * 3. 过期或未命中时由调用方从源码编译，再调用Save写回
+ *
+ * 需在GL上下文所在线程调用
+ * */
+class ProgramCache {
+
+private:
+    // 缓存目录，为空时不启用
+    std::string mDirectory;
+    // GL_RENDERER + GL_VERSION
+    std::string mDriverInfo;
+    // 驱动是否支持程序二进制
+    bool mSupported;
+    int mStats[PROGRAM_CACHE_STATS_COUNT];
+
+    // 源码对应的缓存文件路径
+    std::string getFilePath(const std::string &source);
+
+public:
+
+    ProgramCache();
+
+    // 读取驱动信息，需在上下文创建后调用
+    void Init();
+
+    // 设置缓存目录，传空字符串关闭磁盘缓存
+    void SetDirectory(const char *directory);
+
+    bool IsEnabled();
+
+    /**
+     * 从磁盘加载程序
+     *
+     * @param source 顶点与片元shader源码拼接的key
+     * @return 未命中或已过期返回0
+     * */
+    GLuint Load(const std::string &source);
+
+    /**
+     * 链接前调用，提示驱动保留程序二进制
+     * */
+    void PrepareLink(GLuint programId);
+
+    // 将已链接的程序写入磁盘
+    void Save(const std::string &source, GLuint programId);
+
+    // 命中、未命中、过期次数，下标见PROGRAM_CACHE_HIT等
+    void GetStats(int *stats);
+
+};
+
+#endif //GLLEARNING_PROGRAMCACHE_H
@@ -0,0 +1,161 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "RenderPool.h"
+#include <pthread.h>
+#include "BgRender.h"
+#include "myutils.h"
+
+#define TAG "RenderPool"
+
+RenderPool::RenderPool(int workerCount) {
+    mWorkerCount = workerCount <= 0 ? 1 : workerCount;
+    mWorkers = new Worker[mWorkerCount];
+    for (int i = 0; i < mWorkerCount; i++) {
+        mWorkers[i].env = nullptr;
+        mWorkers[i].render = nullptr;
+    }
+    mReadyCount = 0;
+    mSharedEnv = nullptr;
+    mStopped = false;
+    mStartedCount = 0;
+}
+
+RenderPool::~RenderPool() {
+    LOGD(TAG, "RenderPool un constructor");
+    Stop();
+    delete[] mWorkers;
+}
+
+int RenderPool::Start() {
+    if (mSharedEnv != nullptr) {
+        return mReadyCount;
+    }
+    // 工作上下文与其共享，池存在期间持有引用
+    mSharedEnv = GlesEnv::Acquire();
+    if (mSharedEnv == nullptr) {
+        LOGE(TAG, "Start acquire shared env fail");
+        return 0;
+    }
+    for (int i = 0; i < mWorkerCount; i++) {
+        mWorkers[i].thread = std::thread(&RenderPool::loop, this, &mWorkers[i]);
+    }
+    std::unique_lock<std::mutex> lock(mLock);
+    mReadyCondition.wait(lock, [this]() { return mStartedCount == mWorkerCount; });
+    LOGI(TAG, "Start workers=%d ready=%d", mWorkerCount, mReadyCount);
+    return mReadyCount;
+}
+
+void RenderPool::loop(Worker *worker) {
+    pthread_setname_np(pthread_self(), "GLRenderPool");
+    worker->env = GlesEnv::CreateShared();
+    {
+        std::lock_guard<std::mutex> lockGuard(mLock);
+        mStartedCount++;
+        if (worker->env != nullptr) {
+            mReadyCount++;
+        }
+    }
+    mReadyCondition.notify_all();
+    if (worker->env == nullptr) {
+        LOGE(TAG, "loop CreateShared fail");
+        return;
+    }
+
+    while (true) {
+        Job *job;
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            mJobCondition.wait(lock, [this]() { return mStopped || !mJobs.empty(); });
+            if (mJobs.empty()) {
+                // mStopped且队列已清空
+                break;
+            }
+            job = mJobs.front();
+            mJobs.pop_front();
+        }
+        bool success = job->run(worker);
+        job->future->Complete(success);
+        job->future->Release();
+        delete job;
+    }
+
+    if (worker->render != nullptr) {
+        worker->render->DestroyGlesEnv();
+        delete worker->render;
+        worker->render = nullptr;
+    }
+    GlesEnv::DestroyShared(worker->env);
+    worker->env = nullptr;
+}
+
+RenderFuture *RenderPool::enqueue(const std::function<bool(Worker *worker)> &run) {
+    Job *job = new Job();
+    job->run = run;
+    job->future = new RenderFuture();
+    {
+        std::lock_guard<std::mutex> lockGuard(mLock);
+        if (mStopped || mReadyCount == 0) {
+            // 没有工作线程会执行，直接失败
+            job->future->Complete(false);
+            job->future->Release();
+            RenderFuture *future = job->future;
+            delete job;
+            return future;
+        }
+        mJobs.push_back(job);
+    }
+    mJobCondition.notify_one();
+    return job->future;
+}
+
+RenderFuture *RenderPool::Submit(const std::function<bool(GlesEnv *env)> &run) {
+    return enqueue([run](Worker *worker) {
+        return run(worker->env);
+    });
+}
+
+RenderFuture *RenderPool::SubmitImage(int width, int height, const char *image, int rotate,
+                                      signed char *output) {
+    return enqueue([=](Worker *worker) {
+        if (worker->render == nullptr) {
+            worker->render = new BgRender(width, height, image);
+            if (!worker->render->CreateGlesEnv(worker->env)) {
+                return false;
+            }
+            // 池用于吞吐，固定走GPU，不保留CPU引擎的原图拷贝
+            worker->render->SetEngine(ENGINE_GPU);
+        } else if (!worker->render->UpdateFrame(width, height, image)) {
+            return false;
+        }
+        worker->render->SetRotate(rotate);
+        if (output == nullptr) {
+            worker->render->Draw();
+        } else {
+            worker->render->DrawTo(output);
+        }
+        return true;
+    });
+}
+
+void RenderPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lockGuard(mLock);
+        if (mStopped) {
+            return;
+        }
+        mStopped = true;
+    }
+    mJobCondition.notify_all();
+    for (int i = 0; i < mWorkerCount; i++) {
+        if (mWorkers[i].thread.joinable()) {
+            mWorkers[i].thread.join();
+        }
+    }
+    if (mSharedEnv != nullptr) {
+        GlesEnv::Release();
+        mSharedEnv = nullptr;
+    }
+    LOGI(TAG, "Stop");
+}
@@ -0,0 +1,98 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_RENDERPOOL_H
+#define GLLEARNING_RENDERPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "GlesEnv.h"
+#include "RenderThread.h"
+
+class BgRender;
+
+/**
+ * 多上下文并行渲染池
+ * 1. 每个工作线程持有一个与共享环境同一share group的上下文，见GlesEnv::CreateShared，
+ *    每个上下文链接自己的程序，uniform互不影响
+ * 2. 任务以整张图为单位分发，空闲的工作线程从队列中取任务，图之间没有依赖，吞吐随工作线程数增长
+ * 3. 每个工作线程复用一个BgRender，尺寸不变时只上传纹理
+ *
+ * 软件光栅化（如Mesa llvmpipe）时单个上下文只能用到部分核心，多个上下文可以并行占满；
+ * 硬件GPU上多个上下文会在驱动中排队，主要收益是上传、读取与CPU准备工作的重叠。
+ * */
+class RenderPool {
+
+private:
+    struct Worker {
+        std::thread thread;
+        GlesEnv *env;
+        // 本线程复用的渲染器，第一次处理图像时创建
+        BgRender *render;
+    };
+
+    struct Job {
+        std::function<bool(Worker *worker)> run;
+        RenderFuture *future;
+    };
+
+    int mWorkerCount;
+    Worker *mWorkers;
+    // 创建成功的工作线程数
+    int mReadyCount;
+    // 启动时持有的共享环境引用
+    GlesEnv *mSharedEnv;
+
+    std::deque<Job *> mJobs;
+    bool mStopped;
+    std::mutex mLock;
+    // 有新任务或需要退出
+    std::condition_variable mJobCondition;
+    // 工作线程创建上下文完成
+    std::condition_variable mReadyCondition;
+    int mStartedCount;
+
+    void loop(Worker *worker);
+
+    RenderFuture *enqueue(const std::function<bool(Worker *worker)> &run);
+
+public:
+
+    explicit RenderPool(int workerCount);
+
+    ~RenderPool();
+
+    /**
+     * 创建共享环境（已存在时复用）与各工作线程的上下文，共享环境会绑定到调用线程
+     *
+     * @return 创建成功的工作线程数，为0时不可用
+     * */
+    int Start();
+
+    /**
+     * 提交任务，在任意一个工作线程执行，该线程的上下文已绑定
+     *
+     * @return 完成句柄，调用方用完后需Release
+     * */
+    RenderFuture *Submit(const std::function<bool(GlesEnv *env)> &run);
+
+    /**
+     * 提交一张RGBA图像，执行默认的灰度 + 旋转渲染
+     * 任务完成前image与output需保持有效
+     *
+     * @param rotate ROTATE_0 等
+     * @param output 大小为width * height * 4，为nullptr时只渲染读取到内部缓冲区（用于基准测试）
+     * */
+    RenderFuture *SubmitImage(int width, int height, const char *image, int rotate,
+                              signed char *output);
+
+    // 等待已提交的任务执行完，退出所有工作线程并释放上下文
+    void Stop();
+
+};
+
+#endif //GLLEARNING_RENDERPOOL_H
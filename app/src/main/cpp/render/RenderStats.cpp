@@ -0,0 +1,192 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "RenderStats.h"
+#include <EGL/egl.h>
+#include <algorithm>
+#include <cstring>
+#include "myutils.h"
+
+#define TAG "RenderStats"
+
+// GL_EXT_disjoint_timer_query，gl3.h中没有定义
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+
+// fence方式等待GPU的超时，1秒
+#define FENCE_TIMEOUT_NS 1000000000ULL
+// 合理的单次绘制耗时上限，10秒
+// 部分驱动（如Mesa llvmpipe）上下文的第一个计时查询返回的是绝对时间戳，超出的结果丢弃
+#define MAX_ELAPSED_NS 10000000000ULL
+
+typedef void (*GetQueryObjectui64vFunc)(GLuint id, GLenum pname, GLuint64 *params);
+
+static GetQueryObjectui64vFunc sGetQueryObjectui64v = nullptr;
+
+// 扩展名按空格分隔，需整词匹配
+static bool hasExtension(const char *extensions, const char *name) {
+    if (extensions == nullptr) {
+        return false;
+    }
+    size_t length = strlen(name);
+    const char *found = extensions;
+    while ((found = strstr(found, name)) != nullptr) {
+        bool start = found == extensions || found[-1] == ' ';
+        bool end = found[length] == ' ' || found[length] == '\0';
+        if (start && end) {
+            return true;
+        }
+        found += length;
+    }
+    return false;
+}
+
+// 最近邻秩分位数，samples已升序
+static long long percentile(const long long *samples, int count, int percent) {
+    int rank = (count * percent + 99) / 100;
+    return samples[rank > 0 ? rank - 1 : 0];
+}
+
+RenderStats::RenderStats(bool gpu) {
+    memset(mWindows, 0, sizeof(mWindows));
+    memset(mQueryIds, 0, sizeof(mQueryIds));
+    memset(mQueryPending, 0, sizeof(mQueryPending));
+    mQueryNext = 0;
+    mQueryActive = -1;
+    mGpuBegin = 0;
+    mTimerQuery = false;
+    if (!gpu) {
+        return;
+    }
+    if (hasExtension((const char *) glGetString(GL_EXTENSIONS), "GL_EXT_disjoint_timer_query")) {
+        if (sGetQueryObjectui64v == nullptr) {
+            sGetQueryObjectui64v = (GetQueryObjectui64vFunc) eglGetProcAddress(
+                    "glGetQueryObjectui64vEXT");
+        }
+        mTimerQuery = sGetQueryObjectui64v != nullptr;
+    }
+    if (mTimerQuery) {
+        glGenQueries(STATS_QUERY_COUNT, mQueryIds);
+        // 清除之前残留的disjoint标记
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    }
+    LOGD(TAG, "RenderStats timerQuery=%d", mTimerQuery);
+}
+
+RenderStats::~RenderStats() = default;
+
+void RenderStats::Add(int stage, long long us) {
+    Window &window = mWindows[stage];
+    window.samples[window.next] = us;
+    window.next = (window.next + 1) % STATS_WINDOW;
+    window.count++;
+}
+
+void RenderStats::BeginGpu() {
+    if (!mTimerQuery) {
+        mGpuBegin = currentTimeUs();
+        return;
+    }
+    collectQueries();
+    if (mQueryPending[mQueryNext]) {
+        // 所有查询都还在等GPU，本帧不计时，不能为了统计阻塞流水线
+        mQueryActive = -1;
+        return;
+    }
+    mQueryActive = mQueryNext;
+    glBeginQuery(GL_TIME_ELAPSED_EXT, mQueryIds[mQueryActive]);
+}
+
+void RenderStats::EndGpu() {
+    if (!mTimerQuery) {
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        glDeleteSync(fence);
+        Add(STATS_STAGE_GPU, currentTimeUs() - mGpuBegin);
+        return;
+    }
+    if (mQueryActive < 0) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    mQueryPending[mQueryActive] = true;
+    mQueryNext = (mQueryActive + 1) % STATS_QUERY_COUNT;
+    mQueryActive = -1;
+}
+
+void RenderStats::collectQueries() {
+    bool hasPending = false;
+    for (int i = 0; i < STATS_QUERY_COUNT; i++) {
+        hasPending |= mQueryPending[i];
+    }
+    if (!hasPending) {
+        return;
+    }
+    // 读取即清除，为真时进行中的查询结果都不可信
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    // mQueryNext之后的第一个待取回的查询最早提交
+    for (int i = 0; i < STATS_QUERY_COUNT; i++) {
+        int index = (mQueryNext + i) % STATS_QUERY_COUNT;
+        if (!mQueryPending[index]) {
+            continue;
+        }
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(mQueryIds[index], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && !disjoint) {
+            // 按顺序完成，之后的也还没有结果
+            break;
+        }
+        if (!disjoint) {
+            GLuint64 elapsed = 0;
+            sGetQueryObjectui64v(mQueryIds[index], GL_QUERY_RESULT, &elapsed);
+            if (elapsed < MAX_ELAPSED_NS) {
+                Add(STATS_STAGE_GPU, (long long) (elapsed / 1000));
+            }
+        }
+        mQueryPending[index] = false;
+    }
+}
+
+void RenderStats::Get(long long *result) {
+    if (mTimerQuery) {
+        collectQueries();
+    }
+    result[STATS_RESULT_GPU_TIMER] = mTimerQuery ? 1 : 0;
+    long long sorted[STATS_WINDOW];
+    for (int stage = 0; stage < STATS_STAGE_COUNT; stage++) {
+        Window &window = mWindows[stage];
+        long long *fields = result + STATS_RESULT_STAGES + stage * STATS_FIELD_SIZE;
+        int count = (int) std::min(window.count, (long long) STATS_WINDOW);
+        fields[STATS_FIELD_COUNT] = window.count;
+        if (count == 0) {
+            fields[STATS_FIELD_P50] = 0;
+            fields[STATS_FIELD_P95] = 0;
+            fields[STATS_FIELD_P99] = 0;
+            fields[STATS_FIELD_MAX] = 0;
+            continue;
+        }
+        // 窗口未满时有效样本为[0, count)，满了之后整个数组都有效，顺序不影响分位数
+        memcpy(sorted, window.samples, count * sizeof(long long));
+        std::sort(sorted, sorted + count);
+        fields[STATS_FIELD_P50] = percentile(sorted, count, 50);
+        fields[STATS_FIELD_P95] = percentile(sorted, count, 95);
+        fields[STATS_FIELD_P99] = percentile(sorted, count, 99);
+        fields[STATS_FIELD_MAX] = sorted[count - 1];
+    }
+}
+
+void RenderStats::Release() {
+    if (mTimerQuery) {
+        if (mQueryActive >= 0) {
+            glEndQuery(GL_TIME_ELAPSED_EXT);
+            mQueryActive = -1;
+        }
+        glDeleteQueries(STATS_QUERY_COUNT, mQueryIds);
+        memset(mQueryIds, 0, sizeof(mQueryIds));
+        memset(mQueryPending, 0, sizeof(mQueryPending));
+        mTimerQuery = false;
+    }
+}
@@ -0,0 +1,115 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_RENDERSTATS_H
+#define GLLEARNING_RENDERSTATS_H
+
+#include <GLES3/gl3.h>
+
+// 统计的阶段
+// 纹理上传，UpdateFrame
+#define STATS_STAGE_UPLOAD 0
+// 绘制命令提交的CPU耗时，CPU引擎时为整个计算耗时
+#define STATS_STAGE_DRAW 1
+// 绘制在GPU上的执行耗时
+#define STATS_STAGE_GPU 2
+// 读取（含YUV打包），同步读取时包含等待GPU，异步读取时只有提交
+#define STATS_STAGE_READBACK 3
+// GetData拷贝到调用方内存，异步读取时包含等待与映射PBO
+#define STATS_STAGE_COPY 4
+#define STATS_STAGE_COUNT 5
+
+// 每个阶段的统计项，单位微秒
+// 累计样本数，不受窗口限制
+#define STATS_FIELD_COUNT 0
+#define STATS_FIELD_P50 1
+#define STATS_FIELD_P95 2
+#define STATS_FIELD_P99 3
+// 窗口内的最大值
+#define STATS_FIELD_MAX 4
+#define STATS_FIELD_SIZE 5
+
+// 统计结果下标
+// GPU阶段的来源，1为GL_EXT_disjoint_timer_query，0为CPU时间戳 + fence等待
+#define STATS_RESULT_GPU_TIMER 0
+// 之后为STATS_STAGE_COUNT个阶段，各STATS_FIELD_SIZE项，
+// 下标 = STATS_RESULT_STAGES + stage * STATS_FIELD_SIZE + field
+#define STATS_RESULT_STAGES 1
+#define STATS_RESULT_SIZE (STATS_RESULT_STAGES + STATS_STAGE_COUNT * STATS_FIELD_SIZE)
+
+// 滚动窗口的样本数，分位数只按最近这些样本计算
+#define STATS_WINDOW 256
+// 进行中的GPU计时查询数，结果一般延迟1~2帧才可读
+#define STATS_QUERY_COUNT 4
+
+/**
+ * 渲染各阶段耗时统计，每个BgRender实例一份，只在开启统计时创建，关闭时调用方只多一次判空
+ *
+ * CPU阶段用CLOCK_MONOTONIC计时。GPU阶段优先使用GL_EXT_disjoint_timer_query，
+ * 查询结果异步取回，不阻塞流水线，发生disjoint（如降频、上下文切换）时丢弃本批结果；
+ * 不支持时在绘制后插入fence并等待，得到的是提交 + 执行的上限，同时会使绘制变为同步。
+ *
+ * 每个阶段保留最近STATS_WINDOW个样本的环形窗口，读取时排序求p50/p95/p99。
+ * 所有方法需在上下文所在线程调用。
+ * */
+class RenderStats {
+
+private:
+    struct Window {
+        // 最近的样本，单位微秒
+        long long samples[STATS_WINDOW];
+        // 下一个写入位置
+        int next;
+        // 累计样本数
+        long long count;
+    };
+
+    Window mWindows[STATS_STAGE_COUNT];
+
+    // 是否使用GPU计时查询
+    bool mTimerQuery;
+    GLuint mQueryIds[STATS_QUERY_COUNT];
+    // 已结束、结果尚未取回
+    bool mQueryPending[STATS_QUERY_COUNT];
+    // 下一个使用的查询，也是最早提交的查询
+    int mQueryNext;
+    // 正在计时的查询，-1为没有
+    int mQueryActive;
+    // fence方式下GPU阶段的开始时间
+    long long mGpuBegin;
+
+    // 按提交顺序取回已完成的查询结果
+    void collectQueries();
+
+public:
+
+    /**
+     * @param gpu 是否有GL环境，有时检测计时查询扩展，需在上下文所在线程调用
+     * */
+    explicit RenderStats(bool gpu);
+
+    ~RenderStats();
+
+    // 记录一个样本
+    void Add(int stage, long long us);
+
+    // 开始GPU阶段计时，与EndGpu之间不能嵌套其他计时查询
+    void BeginGpu();
+
+    // 结束GPU阶段计时，fence方式下会等待GPU执行完
+    void EndGpu();
+
+    /**
+     * 读取统计结果，会先取回已完成的GPU查询
+     *
+     * @param result 长度为STATS_RESULT_SIZE，见STATS_RESULT_GPU_TIMER 等
+     * */
+    void Get(long long *result);
+
+    // 释放GL资源，需在上下文所在线程调用
+    void Release();
+
+};
+
+#endif //GLLEARNING_RENDERSTATS_H
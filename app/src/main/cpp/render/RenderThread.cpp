@@ -0,0 +1,173 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "RenderThread.h"
+#include <chrono>
+#include <pthread.h>
+#include "myutils.h"
+
+#define TAG "RenderThread"
+
+RenderThread *RenderThread::sInstance = nullptr;
+std::once_flag RenderThread::sOnce;
+
+RenderFuture::RenderFuture() {
+    mState = FUTURE_PENDING;
+    // 提交方与渲染线程各一份
+    mRefCount = 2;
+}
+
+RenderFuture::~RenderFuture() = default;
+
+int RenderFuture::GetState() {
+    return mState.load();
+}
+
+int RenderFuture::Wait(long long timeoutMs) {
+    int state = mState.load();
+    if (state != FUTURE_PENDING) {
+        return state;
+    }
+    std::unique_lock<std::mutex> lock(mLock);
+    auto done = [this]() { return mState.load() != FUTURE_PENDING; };
+    if (timeoutMs < 0) {
+        mCondition.wait(lock, done);
+    } else {
+        mCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs), done);
+    }
+    return mState.load();
+}
+
+void RenderFuture::Complete(bool success) {
+    {
+        // 加锁保证等待方检查状态与进入休眠之间不会错过唤醒
+        std::lock_guard<std::mutex> lockGuard(mLock);
+        mState = success ? FUTURE_SUCCESS : FUTURE_FAILED;
+    }
+    mCondition.notify_all();
+}
+
+void RenderFuture::Retain() {
+    mRefCount.fetch_add(1);
+}
+
+void RenderFuture::Release() {
+    if (mRefCount.fetch_sub(1) == 1) {
+        delete this;
+    }
+}
+
+RenderThread::RenderThread() {
+    mStub.next = nullptr;
+    mStub.future = nullptr;
+    mHead = &mStub;
+    mTail = &mStub;
+    mSleeping = false;
+}
+
+RenderThread *RenderThread::Get() {
+    std::call_once(sOnce, []() {
+        sInstance = new RenderThread();
+        std::thread thread(&RenderThread::loop, sInstance);
+        sInstance->mThreadId = thread.get_id();
+        // 与进程同生命周期
+        thread.detach();
+    });
+    return sInstance;
+}
+
+bool RenderThread::IsCurrent() {
+    return std::this_thread::get_id() == mThreadId;
+}
+
+void RenderThread::push(Task *task) {
+    task->next = nullptr;
+    // 入队只有这一次交换，生产者之间不会阻塞
+    Task *prev = mHead.exchange(task);
+    prev->next = task;
+}
+
+RenderThread::Task *RenderThread::pop() {
+    Task *tail = mTail;
+    Task *next = tail->next.load();
+    if (tail == &mStub) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        mTail = next;
+        tail = next;
+        next = next->next.load();
+    }
+    if (next != nullptr) {
+        mTail = next;
+        return tail;
+    }
+    if (tail != mHead.load()) {
+        // 生产者已交换mHead但还没有链接上，稍后唤醒
+        return nullptr;
+    }
+    // tail是最后一个任务，放回mStub后才能取出
+    push(&mStub);
+    next = tail->next.load();
+    if (next != nullptr) {
+        mTail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void RenderThread::loop() {
+    pthread_setname_np(pthread_self(), "GLRenderNative");
+    LOGI(TAG, "loop start");
+    while (true) {
+        Task *task = pop();
+        if (task == nullptr) {
+            std::unique_lock<std::mutex> lock(mLock);
+            mSleeping = true;
+            task = pop();
+            while (task == nullptr) {
+                mCondition.wait(lock);
+                task = pop();
+            }
+            mSleeping = false;
+        }
+        bool success = task->run();
+        if (task->future != nullptr) {
+            task->future->Complete(success);
+            task->future->Release();
+        }
+        delete task;
+    }
+}
+
+void RenderThread::enqueue(const std::function<bool()> &run, RenderFuture *future) {
+    Task *task = new Task();
+    task->run = run;
+    task->future = future;
+    push(task);
+    if (mSleeping.load()) {
+        std::lock_guard<std::mutex> lockGuard(mLock);
+        mCondition.notify_one();
+    }
+}
+
+RenderFuture *RenderThread::Submit(const std::function<bool()> &run) {
+    RenderFuture *future = new RenderFuture();
+    enqueue(run, future);
+    return future;
+}
+
+void RenderThread::Post(const std::function<bool()> &run) {
+    enqueue(run, nullptr);
+}
+
+bool RenderThread::Run(const std::function<bool()> &run) {
+    if (IsCurrent()) {
+        return run();
+    }
+    RenderFuture *future = Submit(run);
+    bool success = future->Wait(-1) == FUTURE_SUCCESS;
+    future->Release();
+    return success;
+}
@@ -0,0 +1,127 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_RENDERTHREAD_H
+#define GLLEARNING_RENDERTHREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// 任务状态
+#define FUTURE_PENDING 0
+#define FUTURE_SUCCESS 1
+#define FUTURE_FAILED 2
+
+/**
+ * 提交到渲染线程的任务的完成句柄，可轮询或等待
+ * 引用计数管理，渲染线程与提交方各持有一份，都Release后才释放
+ * */
+class RenderFuture {
+
+private:
+    std::atomic<int> mState;
+    std::atomic<int> mRefCount;
+    // 只用于Wait的阻塞与唤醒，状态本身是原子的，轮询不需要加锁
+    std::mutex mLock;
+    std::condition_variable mCondition;
+
+    ~RenderFuture();
+
+public:
+
+    RenderFuture();
+
+    // 当前状态，FUTURE_PENDING 等，不阻塞
+    int GetState();
+
+    /**
+     * 等待任务完成
+     *
+     * @param timeoutMs <0 一直等待
+     * @return 返回时的状态，超时返回FUTURE_PENDING
+     * */
+    int Wait(long long timeoutMs);
+
+    // 由渲染线程在任务执行完后调用
+    void Complete(bool success);
+
+    void Retain();
+
+    void Release();
+
+};
+
+/**
+ * 进程内唯一的渲染线程，共享的EGL上下文只在该线程current
+ *
+ * 任务队列为无锁的多生产者单消费者链表（Vyukov MPSC）：入队只有一次原子交换，
+ * 多个线程同时提交不会互相阻塞；队列为空时渲染线程才在条件变量上休眠，
+ * 生产者只在其休眠时才加锁唤醒。任务按提交顺序执行。
+ * */
+class RenderThread {
+
+private:
+    struct Task {
+        std::atomic<Task *> next;
+        std::function<bool()> run;
+        // 为nullptr时不关心结果
+        RenderFuture *future;
+    };
+
+    // 生产者在mHead入队，渲染线程从mTail出队，mStub保证链表永不为空
+    std::atomic<Task *> mHead;
+    Task *mTail;
+    Task mStub;
+
+    std::thread::id mThreadId;
+    std::atomic<bool> mSleeping;
+    std::mutex mLock;
+    std::condition_variable mCondition;
+
+    static RenderThread *sInstance;
+    static std::once_flag sOnce;
+
+    RenderThread();
+
+    void push(Task *task);
+
+    // 只在渲染线程调用，没有可执行的任务时返回nullptr
+    Task *pop();
+
+    void loop();
+
+    void enqueue(const std::function<bool()> &run, RenderFuture *future);
+
+public:
+
+    // 获取渲染线程，首次调用时启动
+    static RenderThread *Get();
+
+    /**
+     * 异步提交任务，不阻塞
+     *
+     * @param run 在渲染线程执行，返回值决定FUTURE_SUCCESS或FUTURE_FAILED
+     * @return 完成句柄，调用方用完后需Release
+     * */
+    RenderFuture *Submit(const std::function<bool()> &run);
+
+    // 异步提交任务，不关心结果
+    void Post(const std::function<bool()> &run);
+
+    /**
+     * 在渲染线程同步执行任务并等待完成，已在渲染线程时直接执行
+     *
+     * @return run的返回值
+     * */
+    bool Run(const std::function<bool()> &run);
+
+    // 当前是否为渲染线程
+    bool IsCurrent();
+
+};
+
+#endif //GLLEARNING_RENDERTHREAD_H
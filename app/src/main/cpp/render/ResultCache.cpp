@@ -0,0 +1,183 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "ResultCache.h"
+#include <cstring>
+#include "myutils.h"
+#include "BufferPool.h"
+
+#define TAG "ResultCache"
+
+// xxHash64的常量
+static const unsigned long long PRIME1 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const unsigned long long PRIME3 = 0x165667B19E3779F9ULL;
+static const unsigned long long PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const unsigned long long PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline unsigned long long rotl(unsigned long long x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline unsigned long long read64(const unsigned char *p) {
+    // 输入不保证8字节对齐
+    unsigned long long v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline unsigned long long round64(unsigned long long acc, unsigned long long input) {
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline unsigned long long merge64(unsigned long long acc, unsigned long long lane) {
+    acc ^= round64(0, lane);
+    return acc * PRIME1 + PRIME4;
+}
+
+ResultCache *ResultCache::sInstance = nullptr;
+std::once_flag ResultCache::sOnce;
+
+ResultCache::ResultCache() {
+    mBytes = 0;
+    mBudget = 0;
+    memset(mStats, 0, sizeof(mStats));
+}
+
+ResultCache *ResultCache::Get() {
+    std::call_once(sOnce, []() {
+        // 与进程同生命周期
+        sInstance = new ResultCache();
+    });
+    return sInstance;
+}
+
+unsigned long long ResultCache::Hash(const void *data, long long size, unsigned long long seed) {
+    const unsigned char *p = (const unsigned char *) data;
+    const unsigned char *end = p + size;
+    unsigned long long h;
+    if (size >= 32) {
+        // 4路互不依赖，每次32字节
+        unsigned long long v1 = seed + PRIME1 + PRIME2;
+        unsigned long long v2 = seed + PRIME2;
+        unsigned long long v3 = seed;
+        unsigned long long v4 = seed - PRIME1;
+        const unsigned char *limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge64(h, v1);
+        h = merge64(h, v2);
+        h = merge64(h, v3);
+        h = merge64(h, v4);
+    } else {
+        h = seed + PRIME5;
+    }
+    h += (unsigned long long) size;
+    for (; p + 8 <= end; p += 8) {
+        h ^= round64(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end) {
+        unsigned int v;
+        memcpy(&v, p, sizeof(v));
+        h ^= (unsigned long long) v * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+    }
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+void ResultCache::SetBudget(long long bytes) {
+    LOGD(TAG, "SetBudget bytes=%lld", bytes);
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    mBudget = bytes > 0 ? bytes : 0;
+    trim(mBudget);
+}
+
+bool ResultCache::IsEnabled() {
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    return mBudget > 0;
+}
+
+bool ResultCache::Lookup(unsigned long long key, void *dst, int size) {
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    auto found = mIndex.find(key);
+    if (found == mIndex.end() || found->second->size != size) {
+        mStats[RESULT_CACHE_MISSES]++;
+        return false;
+    }
+    // 移到表头，迭代器仍然有效
+    mEntries.splice(mEntries.begin(), mEntries, found->second);
+    memcpy(dst, found->second->data, size);
+    mStats[RESULT_CACHE_HITS]++;
+    return true;
+}
+
+void ResultCache::Insert(unsigned long long key, const void *data, int size) {
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    if (size <= 0 || size > mBudget) {
+        return;
+    }
+    auto found = mIndex.find(key);
+    if (found != mIndex.end()) {
+        // 其他线程已经放入了相同的结果
+        mEntries.splice(mEntries.begin(), mEntries, found->second);
+        return;
+    }
+    // 先腾出空间，峰值不超过预算
+    trim(mBudget - size);
+    Entry entry;
+    entry.key = key;
+    entry.data = (char *) BufferPool::Get()->Alloc(size);
+    if (entry.data == nullptr) {
+        // 超出全局内存预算，不缓存
+        return;
+    }
+    entry.size = size;
+    memcpy(entry.data, data, size);
+    mEntries.push_front(entry);
+    mIndex[key] = mEntries.begin();
+    mBytes += size;
+}
+
+void ResultCache::trim(long long budget) {
+    while (mBytes > budget && !mEntries.empty()) {
+        Entry &entry = mEntries.back();
+        mBytes -= entry.size;
+        mIndex.erase(entry.key);
+        BufferPool::Get()->Free(entry.data);
+        mEntries.pop_back();
+        mStats[RESULT_CACHE_EVICTIONS]++;
+    }
+}
+
+void ResultCache::Clear() {
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    trim(0);
+}
+
+void ResultCache::GetStats(long long *stats) {
+    std::lock_guard<std::mutex> lockGuard(mLock);
+    mStats[RESULT_CACHE_ENTRIES] = (long long) mEntries.size();
+    mStats[RESULT_CACHE_BYTES] = mBytes;
+    mStats[RESULT_CACHE_BUDGET] = mBudget;
+    memcpy(stats, mStats, sizeof(mStats));
+}
@@ -0,0 +1,93 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_RESULTCACHE_H
+#define GLLEARNING_RESULTCACHE_H
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// 统计项下标，见GetStats
+#define RESULT_CACHE_HITS 0
+#define RESULT_CACHE_MISSES 1
+// 因超出预算被淘汰的结果数，Clear与调小预算也计入
+#define RESULT_CACHE_EVICTIONS 2
+#define RESULT_CACHE_ENTRIES 3
+// 缓存的结果总字节数
+#define RESULT_CACHE_BYTES 4
+#define RESULT_CACHE_BUDGET 5
+#define RESULT_CACHE_STATS_COUNT 6
+
+/**
+ * 进程内共享的渲染结果缓存，按内容寻址，LRU淘汰
+ *
+ * key由输入像素的哈希与所有影响输出的参数（格式、尺寸、变换、滤镜、输出格式等）一起哈希得到，
+ * 由BgRender计算；同一张截图、水印以相同设置反复渲染时，命中后只有一次memcpy，没有GPU往返。
+ * 哈希为64位，按8字节读取、4路并行累加，速度远高于纹理上传，只在开启缓存时计算。
+ *
+ * 预算为0时关闭（默认），结果字节数超过预算时从最久未使用的开始淘汰。
+ * 可在任意线程调用，RenderPool的多个工作线程共用同一份缓存。
+ * */
+class ResultCache {
+
+private:
+    struct Entry {
+        unsigned long long key;
+        char *data;
+        int size;
+    };
+
+    // 表头为最近使用
+    std::list<Entry> mEntries;
+    std::unordered_map<unsigned long long, std::list<Entry>::iterator> mIndex;
+    long long mBytes;
+    long long mBudget;
+    long long mStats[RESULT_CACHE_STATS_COUNT];
+    std::mutex mLock;
+
+    static ResultCache *sInstance;
+    static std::once_flag sOnce;
+
+    ResultCache();
+
+    // 淘汰到不超过budget字节，需持有mLock
+    void trim(long long budget);
+
+public:
+
+    // 获取进程内共享的缓存
+    static ResultCache *Get();
+
+    // 64位内容哈希，seed用于串联多段数据
+    static unsigned long long Hash(const void *data, long long size, unsigned long long seed = 0);
+
+    /**
+     * 设置字节预算，超出时立即淘汰
+     *
+     * @param bytes <=0 关闭缓存并释放所有结果
+     * */
+    void SetBudget(long long bytes);
+
+    bool IsEnabled();
+
+    /**
+     * 查找结果，命中时拷贝到dst并移到表头
+     *
+     * @param size 期望的字节数，与缓存的结果不一致时视为未命中
+     * */
+    bool Lookup(unsigned long long key, void *dst, int size);
+
+    // 保存一份结果的拷贝，超过预算的结果不保存
+    void Insert(unsigned long long key, const void *data, int size);
+
+    // 释放所有结果，计数不清零
+    void Clear();
+
+    // 统计，长度为RESULT_CACHE_STATS_COUNT，下标见RESULT_CACHE_HITS 等
+    void GetStats(long long *stats);
+
+};
+
+#endif //GLLEARNING_RESULTCACHE_H
@@ -0,0 +1,45 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_TEXTRANSFORM_H
+#define GLLEARNING_TEXTRANSFORM_H
+
+#include <GLES3/gl3.h>
+
+/**
+ * 纹理坐标仿射变换，2x3行优先 {a, b, c, d, e, f}：
+ *     s = a * u + b * v + c
+ *     t = d * u + e * v + f
+ * (u, v)为输出图像的归一化坐标，(s, t)为原图的采样坐标，即输出 -> 原图的反向映射，
+ * 与shader中采样的方向一致，v = 0 对应读取结果的第一行
+ * */
+#define TEX_TRANSFORM_SIZE 6
+
+static inline void texTransformIdentity(GLfloat *m) {
+    m[0] = 1.0f; m[1] = 0.0f; m[2] = 0.0f;
+    m[3] = 0.0f; m[4] = 1.0f; m[5] = 0.0f;
+}
+
+// out = first之后再经过second，即 (s, t) = second(first(u, v))，out可以与输入相同
+static inline void texTransformConcat(const GLfloat *second, const GLfloat *first, GLfloat *out) {
+    GLfloat m[TEX_TRANSFORM_SIZE];
+    m[0] = second[0] * first[0] + second[1] * first[3];
+    m[1] = second[0] * first[1] + second[1] * first[4];
+    m[2] = second[0] * first[2] + second[1] * first[5] + second[2];
+    m[3] = second[3] * first[0] + second[4] * first[3];
+    m[4] = second[3] * first[1] + second[4] * first[4];
+    m[5] = second[3] * first[2] + second[4] * first[5] + second[5];
+    for (int i = 0; i < TEX_TRANSFORM_SIZE; i++) {
+        out[i] = m[i];
+    }
+}
+
+// 转为glUniformMatrix3fv使用的列优先mat3
+static inline void texTransformToMat3(const GLfloat *m, GLfloat *mat3) {
+    mat3[0] = m[0]; mat3[1] = m[3]; mat3[2] = 0.0f;
+    mat3[3] = m[1]; mat3[4] = m[4]; mat3[5] = 0.0f;
+    mat3[6] = m[2]; mat3[7] = m[5]; mat3[8] = 1.0f;
+}
+
+#endif //GLLEARNING_TEXTRANSFORM_H
@@ -0,0 +1,299 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#include "YuvPacker.h"
+#include "myutils.h"
+#include <cstring>
+
+#define TAG "YuvPacker"
+
+// 色度平面排列或RGB的字节排列，与shader中的u_layout一致
+#define LAYOUT_VU 0
+#define LAYOUT_UV 1
+#define LAYOUT_PLANAR 2
+#define LAYOUT_GRAY 3
+#define LAYOUT_RGB565 4
+#define LAYOUT_RGB 5
+
+static const char *PACK_VERTEX_SHADER =
+        "#version 300 es                            \n"
+        "layout(location = 0) in vec4 a_position;   \n"
+        "void main()                                \n"
+        "{                                          \n"
+        "   gl_Position = a_position;               \n"
+        "}                                          \n";
+
+// 每个片元输出4个连续字节，字节下标 = (行 * u_rowPixels + 列) * 4 + i
+static const char *PACK_FRAGMENT_SHADER =
+        "#version 300 es\n"
+        "precision highp float;\n"
+        "precision highp int;\n"
+        "layout(location = 0) out vec4 outColor;\n"
+        "uniform sampler2D s_TextureMap;\n"
+        "uniform ivec4 u_size;\n"  // xy：图像宽高，zw：色度平面宽高
+        "uniform int u_rowPixels;\n"
+        "uniform int u_layout;\n"  // 0：VU交错，1：UV交错，2：U、V分平面，3：灰度，4：RGB565，5：RGB
+        "uniform mat4 u_rgbToYuv;\n"
+        "vec3 toYuv(vec4 color)\n"
+        "{\n"
+        "    return (u_rgbToYuv * vec4(color.rgb, 1.0)).xyz;\n"
+        "}\n"
+        "vec4 pixelAt(int pixel)\n"
+        "{\n"
+        "    return texelFetch(s_TextureMap, ivec2(pixel % u_size.x, pixel / u_size.x), 0);\n"
+        "}\n"
+        // RGB类输出，最后一行多出的字节不采样，texelFetch越界的结果未定义
+        "float packRgbByte(int index)\n"
+        "{\n"
+        "    int bytesPerPixel = u_layout - 2;\n"
+        "    int pixel = index / bytesPerPixel;\n"
+        "    if (pixel >= u_size.x * u_size.y) {\n"
+        "        return 0.0;\n"
+        "    }\n"
+        "    vec4 color = pixelAt(pixel);\n"
+        "    if (u_layout == 3) {\n"
+        "        return dot(color.rgb, vec3(0.299, 0.587, 0.114));\n"
+        "    }\n"
+        "    if (u_layout == 5) {\n"
+        "        return color[index - pixel * 3];\n"
+        "    }\n"
+        // 小端：低字节为G低3位 + B，高字节为R + G高3位
+        "    ivec3 c = ivec3(floor(clamp(color.rgb, 0.0, 1.0) * vec3(31.0, 63.0, 31.0) + 0.5));\n"
+        "    int value = index % 2 == 0 ? ((c.g & 7) << 5) | c.b : (c.r << 3) | (c.g >> 3);\n"
+        "    return float(value) / 255.0;\n"
+        "}\n"
+        "float packByte(int index)\n"
+        "{\n"
+        "    if (u_layout >= 3) {\n"
+        "        return packRgbByte(index);\n"
+        "    }\n"
+        "    int lumaSize = u_size.x * u_size.y;\n"
+        "    if (index < lumaSize) {\n"
+        "        return toYuv(pixelAt(index)).x;\n"
+        "    }\n"
+        "    index -= lumaSize;\n"
+        "    int chromaSize = u_size.z * u_size.w;\n"
+        "    int chromaIndex;\n"
+        "    bool isU;\n"
+        "    if (u_layout == 2) {\n"
+        "        isU = index < chromaSize;\n"
+        "        chromaIndex = isU ? index : index - chromaSize;\n"
+        "    } else {\n"
+        "        chromaIndex = index / 2;\n"
+        "        isU = (index % 2 == 1) == (u_layout == 0);\n"
+        "    }\n"
+        "    if (chromaIndex >= chromaSize) {\n"
+        "        return 0.0;\n"
+        "    }\n"
+        // 2x2像素取平均，奇数宽高时边缘重复最后一行/列
+        "    ivec2 p = ivec2(chromaIndex % u_size.z, chromaIndex / u_size.z) * 2;\n"
+        "    ivec2 maxP = u_size.xy - 1;\n"
+        "    vec4 color = (texelFetch(s_TextureMap, p, 0)\n"
+        "        + texelFetch(s_TextureMap, min(p + ivec2(1, 0), maxP), 0)\n"
+        "        + texelFetch(s_TextureMap, min(p + ivec2(0, 1), maxP), 0)\n"
+        "        + texelFetch(s_TextureMap, min(p + ivec2(1, 1), maxP), 0)) * 0.25;\n"
+        "    vec3 yuv = toYuv(color);\n"
+        "    return isU ? yuv.y : yuv.z;\n"
+        "}\n"
+        "void main()\n"
+        "{\n"
+        "    int base = (int(gl_FragCoord.y) * u_rowPixels + int(gl_FragCoord.x)) * 4;\n"
+        "    outColor = clamp(vec4(packByte(base), packByte(base + 1), packByte(base + 2),\n"
+        "                          packByte(base + 3)), 0.0, 1.0);\n"
+        "}\n";
+
+YuvPacker::YuvPacker(GlesEnv *env) {
+    mEnv = env;
+    mProgramId = 0;
+    mSizeLoc = -1;
+    mRowPixelsLoc = -1;
+    mLayoutLoc = -1;
+    mRgbToYuvLoc = -1;
+    mFboId = 0;
+    mTextureId = 0;
+    mTextureWidth = 0;
+    mTextureHeight = 0;
+    mVboIds[0] = mVboIds[1] = 0;
+    mVaoId = 0;
+    mRowPixels = 0;
+    mRows = 0;
+    mDataSize = 0;
+    SetColorSpace(YUV_STANDARD_BT601, true);
+}
+
+YuvPacker::~YuvPacker() {
+    LOGD(TAG, "YuvPacker un constructor");
+}
+
+// Y = Kr R + Kg G + Kb B，U = (B - Y) / 2(1 - Kb)，V = (R - Y) / 2(1 - Kr)
+// 视频范围再将Y压缩到[16, 235]、UV压缩到[16, 240]
+void YuvPacker::SetColorSpace(int standard, bool fullRange) {
+    float kr = standard == YUV_STANDARD_BT709 ? 0.2126f : 0.299f;
+    float kb = standard == YUV_STANDARD_BT709 ? 0.0722f : 0.114f;
+    float kg = 1.0f - kr - kb;
+    float yScale = fullRange ? 1.0f : 219.0f / 255.0f;
+    float cScale = fullRange ? 1.0f : 224.0f / 255.0f;
+    float yOffset = fullRange ? 0.0f : 16.0f / 255.0f;
+    float cOffset = 128.0f / 255.0f;
+    float uScale = cScale / (2.0f * (1.0f - kb));
+    float vScale = cScale / (2.0f * (1.0f - kr));
+    GLfloat matrix[16] = {
+            // r
+            kr * yScale, -kr * uScale, (1.0f - kr) * vScale, 0.0f,
+            // g
+            kg * yScale, -kg * uScale, -kg * vScale, 0.0f,
+            // b
+            kb * yScale, (1.0f - kb) * uScale, -kb * vScale, 0.0f,
+            // 偏移
+            yOffset, cOffset, cOffset, 1.0f,
+    };
+    memcpy(mRgbToYuv, matrix, sizeof(matrix));
+}
+
+bool YuvPacker::ensureProgram() {
+    if (mProgramId != 0) {
+        return true;
+    }
+    mProgramId = mEnv->GetProgram(PACK_VERTEX_SHADER, PACK_FRAGMENT_SHADER);
+    if (mProgramId == 0) {
+        LOGE(TAG, "ensureProgram fail");
+        return false;
+    }
+    mSizeLoc = glGetUniformLocation(mProgramId, "u_size");
+    mRowPixelsLoc = glGetUniformLocation(mProgramId, "u_rowPixels");
+    mLayoutLoc = glGetUniformLocation(mProgramId, "u_layout");
+    mRgbToYuvLoc = glGetUniformLocation(mProgramId, "u_rgbToYuv");
+
+    GLfloat vVertices[] = {
+            -1.0f, -1.0f, 0.0f,
+            1.0f, -1.0f, 0.0f,
+            -1.0f, 1.0f, 0.0f,
+            1.0f, 1.0f, 0.0f,
+    };
+    GLushort indices[] = {0, 1, 2, 1, 2, 3};
+    glGenBuffers(2, mVboIds);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vVertices), vVertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mVboIds[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glGenVertexArrays(1, &mVaoId);
+    glBindVertexArray(mVaoId);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboIds[0]);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mVboIds[1]);
+    glBindVertexArray(GL_NONE);
+    return true;
+}
+
+void YuvPacker::ensureTarget(int width, int height) {
+    if (mFboId != 0 && width == mTextureWidth && height == mTextureHeight) {
+        return;
+    }
+    LOGD(TAG, "ensureTarget width=%d height=%d", width, height);
+    if (mFboId == 0) {
+        glGenTextures(1, &mTextureId);
+        glGenFramebuffers(1, &mFboId);
+    }
+    mTextureWidth = width;
+    mTextureHeight = height;
+    glBindTexture(GL_TEXTURE_2D, mTextureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTextureId, 0);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+}
+
+bool YuvPacker::Pack(GLuint rgbaTexture, int width, int height, int format) {
+    int layout;
+    switch (format) {
+        case IMAGE_FORMAT_NV21:
+            layout = LAYOUT_VU;
+            break;
+        case IMAGE_FORMAT_NV12:
+            layout = LAYOUT_UV;
+            break;
+        case IMAGE_FORMAT_I420:
+            layout = LAYOUT_PLANAR;
+            break;
+        case IMAGE_FORMAT_GRAY:
+            layout = LAYOUT_GRAY;
+            break;
+        case IMAGE_FORMAT_RGB565:
+            layout = LAYOUT_RGB565;
+            break;
+        case IMAGE_FORMAT_RGB:
+            layout = LAYOUT_RGB;
+            break;
+        default:
+            LOGE(TAG, "Pack unsupported format=%d", format);
+            return false;
+    }
+    if (!ensureProgram()) {
+        return false;
+    }
+    // 每行width个像素即width * 4字节，最后一行可能只有一部分有效
+    mDataSize = InputTexture::GetDataSize(format, width, height);
+    mRowPixels = width;
+    mRows = (mDataSize + width * 4 - 1) / (width * 4);
+    ensureTarget(mRowPixels, mRows);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFboId);
+    glViewport(0, 0, mRowPixels, mRows);
+    glUseProgram(mProgramId);
+    glUniform4i(mSizeLoc, width, height, (width + 1) / 2, (height + 1) / 2);
+    glUniform1i(mRowPixelsLoc, mRowPixels);
+    glUniform1i(mLayoutLoc, layout);
+    glUniformMatrix4fv(mRgbToYuvLoc, 1, GL_FALSE, mRgbToYuv);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, rgbaTexture);
+    glBindVertexArray(mVaoId);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const void *) 0);
+    glBindVertexArray(GL_NONE);
+    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    LOGD(TAG, "Pack format=%d rows=%d error=%d", format, mRows, glGetError());
+    return true;
+}
+
+void YuvPacker::Read(void *addr) {
+    int rowSize = mRowPixels * 4;
+    int fullRows = mDataSize / rowSize;
+    int remain = mDataSize - fullRows * rowSize;
+    if (fullRows > 0) {
+        glReadPixels(0, 0, mRowPixels, fullRows, GL_RGBA, GL_UNSIGNED_BYTE, addr);
+    }
+    if (remain > 0) {
+        // 最后一行只有一部分有效，读到临时缓冲区再拷贝，避免写出调用方的内存
+        GLubyte *lastRow = new GLubyte[rowSize];
+        glReadPixels(0, fullRows, mRowPixels, 1, GL_RGBA, GL_UNSIGNED_BYTE, lastRow);
+        memcpy((GLubyte *) addr + fullRows * rowSize, lastRow, remain);
+        delete[] lastRow;
+    }
+}
+
+void YuvPacker::ReadAsync(PboReader *reader) {
+    reader->Read(0, 0, mRowPixels, mRows, GL_RGBA, GL_UNSIGNED_BYTE,
+                 (GLsizeiptr) mRowPixels * mRows * 4, mDataSize);
+}
+
+void YuvPacker::Release() {
+    LOGD(TAG, "Release");
+    if (mFboId != 0) {
+        glDeleteFramebuffers(1, &mFboId);
+        glDeleteTextures(1, &mTextureId);
+    }
+    mFboId = 0;
+    mTextureId = 0;
+    mTextureWidth = 0;
+    mTextureHeight = 0;
+    if (mVaoId != 0) {
+        glDeleteVertexArrays(1, &mVaoId);
+        glDeleteBuffers(2, mVboIds);
+    }
+    mVaoId = 0;
+    // 程序由GlesEnv缓存
+    mProgramId = 0;
+}
@@ -0,0 +1,87 @@
+//
+// Created by agent on 2026/10/17.
+//
+
+#ifndef GLLEARNING_YUVPACKER_H
+#define GLLEARNING_YUVPACKER_H
+
+#include <GLES3/gl3.h>
+#include "GlesEnv.h"
+#include "PboReader.h"
+#include "InputTexture.h"
+
+/**
+ * 将渲染结果在GPU上转换为NV21/NV12/I420，读取量只有RGBA的37.5%，可直接送入编码器
+ *
+ * 目标YUV数据看作一段连续的字节，每4个字节打包成RGBA8 FBO中的一个像素，FBO宽度为图像宽度，
+ * 逐行读取后字节顺序即为Y平面 + 色度平面，不需要CPU再做任何重排。
+ * 每个片元根据自己的字节下标计算对应的平面与坐标：Y逐像素转换，色度取2x2像素的平均值。
+ *
+ * 单通道灰度、RGB565、RGB输出按同样的方式打包，读取量分别为RGBA的25%、50%、75%。
+ * OpenGL ES 3.0的glReadPixels只保证GL_RGBA/GL_UNSIGNED_BYTE，R8、RGB565附件能否直接读取取决于驱动，
+ * RGB8附件在多数驱动上不能直接读取，打包后所有设备都只传输目标格式的字节数。
+ * */
+class YuvPacker {
+
+private:
+    GlesEnv *mEnv;
+    GLuint mProgramId;
+    GLint mSizeLoc;
+    GLint mRowPixelsLoc;
+    GLint mLayoutLoc;
+    GLint mRgbToYuvLoc;
+
+    // 打包结果，RGBA8
+    GLuint mFboId;
+    GLuint mTextureId;
+    int mTextureWidth;
+    int mTextureHeight;
+
+    // 全屏矩形，顶点与索引
+    GLuint mVboIds[2];
+    GLuint mVaoId;
+
+    // yuv = mat4 * vec4(rgb, 1)，列优先
+    GLfloat mRgbToYuv[16];
+
+    // 最近一次Pack的FBO宽度（像素）、行数与有效字节数
+    int mRowPixels;
+    int mRows;
+    int mDataSize;
+
+    bool ensureProgram();
+
+    void ensureTarget(int width, int height);
+
+public:
+
+    explicit YuvPacker(GlesEnv *env);
+
+    ~YuvPacker();
+
+    /**
+     * RGB转YUV使用的标准与范围，与InputTexture::SetColorSpace互为逆变换
+     * */
+    void SetColorSpace(int standard, bool fullRange);
+
+    /**
+     * 将RGBA纹理左下角width x height的区域打包为YUV或RGB类格式，结束时打包FBO保持绑定
+     *
+     * @param format IMAGE_FORMAT_NV21、IMAGE_FORMAT_NV12、IMAGE_FORMAT_I420，
+     *               或IMAGE_FORMAT_GRAY、IMAGE_FORMAT_RGB565、IMAGE_FORMAT_RGB
+     * @return 程序创建失败或格式不支持时返回false
+     * */
+    bool Pack(GLuint rgbaTexture, int width, int height, int format);
+
+    // 同步读取最近一次Pack的结果，大小为InputTexture::GetDataSize
+    void Read(void *addr);
+
+    // 异步读取最近一次Pack的结果，之后通过reader->Fetch取出
+    void ReadAsync(PboReader *reader);
+
+    // 释放GL资源，需在上下文所在线程调用
+    void Release();
+
+};
+
+#endif //GLLEARNING_YUVPACKER_H
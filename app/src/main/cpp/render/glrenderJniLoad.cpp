@@ -5,27 +5,234 @@
 #include "myutils.h"
 #include <jni.h>
 #include "BgRender.h"
+#include "EngineBenchmark.h"
+#include "RenderThread.h"
+#include "RenderPool.h"
 
 #define LOG_TAG "glrender"
 
 static void
 jni_create(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jobject buffer);
 
+static jboolean
+jni_updateFrame(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jobject buffer);
+
+static void
+jni_createWithFormat(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jint format,
+                     jobject buffer);
+
+static jboolean
+jni_updateFrameWithFormat(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height,
+                          jint format, jobject buffer);
+
+static void
+jni_setYuvColorSpace(JNIEnv *env, jobject obj, jlong ptr, jint standard, jboolean fullRange);
+
+static jboolean jni_setOutputFormat(JNIEnv *env, jobject obj, jlong ptr, jint format);
+
+static jintArray jni_detectBlank(JNIEnv *env, jobject obj, jlong ptr, jint startHeight, jint endHeight);
+
+static jintArray jni_detectMotion(JNIEnv *env, jobject obj, jlong ptr, jobject mask);
+
+static void jni_setMotionThreshold(JNIEnv *env, jobject obj, jlong ptr, jint threshold,
+                                   jint tilePixels);
+
+static void jni_resetMotion(JNIEnv *env, jobject obj, jlong ptr);
+
+static void jni_setStatsEnabled(JNIEnv *env, jobject obj, jlong ptr, jboolean enabled);
+
+static jlongArray jni_getStats(JNIEnv *env, jobject obj, jlong ptr);
+
 static void jni_draw(JNIEnv *env, jobject obj, jlong ptr);
 
-static void jni_getData(JNIEnv *env, jobject obj, jlong ptr, jobject buffer);
+static jboolean jni_getData(JNIEnv *env, jobject obj, jlong ptr, jobject buffer);
+
+static jboolean jni_drawTo(JNIEnv *env, jobject obj, jlong ptr, jobject buffer);
+
+static jboolean
+jni_drawTiled(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jobject input,
+              jobject output, jint tileSize);
+
+static void jni_setAsyncReadback(JNIEnv *env, jobject obj, jlong ptr, jint bufferCount);
+
+static jboolean jni_isDataReady(JNIEnv *env, jobject obj, jlong ptr);
+
+static jboolean jni_addFilter(JNIEnv *env, jobject obj, jlong ptr, jint type, jfloatArray params);
+
+static jint
+jni_addOverlayImage(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jobject buffer,
+                    jboolean premultiplied);
+
+static jboolean
+jni_addOverlay(JNIEnv *env, jobject obj, jlong ptr, jint image, jfloat x, jfloat y, jfloat scale,
+               jfloat opacity, jint blend);
+
+static void jni_clearOverlays(JNIEnv *env, jobject obj, jlong ptr, jboolean clearImages);
+
+static void jni_clearFilters(JNIEnv *env, jobject obj, jlong ptr);
+
+static jint jni_getFilterPassCount(JNIEnv *env, jobject obj, jlong ptr);
+
+static void jni_setFilterComputeEnabled(JNIEnv *env, jobject obj, jlong ptr, jboolean enabled);
+
+static void jni_setEngine(JNIEnv *env, jobject obj, jlong ptr, jint engine);
+
+static void jni_setCpuThreshold(JNIEnv *env, jobject obj, jlong ptr, jint pixelCount);
+
+static jint jni_getLastEngine(JNIEnv *env, jobject obj, jlong ptr);
+
+static void
+jni_setTransform(JNIEnv *env, jobject obj, jlong ptr, jint cropX, jint cropY, jint cropWidth,
+                 jint cropHeight, jint rotate, jint mirror, jint outWidth, jint outHeight);
+
+static jboolean
+jni_setAffineTransform(JNIEnv *env, jobject obj, jlong ptr, jfloatArray matrix, jint outWidth,
+                       jint outHeight);
+
+static void jni_setScaleQuality(JNIEnv *env, jobject obj, jlong ptr, jint quality);
+
+static jboolean
+jni_drawThumbnails(JNIEnv *env, jobject obj, jlong ptr, jintArray sizes, jint quality,
+                   jobject buffer);
+
+static jboolean
+jni_drawRegions(JNIEnv *env, jobject obj, jlong ptr, jintArray rects, jobject buffer);
+
+static jboolean
+jni_drawMultiple(JNIEnv *env, jobject obj, jlong ptr, jintArray outputs, jobject buffer);
+
+static jlong jni_getMultipleDataSize(JNIEnv *env, jobject obj, jlong ptr, jintArray outputs);
+
+static jintArray jni_getOutputSize(JNIEnv *env, jobject obj, jlong ptr);
+
+static jlongArray
+jni_benchmarkEngines(JNIEnv *env, jclass clazz, jint width, jint height, jint rotate,
+                     jint iterations);
 
 static void jni_destroy(JNIEnv *env, jobject obj, jlong ptr);
 
+static void jni_releaseSharedEnv(JNIEnv *env, jclass clazz);
+
+static void jni_setProgramCacheDir(JNIEnv *env, jclass clazz, jstring dir);
+
+static jintArray jni_getProgramCacheStats(JNIEnv *env, jclass clazz);
+
+static void jni_setResultCacheBudget(JNIEnv *env, jclass clazz, jlong bytes);
+
+static void jni_clearResultCache(JNIEnv *env, jclass clazz);
+
+static jlongArray jni_getResultCacheStats(JNIEnv *env, jclass clazz);
+
+static void jni_setBufferPoolBudget(JNIEnv *env, jclass clazz, jlong bytes);
+
+static void jni_trimBufferPool(JNIEnv *env, jclass clazz);
+
+static jlongArray jni_getBufferPoolStats(JNIEnv *env, jclass clazz);
+
+static jlong jni_drawAsync(JNIEnv *env, jobject obj, jlong ptr);
+
+static jlong jni_drawToAsync(JNIEnv *env, jobject obj, jlong ptr, jobject buffer);
+
+static jlong jni_getDataAsync(JNIEnv *env, jobject obj, jlong ptr, jobject buffer);
+
+static jint jni_pollFuture(JNIEnv *env, jclass clazz, jlong handle);
+
+static jint jni_waitFuture(JNIEnv *env, jclass clazz, jlong handle, jlong timeoutMs);
+
+static void jni_releaseFuture(JNIEnv *env, jclass clazz, jlong handle);
+
+static jlong jni_createPool(JNIEnv *env, jclass clazz, jint workerCount);
+
+static jlong
+jni_poolDrawTo(JNIEnv *env, jclass clazz, jlong pool, jint width, jint height, jobject input,
+               jint rotate, jobject output);
+
+static void jni_destroyPool(JNIEnv *env, jclass clazz, jlong pool);
+
+static jdouble
+jni_benchmarkPool(JNIEnv *env, jclass clazz, jint width, jint height, jint workerCount,
+                  jint imageCount);
+
 static const char *bg_render = "cc/appweb/gllearning/componet/BgRender";
 static JNINativeMethod bg_render_methods[] = {
         {"create",         "(JIILjava/nio/ByteBuffer;)V", (void *) jni_create},
+        {"updateFrame",    "(JIILjava/nio/ByteBuffer;)Z", (void *) jni_updateFrame},
+        {"create",         "(JIIILjava/nio/ByteBuffer;)V", (void *) jni_createWithFormat},
+        {"updateFrame",    "(JIIILjava/nio/ByteBuffer;)Z", (void *) jni_updateFrameWithFormat},
+        {"setYuvColorSpace", "(JIZ)V",                  (void *) jni_setYuvColorSpace},
+        {"setOutputFormat", "(JI)Z",                    (void *) jni_setOutputFormat},
+        {"detectBlank",    "(JII)[I",                   (void *) jni_detectBlank},
+        {"detectMotion",   "(JLjava/nio/ByteBuffer;)[I", (void *) jni_detectMotion},
+        {"setMotionThreshold", "(JII)V",                (void *) jni_setMotionThreshold},
+        {"resetMotion",    "(J)V",                      (void *) jni_resetMotion},
+        {"setStatsEnabled", "(JZ)V",                    (void *) jni_setStatsEnabled},
+        {"getStats",       "(J)[J",                     (void *) jni_getStats},
         {"draw",           "(J)V",                      (void *) jni_draw},
-        {"getDrawRawData", "(JLjava/nio/ByteBuffer;)V", (void *) jni_getData},
-        {"destroy",        "(J)V",                      (void *) jni_destroy}
+        {"getDrawRawData", "(JLjava/nio/ByteBuffer;)Z", (void *) jni_getData},
+        {"drawTo",         "(JLjava/nio/ByteBuffer;)Z", (void *) jni_drawTo},
+        {"drawTiled",      "(JIILjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;I)Z", (void *) jni_drawTiled},
+        {"setAsyncReadback", "(JI)V",                   (void *) jni_setAsyncReadback},
+        {"isDataReady",    "(J)Z",                      (void *) jni_isDataReady},
+        {"addFilter",      "(JI[F)Z",                   (void *) jni_addFilter},
+        {"clearFilters",   "(J)V",                      (void *) jni_clearFilters},
+        {"addOverlayImage", "(JIILjava/nio/ByteBuffer;Z)I", (void *) jni_addOverlayImage},
+        {"addOverlay",     "(JIFFFFI)Z",                (void *) jni_addOverlay},
+        {"clearOverlays",  "(JZ)V",                     (void *) jni_clearOverlays},
+        {"getFilterPassCount", "(J)I",                  (void *) jni_getFilterPassCount},
+        {"setFilterComputeEnabled", "(JZ)V",            (void *) jni_setFilterComputeEnabled},
+        {"setEngine",      "(JI)V",                     (void *) jni_setEngine},
+        {"setCpuThreshold", "(JI)V",                    (void *) jni_setCpuThreshold},
+        {"getLastEngine",  "(J)I",                      (void *) jni_getLastEngine},
+        {"setTransform",   "(JIIIIIIII)V",              (void *) jni_setTransform},
+        {"setAffineTransform", "(J[FII)Z",              (void *) jni_setAffineTransform},
+        {"setScaleQuality", "(JI)V",                    (void *) jni_setScaleQuality},
+        {"drawThumbnails", "(J[IILjava/nio/ByteBuffer;)Z", (void *) jni_drawThumbnails},
+        {"drawRegions", "(J[ILjava/nio/ByteBuffer;)Z",  (void *) jni_drawRegions},
+        {"drawMultiple", "(J[ILjava/nio/ByteBuffer;)Z", (void *) jni_drawMultiple},
+        {"getMultipleDataSize", "(J[I)J",               (void *) jni_getMultipleDataSize},
+        {"getOutputSize",  "(J)[I",                     (void *) jni_getOutputSize},
+        {"benchmarkEngines", "(IIII)[J",                (void *) jni_benchmarkEngines},
+        {"destroy",        "(J)V",                      (void *) jni_destroy},
+        {"releaseSharedEnv", "()V",                     (void *) jni_releaseSharedEnv},
+        {"setProgramCacheDir", "(Ljava/lang/String;)V", (void *) jni_setProgramCacheDir},
+        {"getProgramCacheStats", "()[I",                (void *) jni_getProgramCacheStats},
+        {"setResultCacheBudget", "(J)V",                (void *) jni_setResultCacheBudget},
+        {"clearResultCache", "()V",                     (void *) jni_clearResultCache},
+        {"getResultCacheStats", "()[J",                 (void *) jni_getResultCacheStats},
+        {"setBufferPoolBudget", "(J)V",                 (void *) jni_setBufferPoolBudget},
+        {"trimBufferPool", "()V",                       (void *) jni_trimBufferPool},
+        {"getBufferPoolStats", "()[J",                  (void *) jni_getBufferPoolStats},
+        {"drawAsync",      "(J)J",                      (void *) jni_drawAsync},
+        {"drawToAsync",    "(JLjava/nio/ByteBuffer;)J", (void *) jni_drawToAsync},
+        {"getDrawRawDataAsync", "(JLjava/nio/ByteBuffer;)J", (void *) jni_getDataAsync},
+        {"pollFuture",     "(J)I",                      (void *) jni_pollFuture},
+        {"waitFuture",     "(JJ)I",                     (void *) jni_waitFuture},
+        {"releaseFuture",  "(J)V",                      (void *) jni_releaseFuture},
+        {"createPool",     "(I)J",                      (void *) jni_createPool},
+        {"poolDrawTo",     "(JIILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;)J", (void *) jni_poolDrawTo},
+        {"destroyPool",    "(J)V",                      (void *) jni_destroyPool},
+        {"benchmarkPool",  "(IIII)D",                   (void *) jni_benchmarkPool}
 };
 static jfieldID renderPtrField;
 
+/**
+ * 返回给Java的异步任务句柄
+ * 持有输入、输出buffer的全局引用，避免任务完成前buffer被回收
+ * */
+struct JniFuture {
+    RenderFuture *future;
+    jobject buffers[2];
+};
+
+static jlong newJniFuture(JNIEnv *env, RenderFuture *future, jobject buffer,
+                          jobject buffer2 = nullptr) {
+    JniFuture *handle = new JniFuture();
+    handle->future = future;
+    handle->buffers[0] = buffer == nullptr ? nullptr : env->NewGlobalRef(buffer);
+    handle->buffers[1] = buffer2 == nullptr ? nullptr : env->NewGlobalRef(buffer2);
+    return (jlong) handle;
+}
+
 JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
     LOGD(LOG_TAG, "JNI_OnLoad");
     JNIEnv *env;
@@ -49,38 +256,623 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
 
 
 JNIEXPORT void JNI_OnUnload(JavaVM *vm, void *reserved) {
-    LOGD(LOG_TAG, "JNI_OnLoad");
+    LOGD(LOG_TAG, "JNI_OnUnload");
+    RenderThread::Get()->Run([]() {
+        GlesEnv::Terminate();
+        return true;
+    });
 }
 
 static void jni_create(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jobject buffer) {
     LOGD(LOG_TAG, "jni_create");
+    long long start = currentTimeUs();
     if (ptr != 0) {
-        delete (BgRender *)ptr;
+        RenderThread::Get()->Run([ptr]() {
+            BgRender *oldRender = (BgRender *) ptr;
+            oldRender->DestroyGlesEnv();
+            delete oldRender;
+            return true;
+        });
+        env->SetLongField(obj, renderPtrField, (jlong) 0);
     }
     const char *data = (char *)env->GetDirectBufferAddress(buffer);
+    if (data == nullptr || width <= 0 || height <= 0
+        || env->GetDirectBufferCapacity(buffer) < (jlong) width * height * 4) {
+        LOGE(LOG_TAG, "jni_create buffer must be a direct buffer of %lld bytes",
+             (long long) width * height * 4);
+        return;
+    }
     BgRender* render = new BgRender(width, height, data);
-    render->CreateGlesEnv();
+    // GL调用都在渲染线程执行，调用方可以在任意线程
+    RenderThread::Get()->Run([render]() {
+        if (!render->CreateGlesEnv()) {
+            LOGE(LOG_TAG, "jni_create CreateGlesEnv fail, only cpu engine available");
+        }
+        return true;
+    });
     env->SetLongField(obj, renderPtrField, (jlong)render);
+    LOGD(LOG_TAG, "jni_create cost=%lldus", currentTimeUs() - start);
+}
+
+static jboolean
+jni_updateFrame(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jobject buffer) {
+    LOGD(LOG_TAG, "jni_updateFrame");
+    BgRender* render = (BgRender *) ptr;
+    const char *data = (char *)env->GetDirectBufferAddress(buffer);
+    if (render == nullptr || data == nullptr || width <= 0 || height <= 0
+        || env->GetDirectBufferCapacity(buffer) < (jlong) width * height * 4) {
+        LOGE(LOG_TAG, "jni_updateFrame render=%p buffer must be a direct buffer of %lld bytes",
+             render, (long long) width * height * 4);
+        return JNI_FALSE;
+    }
+    return RenderThread::Get()->Run([=]() {
+        return render->UpdateFrame(width, height, data);
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+static void
+jni_createWithFormat(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jint format,
+                     jobject buffer) {
+    LOGD(LOG_TAG, "jni_createWithFormat format=%d", format);
+    long long start = currentTimeUs();
+    if (ptr != 0) {
+        RenderThread::Get()->Run([ptr]() {
+            BgRender *oldRender = (BgRender *) ptr;
+            oldRender->DestroyGlesEnv();
+            delete oldRender;
+            return true;
+        });
+        env->SetLongField(obj, renderPtrField, (jlong) 0);
+    }
+    const char *data = (char *)env->GetDirectBufferAddress(buffer);
+    int size = InputTexture::GetDataSize(format, width, height);
+    if (data == nullptr || size == 0 || env->GetDirectBufferCapacity(buffer) < size) {
+        LOGE(LOG_TAG, "jni_createWithFormat buffer must be a direct buffer of %d bytes", size);
+        return;
+    }
+    BgRender* render = new BgRender(width, height, data, format);
+    RenderThread::Get()->Run([render]() {
+        if (!render->CreateGlesEnv()) {
+            LOGE(LOG_TAG, "jni_createWithFormat CreateGlesEnv fail");
+        }
+        return true;
+    });
+    env->SetLongField(obj, renderPtrField, (jlong)render);
+    LOGD(LOG_TAG, "jni_createWithFormat cost=%lldus", currentTimeUs() - start);
+}
+
+static jboolean
+jni_updateFrameWithFormat(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height,
+                          jint format, jobject buffer) {
+    LOGD(LOG_TAG, "jni_updateFrameWithFormat format=%d", format);
+    BgRender* render = (BgRender *) ptr;
+    const char *data = (char *)env->GetDirectBufferAddress(buffer);
+    int size = InputTexture::GetDataSize(format, width, height);
+    if (render == nullptr || data == nullptr || size == 0
+        || env->GetDirectBufferCapacity(buffer) < size) {
+        LOGE(LOG_TAG, "jni_updateFrameWithFormat render=%p buffer must be a direct buffer of %d bytes",
+             render, size);
+        return JNI_FALSE;
+    }
+    return RenderThread::Get()->Run([=]() {
+        return render->UpdateFrame(width, height, data, format);
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+static void
+jni_setYuvColorSpace(JNIEnv *env, jobject obj, jlong ptr, jint standard, jboolean fullRange) {
+    BgRender* render = (BgRender *) ptr;
+    bool full = fullRange == JNI_TRUE;
+    // 只修改状态，不等待，按提交顺序在之后的绘制前生效
+    RenderThread::Get()->Post([=]() {
+        render->SetYuvColorSpace(standard, full);
+        return true;
+    });
+}
+
+static jboolean jni_setOutputFormat(JNIEnv *env, jobject obj, jlong ptr, jint format) {
+    BgRender* render = (BgRender *) ptr;
+    return RenderThread::Get()->Run([=]() {
+        return render->SetOutputFormat(format);
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+static jintArray jni_detectBlank(JNIEnv *env, jobject obj, jlong ptr, jint startHeight, jint endHeight) {
+    LOGD(LOG_TAG, "jni_detectBlank");
+    BgRender* render = (BgRender *) ptr;
+    jint result[BLANK_RESULT_SIZE];
+    if (render == nullptr || !RenderThread::Get()->Run([&]() {
+        return render->DetectBlank(startHeight, endHeight, result);
+    })) {
+        return nullptr;
+    }
+    jintArray array = env->NewIntArray(BLANK_RESULT_SIZE);
+    env->SetIntArrayRegion(array, 0, BLANK_RESULT_SIZE, result);
+    return array;
+}
+
+static jintArray jni_detectMotion(JNIEnv *env, jobject obj, jlong ptr, jobject mask) {
+    LOGD(LOG_TAG, "jni_detectMotion");
+    BgRender* render = (BgRender *) ptr;
+    const signed char *data = nullptr;
+    jlong capacity = 0;
+    if (mask != nullptr) {
+        data = (signed char *) env->GetDirectBufferAddress(mask);
+        if (data == nullptr) {
+            LOGE(LOG_TAG, "jni_detectMotion mask must be direct");
+            return nullptr;
+        }
+        capacity = env->GetDirectBufferCapacity(mask);
+    }
+    jint result[MOTION_RESULT_SIZE];
+    if (render == nullptr || !RenderThread::Get()->Run([&]() {
+        return render->DetectMotion(result, data, capacity);
+    })) {
+        return nullptr;
+    }
+    jintArray array = env->NewIntArray(MOTION_RESULT_SIZE);
+    env->SetIntArrayRegion(array, 0, MOTION_RESULT_SIZE, result);
+    return array;
+}
+
+static void jni_setMotionThreshold(JNIEnv *env, jobject obj, jlong ptr, jint threshold,
+                                   jint tilePixels) {
+    LOGD(LOG_TAG, "jni_setMotionThreshold threshold=%d tilePixels=%d", threshold, tilePixels);
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([render, threshold, tilePixels]() {
+        render->SetMotionThreshold(threshold, tilePixels);
+        return true;
+    });
+}
+
+static void jni_resetMotion(JNIEnv *env, jobject obj, jlong ptr) {
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([render]() {
+        render->ResetMotion();
+        return true;
+    });
+}
+
+static void jni_setStatsEnabled(JNIEnv *env, jobject obj, jlong ptr, jboolean enabled) {
+    LOGD(LOG_TAG, "jni_setStatsEnabled enabled=%d", enabled);
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([=]() {
+        render->SetStatsEnabled(enabled);
+        return true;
+    });
+}
+
+static jlongArray jni_getStats(JNIEnv *env, jobject obj, jlong ptr) {
+    BgRender* render = (BgRender *) ptr;
+    long long result[STATS_RESULT_SIZE];
+    if (render == nullptr || !RenderThread::Get()->Run([&]() {
+        return render->GetStats(result);
+    })) {
+        return nullptr;
+    }
+    jlong values[STATS_RESULT_SIZE];
+    for (int i = 0; i < STATS_RESULT_SIZE; i++) {
+        values[i] = result[i];
+    }
+    jlongArray array = env->NewLongArray(STATS_RESULT_SIZE);
+    env->SetLongArrayRegion(array, 0, STATS_RESULT_SIZE, values);
+    return array;
+}
+
+// 在渲染线程执行，输出大小在执行时才确定
+static bool drawTo(BgRender *render, const signed char *data, jlong capacity) {
+    if (data == nullptr || capacity < render->GetDataSize()) {
+        LOGE(LOG_TAG, "drawTo buffer must be a direct buffer of %d bytes", render->GetDataSize());
+        return false;
+    }
+    render->DrawTo(data);
+    return true;
+}
+
+// 在渲染线程执行，与drawTo相同
+static bool getData(BgRender *render, const signed char *data, jlong capacity) {
+    if (data == nullptr || capacity < render->GetDataSize()) {
+        LOGE(LOG_TAG, "getData buffer must be a direct buffer of %d bytes", render->GetDataSize());
+        return false;
+    }
+    return render->GetData(data);
 }
 
 static void jni_draw(JNIEnv *env, jobject obj, jlong ptr) {
     LOGD(LOG_TAG, "jni_draw");
     BgRender* render = (BgRender *) ptr;
-    render->Draw();
+    RenderThread::Get()->Run([render]() {
+        render->Draw();
+        return true;
+    });
 }
 
-static void jni_getData(JNIEnv *env, jobject obj, jlong ptr, jobject buffer) {
+static jboolean jni_getData(JNIEnv *env, jobject obj, jlong ptr, jobject buffer) {
     LOGD(LOG_TAG, "jni_getData");
     BgRender* render = (BgRender *) ptr;
     const signed char *data = (signed char *)env->GetDirectBufferAddress(buffer);
-    render->GetData(data);
+    jlong capacity = data == nullptr ? 0 : env->GetDirectBufferCapacity(buffer);
+    return RenderThread::Get()->Run([=]() {
+        return getData(render, data, capacity);
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+static jboolean jni_drawTo(JNIEnv *env, jobject obj, jlong ptr, jobject buffer) {
+    LOGD(LOG_TAG, "jni_drawTo");
+    BgRender* render = (BgRender *) ptr;
+    const signed char *data = (signed char *)env->GetDirectBufferAddress(buffer);
+    jlong capacity = data == nullptr ? 0 : env->GetDirectBufferCapacity(buffer);
+    return RenderThread::Get()->Run([=]() {
+        return drawTo(render, data, capacity);
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+static jboolean
+jni_drawTiled(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jobject input,
+              jobject output, jint tileSize) {
+    LOGD(LOG_TAG, "jni_drawTiled");
+    BgRender* render = (BgRender *) ptr;
+    const char *image = (const char *) env->GetDirectBufferAddress(input);
+    const signed char *data = (signed char *) env->GetDirectBufferAddress(output);
+    if (render == nullptr || image == nullptr || data == nullptr || width <= 0 || height <= 0
+        || env->GetDirectBufferCapacity(input) < (jlong) width * height * 4) {
+        LOGE(LOG_TAG, "jni_drawTiled input must be a direct buffer of %lld bytes",
+             (long long) width * height * 4);
+        return JNI_FALSE;
+    }
+    jlong capacity = env->GetDirectBufferCapacity(output);
+    return RenderThread::Get()->Run([=]() {
+        return render->DrawTiled(width, height, image, data, capacity, tileSize);
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+static void jni_setAsyncReadback(JNIEnv *env, jobject obj, jlong ptr, jint bufferCount) {
+    LOGD(LOG_TAG, "jni_setAsyncReadback");
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([=]() {
+        render->SetAsyncReadback(bufferCount);
+        return true;
+    });
+}
+
+static jboolean jni_isDataReady(JNIEnv *env, jobject obj, jlong ptr) {
+    BgRender* render = (BgRender *) ptr;
+    return RenderThread::Get()->Run([render]() {
+        return render->IsDataReady();
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+static jboolean jni_addFilter(JNIEnv *env, jobject obj, jlong ptr, jint type, jfloatArray params) {
+    LOGD(LOG_TAG, "jni_addFilter type=%d", type);
+    BgRender* render = (BgRender *) ptr;
+    if (params == nullptr) {
+        return RenderThread::Get()->Run([=]() {
+            return render->AddFilter(type, nullptr, 0);
+        }) ? JNI_TRUE : JNI_FALSE;
+    }
+    jsize count = env->GetArrayLength(params);
+    jfloat *values = env->GetFloatArrayElements(params, nullptr);
+    // 同步执行，values在返回前一直有效
+    bool ret = RenderThread::Get()->Run([=]() {
+        return render->AddFilter(type, values, count);
+    });
+    // 只读，不需要写回
+    env->ReleaseFloatArrayElements(params, values, JNI_ABORT);
+    return ret ? JNI_TRUE : JNI_FALSE;
+}
+
+static void jni_clearFilters(JNIEnv *env, jobject obj, jlong ptr) {
+    LOGD(LOG_TAG, "jni_clearFilters");
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([render]() {
+        render->ClearFilters();
+        return true;
+    });
+}
+
+static jint
+jni_addOverlayImage(JNIEnv *env, jobject obj, jlong ptr, jint width, jint height, jobject buffer,
+                    jboolean premultiplied) {
+    LOGD(LOG_TAG, "jni_addOverlayImage");
+    BgRender* render = (BgRender *) ptr;
+    const char *data = (const char *) env->GetDirectBufferAddress(buffer);
+    if (data == nullptr || env->GetDirectBufferCapacity(buffer) < (jlong) width * height * 4) {
+        LOGE(LOG_TAG, "jni_addOverlayImage buffer must be a direct buffer of %d bytes",
+             width * height * 4);
+        return -1;
+    }
+    int image = -1;
+    // 同步执行，上传完成后buffer即可复用
+    RenderThread::Get()->Run([&]() {
+        image = render->AddOverlayImage(width, height, data, premultiplied == JNI_TRUE);
+        return true;
+    });
+    return image;
+}
+
+static jboolean
+jni_addOverlay(JNIEnv *env, jobject obj, jlong ptr, jint image, jfloat x, jfloat y, jfloat scale,
+               jfloat opacity, jint blend) {
+    BgRender* render = (BgRender *) ptr;
+    return RenderThread::Get()->Run([=]() {
+        return render->AddOverlay(image, x, y, scale, opacity, blend);
+    }) ? JNI_TRUE : JNI_FALSE;
+}
+
+static void jni_clearOverlays(JNIEnv *env, jobject obj, jlong ptr, jboolean clearImages) {
+    LOGD(LOG_TAG, "jni_clearOverlays");
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([render, clearImages]() {
+        render->ClearOverlays(clearImages == JNI_TRUE);
+        return true;
+    });
+}
+
+static jint jni_getFilterPassCount(JNIEnv *env, jobject obj, jlong ptr) {
+    BgRender* render = (BgRender *) ptr;
+    int count = 0;
+    RenderThread::Get()->Run([&]() {
+        count = render->GetFilterPassCount();
+        return true;
+    });
+    return count;
+}
+
+static void jni_setFilterComputeEnabled(JNIEnv *env, jobject obj, jlong ptr, jboolean enabled) {
+    LOGD(LOG_TAG, "jni_setFilterComputeEnabled enabled=%d", enabled);
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([render, enabled]() {
+        render->SetFilterComputeEnabled(enabled == JNI_TRUE);
+        return true;
+    });
+}
+
+static void jni_setEngine(JNIEnv *env, jobject obj, jlong ptr, jint engine) {
+    LOGD(LOG_TAG, "jni_setEngine engine=%d", engine);
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([=]() {
+        render->SetEngine(engine);
+        return true;
+    });
+}
+
+static void jni_setCpuThreshold(JNIEnv *env, jobject obj, jlong ptr, jint pixelCount) {
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([=]() {
+        render->SetCpuThreshold(pixelCount);
+        return true;
+    });
+}
+
+static jint jni_getLastEngine(JNIEnv *env, jobject obj, jlong ptr) {
+    BgRender* render = (BgRender *) ptr;
+    int engine = ENGINE_GPU;
+    RenderThread::Get()->Run([&]() {
+        engine = render->GetLastEngine();
+        return true;
+    });
+    return engine;
+}
+
+static void
+jni_setTransform(JNIEnv *env, jobject obj, jlong ptr, jint cropX, jint cropY, jint cropWidth,
+                 jint cropHeight, jint rotate, jint mirror, jint outWidth, jint outHeight) {
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([=]() {
+        render->SetTransform(cropX, cropY, cropWidth, cropHeight, rotate, mirror, outWidth,
+                             outHeight);
+        return true;
+    });
+}
+
+static void jni_setScaleQuality(JNIEnv *env, jobject obj, jlong ptr, jint quality) {
+    LOGD(LOG_TAG, "jni_setScaleQuality quality=%d", quality);
+    BgRender* render = (BgRender *) ptr;
+    RenderThread::Get()->Post([render, quality]() {
+        render->SetScaleQuality(quality);
+        return true;
+    });
+}
+
+static jboolean
+jni_drawThumbnails(JNIEnv *env, jobject obj, jlong ptr, jintArray sizes, jint quality,
+                   jobject buffer) {
+    LOGD(LOG_TAG, "jni_drawThumbnails");
+    BgRender* render = (BgRender *) ptr;
+    const signed char *data = (signed char *) env->GetDirectBufferAddress(buffer);
+    if (sizes == nullptr || data == nullptr || env->GetArrayLength(sizes) % 2 != 0) {
+        LOGE(LOG_TAG, "jni_drawThumbnails sizes must be width/height pairs, buffer must be direct");
+        return JNI_FALSE;
+    }
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    jsize count = env->GetArrayLength(sizes) / 2;
+    jint *values = env->GetIntArrayElements(sizes, nullptr);
+    // 同步执行，values在返回前一直有效
+    bool ret = RenderThread::Get()->Run([=]() {
+        return render->DrawThumbnails(values, count, quality, data, capacity);
+    });
+    env->ReleaseIntArrayElements(sizes, values, JNI_ABORT);
+    return ret ? JNI_TRUE : JNI_FALSE;
+}
+
+static jboolean
+jni_drawRegions(JNIEnv *env, jobject obj, jlong ptr, jintArray rects, jobject buffer) {
+    LOGD(LOG_TAG, "jni_drawRegions");
+    BgRender* render = (BgRender *) ptr;
+    const signed char *data = (signed char *) env->GetDirectBufferAddress(buffer);
+    if (rects == nullptr || data == nullptr || env->GetArrayLength(rects) % 4 != 0) {
+        LOGE(LOG_TAG, "jni_drawRegions rects must be x/y/width/height groups, buffer must be direct");
+        return JNI_FALSE;
+    }
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    jsize count = env->GetArrayLength(rects) / 4;
+    jint *values = env->GetIntArrayElements(rects, nullptr);
+    // 同步执行，values在返回前一直有效
+    bool ret = RenderThread::Get()->Run([=]() {
+        return render->DrawRegions(values, count, data, capacity);
+    });
+    env->ReleaseIntArrayElements(rects, values, JNI_ABORT);
+    return ret ? JNI_TRUE : JNI_FALSE;
+}
+
+static jboolean
+jni_drawMultiple(JNIEnv *env, jobject obj, jlong ptr, jintArray outputs, jobject buffer) {
+    LOGD(LOG_TAG, "jni_drawMultiple");
+    BgRender* render = (BgRender *) ptr;
+    const signed char *data = (signed char *) env->GetDirectBufferAddress(buffer);
+    if (outputs == nullptr || data == nullptr) {
+        LOGE(LOG_TAG, "jni_drawMultiple outputs is null or buffer is not direct");
+        return JNI_FALSE;
+    }
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    jsize count = env->GetArrayLength(outputs);
+    jint *values = env->GetIntArrayElements(outputs, nullptr);
+    // 同步执行，values在返回前一直有效
+    bool ret = RenderThread::Get()->Run([=]() {
+        return render->DrawMultiple(values, count, data, capacity);
+    });
+    env->ReleaseIntArrayElements(outputs, values, JNI_ABORT);
+    return ret ? JNI_TRUE : JNI_FALSE;
+}
+
+static jlong jni_getMultipleDataSize(JNIEnv *env, jobject obj, jlong ptr, jintArray outputs) {
+    BgRender* render = (BgRender *) ptr;
+    if (outputs == nullptr) {
+        return -1;
+    }
+    jsize count = env->GetArrayLength(outputs);
+    jint *values = env->GetIntArrayElements(outputs, nullptr);
+    long long size = -1;
+    RenderThread::Get()->Run([&]() {
+        size = render->GetMultipleDataSize(values, count);
+        return true;
+    });
+    env->ReleaseIntArrayElements(outputs, values, JNI_ABORT);
+    return (jlong) size;
+}
+
+static jboolean
+jni_setAffineTransform(JNIEnv *env, jobject obj, jlong ptr, jfloatArray matrix, jint outWidth,
+                       jint outHeight) {
+    BgRender* render = (BgRender *) ptr;
+    if (matrix == nullptr || env->GetArrayLength(matrix) != TEX_TRANSFORM_SIZE) {
+        LOGE(LOG_TAG, "jni_setAffineTransform matrix must have %d values", TEX_TRANSFORM_SIZE);
+        return JNI_FALSE;
+    }
+    jfloat values[TEX_TRANSFORM_SIZE];
+    env->GetFloatArrayRegion(matrix, 0, TEX_TRANSFORM_SIZE, values);
+    RenderThread::Get()->Run([&]() {
+        render->SetAffineTransform(values, outWidth, outHeight);
+        return true;
+    });
+    return JNI_TRUE;
+}
+
+static jintArray jni_getOutputSize(JNIEnv *env, jobject obj, jlong ptr) {
+    BgRender* render = (BgRender *) ptr;
+    jint size[2];
+    RenderThread::Get()->Run([&]() {
+        render->GetOutputSize((int *) &size[0], (int *) &size[1]);
+        return true;
+    });
+    jintArray result = env->NewIntArray(2);
+    env->SetIntArrayRegion(result, 0, 2, size);
+    return result;
+}
+
+static jlongArray
+jni_benchmarkEngines(JNIEnv *env, jclass clazz, jint width, jint height, jint rotate,
+                     jint iterations) {
+    LOGD(LOG_TAG, "jni_benchmarkEngines");
+    long long result[BENCHMARK_RESULT_COUNT];
+    // 基准测试创建的BgRender同样使用共享环境，需在渲染线程执行
+    RenderThread::Get()->Run([&]() {
+        benchmarkEngines(width, height, rotate, iterations, result);
+        return true;
+    });
+    jlong values[BENCHMARK_RESULT_COUNT];
+    for (int i = 0; i < BENCHMARK_RESULT_COUNT; i++) {
+        values[i] = result[i];
+    }
+    jlongArray array = env->NewLongArray(BENCHMARK_RESULT_COUNT);
+    env->SetLongArrayRegion(array, 0, BENCHMARK_RESULT_COUNT, values);
+    return array;
 }
 
 static void jni_destroy(JNIEnv *env, jobject obj, jlong ptr) {
     LOGD(LOG_TAG, "jni_destroy");
     BgRender* render = (BgRender *) ptr;
-    render->DestroyGlesEnv();
-    delete (BgRender *)ptr;
+    // 排在该实例所有已提交的任务之后
+    RenderThread::Get()->Run([render]() {
+        render->DestroyGlesEnv();
+        delete render;
+        return true;
+    });
+}
+
+static void jni_releaseSharedEnv(JNIEnv *env, jclass clazz) {
+    LOGD(LOG_TAG, "jni_releaseSharedEnv");
+    RenderThread::Get()->Run([]() {
+        GlesEnv::Terminate();
+        return true;
+    });
+}
+
+static void jni_setProgramCacheDir(JNIEnv *env, jclass clazz, jstring dir) {
+    LOGD(LOG_TAG, "jni_setProgramCacheDir");
+    if (dir == nullptr) {
+        GlesEnv::SetProgramCacheDir(nullptr);
+        return;
+    }
+    const char *path = env->GetStringUTFChars(dir, nullptr);
+    GlesEnv::SetProgramCacheDir(path);
+    env->ReleaseStringUTFChars(dir, path);
+}
+
+static jintArray jni_getProgramCacheStats(JNIEnv *env, jclass clazz) {
+    jint stats[PROGRAM_CACHE_STATS_COUNT];
+    GlesEnv::GetProgramCacheStats((int *) stats);
+    jintArray result = env->NewIntArray(PROGRAM_CACHE_STATS_COUNT);
+    env->SetIntArrayRegion(result, 0, PROGRAM_CACHE_STATS_COUNT, stats);
+    return result;
+}
+
+// 结果缓存是进程内共享的，可在任意线程调用，不经过渲染线程
+static void jni_setResultCacheBudget(JNIEnv *env, jclass clazz, jlong bytes) {
+    LOGD(LOG_TAG, "jni_setResultCacheBudget bytes=%lld", (long long) bytes);
+    ResultCache::Get()->SetBudget(bytes);
+}
+
+static void jni_clearResultCache(JNIEnv *env, jclass clazz) {
+    LOGD(LOG_TAG, "jni_clearResultCache");
+    ResultCache::Get()->Clear();
+}
+
+static jlongArray jni_getResultCacheStats(JNIEnv *env, jclass clazz) {
+    long long stats[RESULT_CACHE_STATS_COUNT];
+    ResultCache::Get()->GetStats(stats);
+    jlongArray result = env->NewLongArray(RESULT_CACHE_STATS_COUNT);
+    env->SetLongArrayRegion(result, 0, RESULT_CACHE_STATS_COUNT, (const jlong *) stats);
+    return result;
+}
+
+// 缓冲区池同样是进程内共享的，可在任意线程调用
+static void jni_setBufferPoolBudget(JNIEnv *env, jclass clazz, jlong bytes) {
+    LOGD(LOG_TAG, "jni_setBufferPoolBudget bytes=%lld", (long long) bytes);
+    BufferPool::Get()->SetBudget(bytes);
+}
+
+static void jni_trimBufferPool(JNIEnv *env, jclass clazz) {
+    LOGD(LOG_TAG, "jni_trimBufferPool");
+    BufferPool::Get()->Trim();
+}
+
+static jlongArray jni_getBufferPoolStats(JNIEnv *env, jclass clazz) {
+    long long stats[BUFFER_POOL_STATS_COUNT];
+    BufferPool::Get()->GetStats(stats);
+    jlongArray result = env->NewLongArray(BUFFER_POOL_STATS_COUNT);
+    env->SetLongArrayRegion(result, 0, BUFFER_POOL_STATS_COUNT, (const jlong *) stats);
+    return result;
 }
 
 // 区别其他native方法，该方法使用静态注册
@@ -88,7 +880,10 @@ extern "C" JNIEXPORT void JNICALL
 Java_cc_appweb_gllearning_componet_BgRender_setRotate(JNIEnv *env, jobject thiz, jlong ptr, jint type) {
     LOGD(LOG_TAG, "setRotate");
     BgRender* render = (BgRender *) ptr;
-    render->SetRotate(type);
+    RenderThread::Get()->Post([=]() {
+        render->SetRotate(type);
+        return true;
+    });
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -96,5 +891,126 @@ Java_cc_appweb_gllearning_componet_BgRender_setMirrorType(JNIEnv *env, jobject t
                                                           jint type) {
     LOGD(LOG_TAG, "setMirrorType");
     BgRender* render = (BgRender *) ptr;
-    render->SetMirrorType(type);
-}
\ No newline at end of file
+    RenderThread::Get()->Post([=]() {
+        render->SetMirrorType(type);
+        return true;
+    });
+}
+
+static jlong jni_drawAsync(JNIEnv *env, jobject obj, jlong ptr) {
+    LOGD(LOG_TAG, "jni_drawAsync");
+    BgRender* render = (BgRender *) ptr;
+    RenderFuture *future = RenderThread::Get()->Submit([render]() {
+        render->Draw();
+        return true;
+    });
+    return newJniFuture(env, future, nullptr);
+}
+
+static jlong jni_drawToAsync(JNIEnv *env, jobject obj, jlong ptr, jobject buffer) {
+    LOGD(LOG_TAG, "jni_drawToAsync");
+    BgRender* render = (BgRender *) ptr;
+    const signed char *data = (signed char *)env->GetDirectBufferAddress(buffer);
+    jlong capacity = data == nullptr ? 0 : env->GetDirectBufferCapacity(buffer);
+    RenderFuture *future = RenderThread::Get()->Submit([=]() {
+        return drawTo(render, data, capacity);
+    });
+    return newJniFuture(env, future, buffer);
+}
+
+static jlong jni_getDataAsync(JNIEnv *env, jobject obj, jlong ptr, jobject buffer) {
+    LOGD(LOG_TAG, "jni_getDataAsync");
+    BgRender* render = (BgRender *) ptr;
+    const signed char *data = (signed char *)env->GetDirectBufferAddress(buffer);
+    jlong capacity = data == nullptr ? 0 : env->GetDirectBufferCapacity(buffer);
+    RenderFuture *future = RenderThread::Get()->Submit([=]() {
+        return getData(render, data, capacity);
+    });
+    return newJniFuture(env, future, buffer);
+}
+
+static jint jni_pollFuture(JNIEnv *env, jclass clazz, jlong handle) {
+    JniFuture *jniFuture = (JniFuture *) handle;
+    return jniFuture->future->GetState();
+}
+
+static jint jni_waitFuture(JNIEnv *env, jclass clazz, jlong handle, jlong timeoutMs) {
+    JniFuture *jniFuture = (JniFuture *) handle;
+    return jniFuture->future->Wait(timeoutMs);
+}
+
+static void jni_releaseFuture(JNIEnv *env, jclass clazz, jlong handle) {
+    JniFuture *jniFuture = (JniFuture *) handle;
+    if (jniFuture == nullptr) {
+        return;
+    }
+    if (jniFuture->buffers[0] != nullptr || jniFuture->buffers[1] != nullptr) {
+        // 渲染线程可能还在读写buffer，完成后才能释放全局引用
+        jniFuture->future->Wait(-1);
+    }
+    for (jobject buffer : jniFuture->buffers) {
+        if (buffer != nullptr) {
+            env->DeleteGlobalRef(buffer);
+        }
+    }
+    jniFuture->future->Release();
+    delete jniFuture;
+}
+
+static jlong jni_createPool(JNIEnv *env, jclass clazz, jint workerCount) {
+    LOGD(LOG_TAG, "jni_createPool workerCount=%d", workerCount);
+    RenderPool *pool = new RenderPool(workerCount);
+    int ready = 0;
+    // 工作上下文与共享环境同一share group，共享环境在渲染线程
+    RenderThread::Get()->Run([&]() {
+        ready = pool->Start();
+        return true;
+    });
+    if (ready == 0) {
+        delete pool;
+        return 0;
+    }
+    return (jlong) pool;
+}
+
+static jlong
+jni_poolDrawTo(JNIEnv *env, jclass clazz, jlong pool, jint width, jint height, jobject input,
+               jint rotate, jobject output) {
+    RenderPool *renderPool = (RenderPool *) pool;
+    const char *image = (const char *) env->GetDirectBufferAddress(input);
+    signed char *data = (signed char *) env->GetDirectBufferAddress(output);
+    if (renderPool == nullptr || image == nullptr || data == nullptr
+        || env->GetDirectBufferCapacity(input) < (jlong) width * height * 4
+        || env->GetDirectBufferCapacity(output) < (jlong) width * height * 4) {
+        LOGE(LOG_TAG, "jni_poolDrawTo buffers must be direct buffers of %d bytes",
+             width * height * 4);
+        return 0;
+    }
+    RenderFuture *future = renderPool->SubmitImage(width, height, image, rotate, data);
+    return newJniFuture(env, future, input, output);
+}
+
+static void jni_destroyPool(JNIEnv *env, jclass clazz, jlong pool) {
+    LOGD(LOG_TAG, "jni_destroyPool");
+    RenderPool *renderPool = (RenderPool *) pool;
+    if (renderPool == nullptr) {
+        return;
+    }
+    // 共享环境的引用在渲染线程归还
+    RenderThread::Get()->Run([renderPool]() {
+        delete renderPool;
+        return true;
+    });
+}
+
+static jdouble
+jni_benchmarkPool(JNIEnv *env, jclass clazz, jint width, jint height, jint workerCount,
+                  jint imageCount) {
+    LOGD(LOG_TAG, "jni_benchmarkPool");
+    double result = -1;
+    RenderThread::Get()->Run([&]() {
+        result = benchmarkPool(width, height, workerCount, imageCount);
+        return true;
+    });
+    return result;
+}
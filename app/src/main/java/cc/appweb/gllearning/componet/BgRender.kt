@@ -20,6 +20,286 @@ class BgRender {
         const val MIRROR_NONE = 0
         const val MIRROR_HORIZONTAL = 1
         const val MIRROR_VERTICAL = 2
+
+        // 按图像大小自动选择，小图走CPU
+        const val ENGINE_AUTO = 0
+        const val ENGINE_GPU = 1
+        const val ENGINE_CPU = 2
+
+        // 灰度，无参数
+        const val FILTER_GRAYSCALE = 0
+        // 颜色矩阵，参数同 android.graphics.ColorMatrix.array
+        const val FILTER_COLOR_MATRIX = 1
+        // 亮度/对比度，参数：亮度偏移[-1, 1]，对比度系数（1为不变）
+        const val FILTER_BRIGHTNESS_CONTRAST = 2
+        // 锐化，参数：强度（0为不变）
+        const val FILTER_SHARPEN = 3
+        // 裁剪，参数：x、y、宽、高，单位像素
+        const val FILTER_CROP = 4
+        // 高斯模糊，参数：半径（像素，1~128），sigma（<=0时为半径/3）
+        const val FILTER_GAUSSIAN_BLUR = 5
+        // 均值模糊，参数：半径（像素，1~128）
+        const val FILTER_BOX_BLUR = 6
+        // USM锐化，参数：高斯半径（像素，1~128），强度（0为不变），sigma（<=0时为半径/3）
+        const val FILTER_UNSHARP_MASK = 7
+
+        // 叠加图层的混合方式，颜色按预乘alpha计算
+        // 正常覆盖
+        const val OVERLAY_BLEND_NORMAL = 0
+        // 叠加发光，与正常覆盖可以在同一次绘制中完成
+        const val OVERLAY_BLEND_ADD = 1
+        // 正片叠底
+        const val OVERLAY_BLEND_MULTIPLY = 2
+        // 滤色
+        const val OVERLAY_BLEND_SCREEN = 3
+
+        // 缩放质量
+        // 直接双线性采样，最快，缩小超过2倍时有锯齿
+        const val SCALE_QUALITY_BILINEAR = 0
+        // GPU金字塔 + 双三次
+        const val SCALE_QUALITY_BICUBIC = 1
+        // GPU金字塔 + Lanczos2，边缘更锐利
+        const val SCALE_QUALITY_LANCZOS = 2
+
+        // drawMultiple的输出种类
+        // 变换后的彩色RGBA，每像素4字节
+        const val MULTI_OUTPUT_COLOR = 0
+        // 变换后的灰度，每像素1字节
+        const val MULTI_OUTPUT_GRAY = 1
+        // 彩色RGBA半尺寸预览，宽高为(输出宽高 + 1) / 2
+        const val MULTI_OUTPUT_PREVIEW = 2
+
+        // 输入图像格式
+        const val IMAGE_FORMAT_RGBA = 0
+        const val IMAGE_FORMAT_NV21 = 1
+        const val IMAGE_FORMAT_NV12 = 2
+        const val IMAGE_FORMAT_I420 = 3
+        // 以下只用于输出，见setOutputFormat
+        // 单通道亮度，每像素1字节
+        const val IMAGE_FORMAT_GRAY = 4
+        // 每像素2字节，与Bitmap.Config.RGB_565一致，可直接copyPixelsFromBuffer
+        const val IMAGE_FORMAT_RGB565 = 5
+        // RGB紧密排列，每像素3字节
+        const val IMAGE_FORMAT_RGB = 6
+
+        // YUV转RGB的系数标准
+        const val YUV_STANDARD_BT601 = 0
+        const val YUV_STANDARD_BT709 = 1
+
+        // detectBlank 结果下标
+        // 参与统计的像素数
+        const val BLANK_RESULT_PIXELS = 0
+        // 纯白像素数
+        const val BLANK_RESULT_WHITE = 1
+        // 像素最多的颜色桶的中心颜色，ARGB，比较时最后一个桶不含纯白像素
+        const val BLANK_RESULT_DOMINANT_COLOR = 2
+        // 像素最多的颜色桶的像素数，为最后一个桶时不含纯白像素
+        const val BLANK_RESULT_DOMINANT_COUNT = 3
+        // 之后为BLANK_HISTOGRAM_BINS个颜色桶的像素数，桶下标 = r >> 6 << 4 | g >> 6 << 2 | b >> 6
+        const val BLANK_RESULT_HISTOGRAM = 4
+        // 颜色直方图每通道取高2位，共64个桶
+        const val BLANK_HISTOGRAM_BINS = 64
+
+        // detectMotion 结果下标
+        // 是否与上一帧比较过，第一帧或尺寸、格式变化后为0
+        const val MOTION_RESULT_VALID = 0
+        // 参与比较的像素数
+        const val MOTION_RESULT_PIXELS = 1
+        // 亮度差超过阈值的像素数，变化比例 = 变化像素数 / 像素数
+        const val MOTION_RESULT_CHANGED = 2
+        // 变化区域数
+        const val MOTION_RESULT_REGION_COUNT = 3
+        // 之后为最多16组x、y、宽、高，原点为图像的第一行第一列，按变化像素数从多到少
+        const val MOTION_RESULT_REGIONS = 4
+
+        // getStats 的阶段
+        // 纹理上传
+        const val STATS_STAGE_UPLOAD = 0
+        // 绘制命令提交的CPU耗时，CPU引擎时为整个计算耗时
+        const val STATS_STAGE_DRAW = 1
+        // 绘制在GPU上的执行耗时
+        const val STATS_STAGE_GPU = 2
+        // 读取，同步读取时包含等待GPU
+        const val STATS_STAGE_READBACK = 3
+        // getDrawRawData 拷贝，异步读取时包含等待与映射PBO
+        const val STATS_STAGE_COPY = 4
+        const val STATS_STAGE_COUNT = 5
+
+        // 每个阶段的统计项，单位微秒
+        // 累计样本数
+        const val STATS_FIELD_COUNT = 0
+        const val STATS_FIELD_P50 = 1
+        const val STATS_FIELD_P95 = 2
+        const val STATS_FIELD_P99 = 3
+        // 最近256个样本中的最大值
+        const val STATS_FIELD_MAX = 4
+        const val STATS_FIELD_SIZE = 5
+
+        // getStats 结果下标
+        // GPU阶段的来源，1为GPU计时查询，0为CPU时间戳 + fence等待
+        const val STATS_RESULT_GPU_TIMER = 0
+        // 之后为各阶段的统计项，下标 = STATS_RESULT_STAGES + stage * STATS_FIELD_SIZE + field
+        const val STATS_RESULT_STAGES = 1
+
+        /**
+         * 销毁进程内共享的EGL环境以及缓存的shader程序
+         * 所有BgRender都destroy之后调用才生效，批量任务结束时调用
+         * */
+        @JvmStatic
+        external fun releaseSharedEnv()
+
+        // getProgramCacheStats 结果下标
+        const val PROGRAM_CACHE_HIT = 0
+        const val PROGRAM_CACHE_MISS = 1
+        const val PROGRAM_CACHE_STALE = 2
+
+        /**
+         * 设置shader程序二进制缓存目录，下次启动直接加载，省去编译、链接
+         * 一般传 context.cacheDir 下的子目录，需提前创建；传null关闭
+         * */
+        @JvmStatic
+        external fun setProgramCacheDir(dir: String?)
+
+        /**
+         * 程序缓存统计，下标见 PROGRAM_CACHE_HIT 等
+         * */
+        @JvmStatic
+        external fun getProgramCacheStats(): IntArray
+
+        // getResultCacheStats 结果下标
+        const val RESULT_CACHE_HITS = 0
+        const val RESULT_CACHE_MISSES = 1
+        const val RESULT_CACHE_EVICTIONS = 2
+        const val RESULT_CACHE_ENTRIES = 3
+        const val RESULT_CACHE_BYTES = 4
+        const val RESULT_CACHE_BUDGET = 5
+
+        /**
+         * 设置进程内共享的渲染结果缓存预算，默认关闭
+         * 开启后相同输入像素、相同设置的draw/drawTo直接拷贝缓存的结果，不再渲染；
+         * 异步读取或有叠加图层时不缓存。只对开启之后输入的图像生效
+         *
+         * @param bytes 字节预算，超出时淘汰最久未使用的结果，<=0 关闭并释放
+         * */
+        @JvmStatic
+        external fun setResultCacheBudget(bytes: Long)
+
+        /**
+         * 释放所有缓存的结果，预算不变
+         * */
+        @JvmStatic
+        external fun clearResultCache()
+
+        /**
+         * 结果缓存统计，下标见 RESULT_CACHE_HITS 等
+         * */
+        @JvmStatic
+        external fun getResultCacheStats(): LongArray
+
+        // getBufferPoolStats 结果下标，单位为字节或次数
+        const val BUFFER_POOL_LIVE_BYTES = 0
+        const val BUFFER_POOL_PEAK_BYTES = 1
+        const val BUFFER_POOL_IDLE_BYTES = 2
+        const val BUFFER_POOL_ALLOC_COUNT = 3
+        const val BUFFER_POOL_REUSE_COUNT = 4
+        const val BUFFER_POOL_FAIL_COUNT = 5
+        const val BUFFER_POOL_BUDGET = 6
+
+        /**
+         * 设置native像素缓冲区（读取结果、CPU引擎原图拷贝、结果缓存）的总内存预算，默认不限制
+         * 超出时先释放空闲缓冲区，仍不够时本次绘制失败或不缓存
+         *
+         * @param bytes <=0 不限制
+         * */
+        @JvmStatic
+        external fun setBufferPoolBudget(bytes: Long)
+
+        /**
+         * 释放等待复用的空闲缓冲区，如收到onTrimMemory时
+         * */
+        @JvmStatic
+        external fun trimBufferPool()
+
+        /**
+         * 缓冲区池统计，供内存监控上报，下标见 BUFFER_POOL_LIVE_BYTES 等
+         * */
+        @JvmStatic
+        external fun getBufferPoolStats(): LongArray
+
+        /**
+         * 对比GPU与CPU引擎的单帧耗时（输入图像 + 渲染读取），用于调整 setCpuThreshold
+         *
+         * @param rotate 旋转角度 {@see ROTATE_0}
+         * @return [GPU每帧微秒, CPU每帧微秒]，GPU不可用时为-1
+         * */
+        @JvmStatic
+        external fun benchmarkEngines(width: Int, height: Int, rotate: Int, iterations: Int): LongArray
+
+        // 异步任务状态
+        const val FUTURE_PENDING = 0
+        const val FUTURE_SUCCESS = 1
+        const val FUTURE_FAILED = 2
+
+        /**
+         * 查询异步任务状态，不阻塞
+         *
+         * @param handle drawAsync 等返回的句柄
+         * @return {@see FUTURE_PENDING}
+         * */
+        @JvmStatic
+        external fun pollFuture(handle: Long): Int
+
+        /**
+         * 等待异步任务完成
+         *
+         * @param timeoutMs <0 一直等待
+         * @return 返回时的状态，超时返回 FUTURE_PENDING
+         * */
+        @JvmStatic
+        external fun waitFuture(handle: Long, timeoutMs: Long): Int
+
+        /**
+         * 释放异步任务句柄，每个句柄必须释放一次
+         * 带buffer的任务未完成时会等待其完成，之后buffer才可以复用
+         * */
+        @JvmStatic
+        external fun releaseFuture(handle: Long)
+
+        /**
+         * 创建多上下文并行渲染池，每个工作线程一个共享share group的上下文，各自链接程序
+         *
+         * @param workerCount 工作线程数，一般不超过CPU核数
+         * @return 渲染池指针，创建失败返回0
+         * */
+        @JvmStatic
+        external fun createPool(workerCount: Int): Long
+
+        /**
+         * 向渲染池提交一张RGBA图像（灰度 + 旋转），由空闲的工作线程处理，立即返回
+         *
+         * @param pool createPool返回的指针
+         * @param input DirectByteBuffer，width * height * 4 字节
+         * @param rotate 旋转角度 {@see ROTATE_0}
+         * @param output DirectByteBuffer，width * height * 4 字节，任务完成前不要读写
+         * @return 任务句柄，见 waitFuture、releaseFuture；参数错误时返回0
+         * */
+        @JvmStatic
+        external fun poolDrawTo(pool: Long, width: Int, height: Int, input: ByteBuffer, rotate: Int,
+                                output: ByteBuffer): Long
+
+        /**
+         * 等待已提交的任务完成并销毁渲染池
+         * */
+        @JvmStatic
+        external fun destroyPool(pool: Long)
+
+        /**
+         * 渲染池吞吐测试，对不同的workerCount分别调用，得到吞吐随工作线程数的变化
+         *
+         * @return 每秒处理的图像数，不可用时为-1
+         * */
+        @JvmStatic
+        external fun benchmarkPool(width: Int, height: Int, workerCount: Int, imageCount: Int): Double
     }
 
     private var mNativePtr: Long = 0
@@ -30,28 +310,120 @@ class BgRender {
 
     /**
      * 创建native render
+     * 纹理直接从buffer上传，native层不再拷贝
      *
      * @param ptr native对象指针，默认为0
      * @param width 图像宽
      * @param height 图像高
-     * @param buffer DirectByteBuffer，图像数据
+     * @param buffer DirectByteBuffer，RGBA图像数据，不少于 width * height * 4 字节，否则不创建，指针为0
      * */
     external fun create(ptr: Long, width: Int, height: Int, buffer: ByteBuffer)
 
     /**
-     * 开始渲染
+     * 以指定格式创建native render，YUV直接上传Y、UV平面，在shader中转换为RGB
+     * YUV格式需要GL环境，不支持CPU引擎
+     *
+     * @param format {@see IMAGE_FORMAT_RGBA}
+     * @param buffer DirectByteBuffer，NV21/NV12/I420 为 width * height * 3 / 2 字节
+     * */
+    external fun create(ptr: Long, width: Int, height: Int, format: Int, buffer: ByteBuffer)
+
+    /**
+     * 向已创建的render输入新的一帧，适用于相机、视频等连续帧场景
+     * 尺寸不变时只上传纹理，不会重建EGL环境
+     *
+     * @param ptr native对象指针
+     * @param width 图像宽
+     * @param height 图像高
+     * @param buffer DirectByteBuffer，RGBA图像数据
+     * @return render未创建、buffer不是DirectByteBuffer或不足 width * height * 4 字节时返回false
+     * */
+    external fun updateFrame(ptr: Long, width: Int, height: Int, buffer: ByteBuffer): Boolean
+
+    /**
+     * 输入指定格式的新一帧，可与上一帧格式不同
+     *
+     * @param format {@see IMAGE_FORMAT_RGBA}
+     * @return buffer容量不足或格式未知时返回false
+     * */
+    external fun updateFrame(ptr: Long, width: Int, height: Int, format: Int, buffer: ByteBuffer): Boolean
+
+    /**
+     * YUV输入转RGB使用的标准，默认BT.601全范围（与相机输出一致）
+     *
+     * @param ptr native对象指针
+     * @param standard {@see YUV_STANDARD_BT601}
+     * @param fullRange false为16~235的视频范围
+     * */
+    external fun setYuvColorSpace(ptr: Long, standard: Int, fullRange: Boolean)
+
+    /**
+     * 设置输出格式，NV21/NV12/I420在GPU上完成转换与打包，drawTo读取到的数据可直接送入编码器
+     * YUV输出的字节数为 w * h + ((w + 1) / 2) * ((h + 1) / 2) * 2，颜色标准与setYuvColorSpace一致
+     * 灰度、RGB565、RGB输出同样在GPU上打包，读取与内存分别为RGBA的1/4、1/2、3/4，默认的灰度效果建议用IMAGE_FORMAT_GRAY
+     *
+     * @param ptr native对象指针
+     * @param format {@see IMAGE_FORMAT_RGBA}
+     * @return 格式未知时返回false
+     * */
+    external fun setOutputFormat(ptr: Long, format: Int): Boolean
+
+    /**
+     * 开始渲染，在native渲染线程执行并等待完成，不阻塞的版本见 drawAsync
      *
      * @param ptr native对象指针
      * */
     external fun draw(ptr: Long)
 
+    /**
+     * 渲染并把结果直接读取到buffer，省去native层的中间缓冲区和一次拷贝
+     *
+     * @param ptr native对象指针
+     * @param buffer DirectByteBuffer，容量至少为 width * height * 4
+     * @return buffer不满足要求时返回false
+     * */
+    external fun drawTo(ptr: Long, buffer: ByteBuffer): Boolean
+
+    /**
+     * 分块渲染一张超过纹理尺寸上限的RGBA长图（如整页截图），使用当前的变换与滤镜
+     * 每块只上传其依赖的原图区域，显存占用与图像大小无关；不改变当前帧
+     * 不支持裁剪滤镜与YUV输出
+     *
+     * @param ptr native对象指针
+     * @param width 原图宽
+     * @param height 原图高
+     * @param input DirectByteBuffer，RGBA原图，容量至少为 width * height * 4
+     * @param output DirectByteBuffer，容量至少为按width、height计算的输出尺寸 * 4
+     * @param tileSize 分块边长，<=0时使用默认值1024
+     * @return 参数或当前设置不支持时返回false
+     * */
+    external fun drawTiled(ptr: Long, width: Int, height: Int, input: ByteBuffer, output: ByteBuffer,
+                           tileSize: Int): Boolean
+
     /**
      * 获取绘制好的图像数据
+     * 异步读取模式下取出最早提交的一帧，必要时等待GPU传输完成
      *
      * @param ptr native对象指针
-     * @param buffer DirectByteBuffer，图像数据
+     * @param buffer DirectByteBuffer，图像数据，按当前的输出尺寸与格式分配，不足时返回false
+     * @return 是否取到数据，draw之后输出尺寸或格式变化时返回false，需重新draw
      * */
-    external fun getDrawRawData(ptr: Long, buffer: ByteBuffer)
+    external fun getDrawRawData(ptr: Long, buffer: ByteBuffer): Boolean
+
+    /**
+     * 设置异步读取模式，draw不再等待GPU读取完成
+     *
+     * @param ptr native对象指针
+     * @param bufferCount PBO环形队列长度，<=0 关闭异步读取
+     * */
+    external fun setAsyncReadback(ptr: Long, bufferCount: Int)
+
+    /**
+     * 异步读取模式下，最早提交的一帧是否已可读取，不阻塞
+     *
+     * @param ptr native对象指针
+     * */
+    external fun isDataReady(ptr: Long): Boolean
 
     /**
      * 销毁native对象
@@ -60,6 +432,95 @@ class BgRender {
      * */
     external fun destroy(ptr: Long)
 
+    /**
+     * 追加一个滤镜，设置滤镜后不再使用默认的灰度效果
+     * 相邻的逐像素滤镜（灰度、颜色矩阵、亮度/对比度）合并为一次绘制
+     *
+     * @param ptr native对象指针
+     * @param type 滤镜类型 {@see FILTER_GRAYSCALE}
+     * @param params 滤镜参数，可为null使用默认值
+     * */
+    external fun addFilter(ptr: Long, type: Int, params: FloatArray?): Boolean
+
+    /**
+     * 清空滤镜，恢复默认的灰度效果
+     *
+     * @param ptr native对象指针
+     * */
+    external fun clearFilters(ptr: Long)
+
+    /**
+     * 上传一张叠加图像（水印、贴纸）到图集，同一图像可以被多个图层引用
+     *
+     * @param ptr native对象指针
+     * @param buffer DirectByteBuffer，RGBA，容量至少为 width * height * 4，返回后即可复用
+     * @param premultiplied 是否已预乘alpha，Bitmap.copyPixelsToBuffer 得到的数据为预乘
+     * @return 图像id，图集放不下时返回-1
+     * */
+    external fun addOverlayImage(ptr: Long, width: Int, height: Int, buffer: ByteBuffer,
+                                 premultiplied: Boolean): Int
+
+    /**
+     * 追加一个叠加图层，按追加顺序从下往上混合到输出上，不经过变换与滤镜
+     * 所有图层在一次实例化绘制中完成，只有混合方式切换到正片叠底、滤色时才会多一次绘制
+     *
+     * @param ptr native对象指针
+     * @param image addOverlayImage 返回的图像id
+     * @param x 左上角位置，单位为输出像素
+     * @param scale 相对图像原始尺寸的缩放
+     * @param opacity 不透明度[0, 1]
+     * @param blend {@see OVERLAY_BLEND_NORMAL}
+     * */
+    external fun addOverlay(ptr: Long, image: Int, x: Float, y: Float, scale: Float, opacity: Float,
+                            blend: Int): Boolean
+
+    /**
+     * 清空叠加图层
+     *
+     * @param ptr native对象指针
+     * @param clearImages 同时清空已上传的图像
+     * */
+    external fun clearOverlays(ptr: Long, clearImages: Boolean)
+
+    /**
+     * 当前滤镜链合并后的绘制次数
+     *
+     * @param ptr native对象指针
+     * */
+    external fun getFilterPassCount(ptr: Long): Int
+
+    /**
+     * 模糊等卷积滤镜是否允许使用计算着色器，默认允许，关闭后使用片元着色器，用于对比两条路径
+     * 不支持OpenGL ES 3.1时总是使用片元着色器
+     *
+     * @param ptr native对象指针
+     * */
+    external fun setFilterComputeEnabled(ptr: Long, enabled: Boolean)
+
+    /**
+     * 选择渲染引擎，CPU引擎只支持默认灰度 + 变换（旋转/镜像/裁剪/缩放）
+     * 大图切换到 ENGINE_CPU 后需调用 updateFrame 重新输入图像
+     *
+     * @param ptr native对象指针
+     * @param engine {@see ENGINE_AUTO}
+     * */
+    external fun setEngine(ptr: Long, engine: Int)
+
+    /**
+     * 自动模式下走CPU的像素数阈值，默认 256 * 256
+     *
+     * @param ptr native对象指针
+     * @param pixelCount 像素数
+     * */
+    external fun setCpuThreshold(ptr: Long, pixelCount: Int)
+
+    /**
+     * 最近一次绘制使用的引擎，ENGINE_GPU 或 ENGINE_CPU
+     *
+     * @param ptr native对象指针
+     * */
+    external fun getLastEngine(ptr: Long): Int
+
     /**
      * 设置旋转角度
      * @param ptr native对象指针
@@ -74,4 +535,163 @@ class BgRender {
      * */
     external fun setMirrorType(ptr: Long, type: Int);
 
+    /**
+     * 设置组合变换：先裁剪，再旋转，再镜像，最后缩放到输出尺寸，在一次绘制中完成
+     * 与setRotate/setMirrorType不同，旋转与镜像可以同时生效
+     *
+     * @param ptr native对象指针
+     * @param cropX 裁剪区域，单位为像素，宽或高<=0时不裁剪
+     * @param rotate 旋转角度 {@see ROTATE_0}
+     * @param mirror 镜像类型 {@see MIRROR_NONE}
+     * @param outWidth 输出尺寸，<=0时使用变换后的尺寸（旋转90/270度时宽高互换）
+     * */
+    external fun setTransform(ptr: Long, cropX: Int, cropY: Int, cropWidth: Int, cropHeight: Int,
+                              rotate: Int, mirror: Int, outWidth: Int, outHeight: Int)
+
+    /**
+     * 直接设置仿射变换，(u, v)为输出图像的归一化坐标，(s, t)为原图的采样坐标：
+     * s = m[0] * u + m[1] * v + m[2]，t = m[3] * u + m[4] * v + m[5]
+     *
+     * @param ptr native对象指针
+     * @param matrix 6个值，2x3行优先
+     * @param outWidth 输出尺寸，<=0时与原图一致
+     * @return matrix长度不为6时返回false
+     * */
+    external fun setAffineTransform(ptr: Long, matrix: FloatArray, outWidth: Int, outHeight: Int): Boolean
+
+    /**
+     * 设置缩放质量，缩小超过2倍时先在GPU上逐级减半，再重采样到准确尺寸，代替CPU缩放
+     *
+     * @param ptr native对象指针
+     * @param quality {@see SCALE_QUALITY_BILINEAR}
+     * */
+    external fun setScaleQuality(ptr: Long, quality: Int)
+
+    /**
+     * 一次上传生成多个缩略图，使用当前的裁剪、旋转、镜像与滤镜，金字塔只建一次
+     *
+     * @param ptr native对象指针
+     * @param sizes 依次为每个缩略图的宽、高
+     * @param quality {@see SCALE_QUALITY_BILINEAR}
+     * @param buffer DirectByteBuffer，各缩略图的RGBA数据依次排列，容量至少为 sum(宽 * 高 * 4)
+     * @return 参数或当前设置不支持时返回false
+     * */
+    external fun drawThumbnails(ptr: Long, sizes: IntArray, quality: Int, buffer: ByteBuffer): Boolean
+
+    /**
+     * 只渲染并读取输出中的若干矩形区域，结果与整图渲染后截取一致，多个小区域只等待一次GPU
+     *
+     * @param ptr native对象指针
+     * @param rects 依次为每个区域的x、y、宽、高，单位为输出像素，原点为输出数据的第一行第一列
+     * @param buffer DirectByteBuffer，各区域的RGBA数据紧密排列、依次存放，容量至少为 sum(宽 * 高 * 4)
+     * @return 区域超出输出范围、输出格式不是RGBA或有裁剪滤镜时返回false
+     * */
+    external fun drawRegions(ptr: Long, rects: IntArray, buffer: ByteBuffer): Boolean
+
+    /**
+     * 一次上传、一次绘制得到多个派生结果（彩色、灰度、半尺寸预览），代替多个渲染器分别上传绘制
+     * 使用当前的变换与缩放质量，不经过滤镜与叠加图层
+     *
+     * @param ptr native对象指针
+     * @param outputs {@see MULTI_OUTPUT_COLOR}，按顺序输出
+     * @param buffer DirectByteBuffer，各结果紧密排列、依次存放，容量至少为getMultipleDataSize
+     * @return 种类无效或容量不足时返回false
+     * */
+    external fun drawMultiple(ptr: Long, outputs: IntArray, buffer: ByteBuffer): Boolean
+
+    /**
+     * drawMultiple按当前变换输出的总字节数
+     *
+     * @param ptr native对象指针
+     * @return 种类无效时返回-1
+     * */
+    external fun getMultipleDataSize(ptr: Long, outputs: IntArray): Long
+
+    /**
+     * 输出图像的宽高，变换与裁剪滤镜都会改变输出尺寸
+     *
+     * @param ptr native对象指针
+     * @return [宽, 高]
+     * */
+    external fun getOutputSize(ptr: Long): IntArray
+
+    /**
+     * 白屏检测，在GPU上统计原图指定行范围的颜色直方图与纯白像素数，不受变换与滤镜影响
+     * 需要OpenGL ES 3.1
+     *
+     * @param ptr native对象指针
+     * @param startHeight 起始行（包含），从图像顶部开始
+     * @param endHeight 结束行（不包含）
+     * @return 统计结果，下标见 BLANK_RESULT_PIXELS 等；不支持计算着色器或行范围为空时返回null
+     * */
+    external fun detectBlank(ptr: Long, startHeight: Int, endHeight: Int): IntArray?
+
+    /**
+     * 运动检测，在GPU上比较当前帧与上一次检测时的帧，不受变换与滤镜影响，之后当前帧成为上一帧
+     * 上一帧常驻GPU，默认只读回变化区域与变化像素数；流式输入时每次updateFrame后调用一次
+     *
+     * @param ptr native对象指针
+     * @param mask 为null时不读取掩码；否则为DirectByteBuffer，容量至少为原图宽 * 高，变化像素为255
+     * @return 统计结果，下标见 MOTION_RESULT_VALID 等；没有GL环境或mask容量不足时返回null
+     * */
+    external fun detectMotion(ptr: Long, mask: ByteBuffer?): IntArray?
+
+    /**
+     * 设置运动检测的阈值
+     *
+     * @param ptr native对象指针
+     * @param threshold 亮度差超过该值视为变化，0~255，默认25
+     * @param tilePixels 16x16分块中变化像素少于该值时视为噪点，不计入区域，默认8
+     * */
+    external fun setMotionThreshold(ptr: Long, threshold: Int, tilePixels: Int)
+
+    /**
+     * 丢弃运动检测保存的上一帧，如切换摄像头后
+     *
+     * @param ptr native对象指针
+     * */
+    external fun resetMotion(ptr: Long)
+
+    /**
+     * 开启或关闭分阶段耗时统计，关闭时清空已有样本，未开启时几乎没有开销
+     * 设备不支持GPU计时查询时，GPU阶段通过fence等待计时，开启期间绘制会变为同步
+     *
+     * @param ptr native对象指针
+     * */
+    external fun setStatsEnabled(ptr: Long, enabled: Boolean)
+
+    /**
+     * 读取耗时统计，分位数按每个阶段最近256个样本计算
+     *
+     * @param ptr native对象指针
+     * @return 下标见 STATS_RESULT_GPU_TIMER 等；未开启统计时返回null
+     * */
+    external fun getStats(ptr: Long): LongArray?
+
+    /**
+     * 提交一次绘制，立即返回，不等待GPU
+     * 所有native调用都在同一个native渲染线程按提交顺序执行，可以在任意线程调用
+     *
+     * @param ptr native对象指针
+     * @return 任务句柄，见 pollFuture、waitFuture，用完需 releaseFuture
+     * */
+    external fun drawAsync(ptr: Long): Long
+
+    /**
+     * 提交一次绘制并读取到buffer，立即返回
+     * 任务完成前不要读写buffer，buffer容量不足时任务状态为 FUTURE_FAILED
+     *
+     * @param buffer DirectByteBuffer
+     * @return 任务句柄
+     * */
+    external fun drawToAsync(ptr: Long, buffer: ByteBuffer): Long
+
+    /**
+     * 提交一次读取，排在之前提交的绘制之后，立即返回
+     *
+     * @param buffer DirectByteBuffer
+     * @return 任务句柄，没有可读取的数据时任务状态为 FUTURE_FAILED
+     * */
+    external fun getDrawRawDataAsync(ptr: Long, buffer: ByteBuffer): Long
+
 }
\ No newline at end of file